@@ -8,19 +8,24 @@
 
 #include <iostream>
 #include <atomic>
+#include <algorithm>
 #include <cassert>
+#include <mutex>
 #include <vector>
 
 #include "JArrowMetrics.h"
 #include <JANA/JLogger.h>
 #include <JANA/JException.h>
+#include <JANA/Utils/JLatencyHistogram.h>
 
 class JArrow {
 
 public:
     enum class Status { Unopened, Running, Paused, Finished };
     enum class NodeType {Source, Sink, Stage, Group};
-    enum class BackoffStrategy { Constant, Linear, Exponential };
+    /// Park blocks the worker on the arrow's input queue until something gets pushed, rather than sleeping.
+    /// When the arrow can't park (it has no input queue, or nobody upstream is running), Park behaves like Exponential.
+    enum class BackoffStrategy { Constant, Linear, Exponential, Park };
     using duration_t = std::chrono::steady_clock::duration;
 
 private:
@@ -28,24 +33,43 @@ private:
     const std::string m_name;     // Used for human understanding
     const bool m_is_parallel;     // Whether or not it is safe to parallelize
     const NodeType m_type;
-    JArrowMetrics m_metrics;      // Performance information accumulated over all workers
 
-    // Knobs
-    size_t m_chunksize = 1;       // Number of items to pop off the input queue at once
-    BackoffStrategy m_backoff_strategy = BackoffStrategy::Exponential;
-    duration_t m_initial_backoff_time = std::chrono::microseconds(1);
-    duration_t m_checkin_time = std::chrono::milliseconds(500);
-    unsigned m_backoff_tries = 4;
+    // Performance information, one JArrowMetrics per worker so that workers never write to a shared cache line.
+    // Allocated in blocks as workers first show up. Blocks never move, so readers can walk them while workers write.
+    static constexpr size_t METRICS_BLOCK_SIZE = 64;
+    static constexpr size_t METRICS_MAX_BLOCKS = 64;
+    std::atomic<JArrowMetrics*> m_worker_metrics[METRICS_MAX_BLOCKS] {};
+    std::atomic_size_t m_worker_metrics_count {0};   // Highest worker id seen so far, plus one
+    std::atomic<duration_t> m_last_latency_per_message {duration_t::zero()};  // Published for the scheduler
+    JLatencyHistogram m_latency_histogram;            // Per message, recorded by subclasses which know what a message is
 
-    mutable std::mutex m_arrow_mutex;  // Protects access to arrow properties, except m_status
+    // Knobs
+    // These are atomic because workers read them on every iteration, and a lock would make them contend
+    std::atomic_size_t m_chunksize {1};       // Number of items to pop off the input queue at once
+    std::atomic<BackoffStrategy> m_backoff_strategy {BackoffStrategy::Exponential};
+    std::atomic<duration_t> m_initial_backoff_time {std::chrono::microseconds(1)};
+    std::atomic<duration_t> m_checkin_time {std::chrono::milliseconds(500)};
+    std::atomic_uint m_backoff_tries {4};
+
+    // Adaptive chunk sizing. See tune_chunksize()
+    std::atomic_bool m_adaptive_chunksize {false};
+    size_t m_min_chunksize = 1;
+    size_t m_max_chunksize = 1;
+    size_t m_chunksize_changes = 0;
+    size_t m_tuning_message_count = 0;  // Accumulated since the previous tuning step
+    duration_t m_tuning_latency = duration_t::zero();
+    duration_t m_tuning_queue_latency = duration_t::zero();
+
+    mutable std::mutex m_arrow_mutex;  // Protects the adaptive chunk sizing state
     std::atomic<Status> m_status {Status::Unopened};
 
     // Scheduler stats
-    // These are protected by the Topology mutex, NOT the Arrow mutex!!!
-    int64_t m_thread_count = 0;            // Current number of threads assigned to this arrow
+    // These are atomic so that schedulers may read and update them without holding any lock
+    std::atomic_int64_t m_thread_count {0};            // Current number of threads assigned to this arrow
     std::atomic_int64_t m_running_upstreams {0};       // Current number of running arrows immediately upstream
     std::atomic_int64_t* m_running_arrows = nullptr;   // Current number of running arrows total, so we can detect pauses
     std::vector<JArrow *> m_listeners;     // Downstream Arrows
+    std::vector<JArrow *> m_upstreams;     // Upstream Arrows, so that parked workers know whether anyone is producing
 
 protected:
     // This is usable by subclasses.
@@ -68,68 +92,199 @@ public:
     }
 
     void set_chunksize(size_t chunksize) {
-        std::lock_guard<std::mutex> lock(m_arrow_mutex);
-        m_chunksize = chunksize;
+        m_chunksize.store(chunksize, std::memory_order_relaxed);
     }
 
     size_t get_chunksize() const {
+        return m_chunksize.load(std::memory_order_relaxed);
+    }
+
+    /// set_adaptive_chunksize() lets tune_chunksize() move the chunksize anywhere within [min, max].
+    /// The current chunksize is clamped into that range and serves as the starting point.
+    void set_adaptive_chunksize(bool enabled, size_t min_chunksize, size_t max_chunksize) {
         std::lock_guard<std::mutex> lock(m_arrow_mutex);
-        return m_chunksize;
+        if (min_chunksize == 0 || min_chunksize > max_chunksize) {
+            throw JException("Invalid chunksize bounds [%zu, %zu] for arrow '%s'", min_chunksize, max_chunksize, m_name.c_str());
+        }
+        m_min_chunksize = min_chunksize;
+        m_max_chunksize = max_chunksize;
+        m_chunksize = std::min(std::max(m_chunksize.load(), min_chunksize), max_chunksize);
+        // Whatever ran before doesn't say anything about the new bounds
+        m_tuning_message_count = 0;
+        m_tuning_latency = duration_t::zero();
+        m_tuning_queue_latency = duration_t::zero();
+        m_adaptive_chunksize = enabled;
     }
 
-    void set_backoff_tries(unsigned backoff_tries) {
+    bool is_chunksize_adaptive() const {
+        return m_adaptive_chunksize;
+    }
+
+    size_t get_chunksize_changes() const {
         std::lock_guard<std::mutex> lock(m_arrow_mutex);
-        m_backoff_tries = backoff_tries;
+        return m_chunksize_changes;
+    }
+
+    /// tune_chunksize() adjusts an adaptive chunksize, given the metrics a worker is about to hand in, i.e. what it
+    /// measured since its previous check-in. Once enough has been measured, chunks double while visiting the queues
+    /// costs more than a tenth of the time spent on the events themselves, and halve once that overhead drops below
+    /// a fiftieth, or once a whole chunk takes so long that a few workers could end up with all of the remaining
+    /// events.
+    void tune_chunksize(const JArrowMetrics& interval) {
+        if (!m_adaptive_chunksize) return;
+        std::unique_lock<std::mutex> lock(m_arrow_mutex, std::try_to_lock);
+        if (!lock.owns_lock()) return;  // Another worker is already tuning. Losing one interval doesn't matter.
+
+        const double max_overhead_frac = 0.1;
+        const double min_overhead_frac = 0.02;
+        const duration_t max_chunk_latency = std::chrono::milliseconds(10);
+
+        m_tuning_message_count += interval.get_total_message_count();
+        m_tuning_latency += interval.get_total_latency();
+        m_tuning_queue_latency += interval.get_total_queue_latency();
+
+        size_t chunksize = m_chunksize.load(std::memory_order_relaxed);
+        size_t message_count = m_tuning_message_count;
+        if (message_count < std::max<size_t>(16, 4*chunksize)) return;  // Not enough to go on yet
+
+        auto latency = m_tuning_latency;
+        auto queue_latency = m_tuning_queue_latency;
+        m_tuning_message_count = 0;
+        m_tuning_latency = duration_t::zero();
+        m_tuning_queue_latency = duration_t::zero();
+        if (latency + queue_latency <= duration_t::zero()) return;
+
+        double overhead_frac = std::chrono::duration<double>(queue_latency).count() /
+                               std::chrono::duration<double>(latency + queue_latency).count();
+        auto chunk_latency = latency * chunksize / message_count;
+
+        size_t new_chunksize = chunksize;
+        if (chunk_latency > max_chunk_latency || overhead_frac < min_overhead_frac) {
+            new_chunksize = std::max(m_min_chunksize, chunksize / 2);
+        }
+        else if (overhead_frac > max_overhead_frac) {
+            new_chunksize = std::min(m_max_chunksize, chunksize * 2);
+        }
+        if (new_chunksize != chunksize) {
+            LOG_DEBUG(m_logger) << "JArrow '" << m_name << "': chunksize " << chunksize << " => " << new_chunksize
+                                << " (queue overhead " << overhead_frac << ", chunk latency "
+                                << std::chrono::duration<double, std::milli>(chunk_latency).count() << " ms)" << LOG_END;
+            m_chunksize.store(new_chunksize, std::memory_order_relaxed);
+            m_chunksize_changes++;
+        }
+    }
+
+    void set_backoff_tries(unsigned backoff_tries) {
+        m_backoff_tries.store(backoff_tries, std::memory_order_relaxed);
     }
 
     unsigned get_backoff_tries() const {
-        std::lock_guard<std::mutex> lock(m_arrow_mutex);
-        return m_backoff_tries;
+        return m_backoff_tries.load(std::memory_order_relaxed);
     }
 
     BackoffStrategy get_backoff_strategy() const {
-        std::lock_guard<std::mutex> lock(m_arrow_mutex);
-        return m_backoff_strategy;
+        return m_backoff_strategy.load(std::memory_order_relaxed);
     }
 
     void set_backoff_strategy(BackoffStrategy backoff_strategy) {
-        std::lock_guard<std::mutex> lock(m_arrow_mutex);
-        m_backoff_strategy = backoff_strategy;
+        m_backoff_strategy.store(backoff_strategy, std::memory_order_relaxed);
     }
 
     duration_t get_initial_backoff_time() const {
-        std::lock_guard<std::mutex> lock(m_arrow_mutex);
-        return m_initial_backoff_time;
+        return m_initial_backoff_time.load(std::memory_order_relaxed);
     }
 
     void set_initial_backoff_time(const duration_t& initial_backoff_time) {
-        std::lock_guard<std::mutex> lock(m_arrow_mutex);
-        m_initial_backoff_time = initial_backoff_time;
+        m_initial_backoff_time.store(initial_backoff_time, std::memory_order_relaxed);
     }
 
-    const duration_t& get_checkin_time() const {
-        std::lock_guard<std::mutex> lock(m_arrow_mutex);
-        return m_checkin_time;
+    duration_t get_checkin_time() const {
+        return m_checkin_time.load(std::memory_order_relaxed);
     }
 
     void set_checkin_time(const duration_t& checkin_time) {
-        std::lock_guard<std::mutex> lock(m_arrow_mutex);
-        m_checkin_time = checkin_time;
+        m_checkin_time.store(checkin_time, std::memory_order_relaxed);
     }
 
     void update_thread_count(int thread_count_delta) {
-        std::lock_guard<std::mutex> lock(m_arrow_mutex);
-        m_thread_count += thread_count_delta;
+        int64_t new_count = (m_thread_count += thread_count_delta);
+        if (new_count == 0 && thread_count_delta < 0) {
+            // Nobody is producing for our listeners anymore, so they shouldn't stay parked waiting for us
+            for (auto listener : m_listeners) listener->unpark();
+        }
     }
 
     size_t get_thread_count() {
-        std::lock_guard<std::mutex> lock(m_arrow_mutex);
         return m_thread_count;
     }
 
-    // TODO: Metrics should be encapsulated so that only actions are to update, clear, or summarize
-    JArrowMetrics& get_metrics() {
-        return m_metrics;
+    /// Atomically adds a thread to this arrow, unless the arrow is sequential and already has one.
+    /// Returns whether the thread was added. This lets a scheduler claim a sequential arrow without a lock.
+    bool try_acquire_thread() {
+        if (m_is_parallel) {
+            m_thread_count++;
+            return true;
+        }
+        int64_t expected = 0;
+        return m_thread_count.compare_exchange_strong(expected, 1);
+    }
+
+    /// get_metrics(worker_id) is the given worker's own JArrowMetrics for this arrow. Only that worker may write
+    /// to it, but anybody may read it.
+    JArrowMetrics& get_metrics(size_t worker_id) {
+        size_t block_id = worker_id / METRICS_BLOCK_SIZE;
+        if (block_id >= METRICS_MAX_BLOCKS) {
+            throw JException("Arrow '%s' can't keep metrics for worker %zu", m_name.c_str(), worker_id);
+        }
+        JArrowMetrics* block = m_worker_metrics[block_id].load(std::memory_order_acquire);
+        if (block == nullptr) {
+            auto new_block = new JArrowMetrics[METRICS_BLOCK_SIZE];
+            if (m_worker_metrics[block_id].compare_exchange_strong(block, new_block, std::memory_order_acq_rel)) {
+                block = new_block;
+            }
+            else {
+                delete[] new_block;  // Somebody else got there first
+            }
+        }
+        size_t count = m_worker_metrics_count.load(std::memory_order_relaxed);
+        while (count <= worker_id &&
+               !m_worker_metrics_count.compare_exchange_weak(count, worker_id + 1, std::memory_order_relaxed));
+        return block[worker_id % METRICS_BLOCK_SIZE];
+    }
+
+    /// hand_in_metrics() moves what a worker measured during its latest assignment into its own slot. It also
+    /// publishes the latest latency per message, so that the scheduler can read it on every checkin without
+    /// summing up every worker's slot.
+    void hand_in_metrics(size_t worker_id, JArrowMetrics& metrics) {
+        auto latency = metrics.get_last_latency_per_message();
+        if (latency > duration_t::zero()) {
+            m_last_latency_per_message.store(latency, std::memory_order_relaxed);
+        }
+        get_metrics(worker_id).take(metrics);
+    }
+
+    /// get_last_latency_per_message() is what the most recent hand_in_metrics() measured, or zero before then
+    duration_t get_last_latency_per_message() const {
+        return m_last_latency_per_message.load(std::memory_order_relaxed);
+    }
+
+    /// get_metrics() sums up every worker's metrics for this arrow, without stopping any of them
+    const JArrowMetrics get_metrics() const {
+        JArrowMetrics sum;
+        size_t count = m_worker_metrics_count.load(std::memory_order_relaxed);
+        for (size_t worker_id=0; worker_id<count; ++worker_id) {
+            auto block = m_worker_metrics[worker_id / METRICS_BLOCK_SIZE].load(std::memory_order_acquire);
+            if (block != nullptr) {
+                sum.update(block[worker_id % METRICS_BLOCK_SIZE]);
+            }
+        }
+        return sum;
+    }
+
+    /// get_latency_histogram() holds the time taken by each message, e.g. each event, as opposed to each chunk.
+    /// Arrows whose messages have a meaningful latency of their own record into it themselves.
+    JLatencyHistogram& get_latency_histogram() {
+        return m_latency_histogram;
     }
 
     NodeType get_type() {
@@ -138,11 +293,13 @@ public:
 
     JArrow(std::string name, bool is_parallel, NodeType arrow_type, size_t chunksize=16) :
             m_name(std::move(name)), m_is_parallel(is_parallel), m_type(arrow_type), m_chunksize(chunksize) {
-
-        m_metrics.clear();
     };
 
-    virtual ~JArrow() = default;
+    virtual ~JArrow() {
+        for (auto& block : m_worker_metrics) {
+            delete[] block.load();
+        }
+    }
 
     virtual void initialize() { };
 
@@ -156,6 +313,23 @@ public:
 
     virtual void set_threshold(size_t /* threshold */) {}
 
+    /// park() blocks the calling worker until this arrow's input queue receives something, unpark() is called,
+    /// or the timeout expires, and then returns true. Arrows without an input queue return false immediately,
+    /// meaning that the worker should fall back to sleeping.
+    virtual bool park(duration_t /* timeout */, size_t /* location_id */) { return false; }
+
+    /// unpark() releases every worker parked on this arrow
+    virtual void unpark() {}
+
+    /// Parking only makes sense while some upstream arrow is being executed; otherwise nothing will ever be
+    /// pushed and the worker should check in with the scheduler instead.
+    bool has_active_upstream() const {
+        for (auto upstream : m_upstreams) {
+            if (upstream->m_thread_count > 0) return true;
+        }
+        return false;
+    }
+
 
 
 
@@ -182,6 +356,12 @@ public:
         //     LOG_DEBUG(m_logger) << "Arrow '" << m_name << "' run() : " << status << " => " << status << LOG_END;
         //     return;
         // }
+        if (status == Status::Running) {
+            // Already activated via a different upstream, e.g. when several source arrows feed the same queue.
+            // Counting it again would keep the topology from ever noticing that it has finished.
+            LOG_DEBUG(m_logger) << "Arrow '" << m_name << "' run() : " << status << " => " << status << LOG_END;
+            return;
+        }
         LOG_DEBUG(m_logger) << "Arrow '" << m_name << "' run() : " << status << " => Running" << LOG_END;
         if (m_running_arrows != nullptr) (*m_running_arrows)++;
         for (auto listener: m_listeners) {
@@ -199,8 +379,10 @@ public:
         }
         LOG_DEBUG(m_logger) << "JArrow '" << m_name << "' pause() : " << status << " => Paused" << LOG_END;
         if (m_running_arrows != nullptr) (*m_running_arrows)--;
+        unpark();
         for (auto listener: m_listeners) {
             listener->m_running_upstreams--;
+            listener->unpark();
             // listener->pause();
             // This is NOT a sufficient condition for pausing downstream listeners.
             // What we need is zero running upstreams AND zero messages in queue AND zero threads currently processing
@@ -219,8 +401,10 @@ public:
         // }
         if (old_status == Status::Running) {
             if (m_running_arrows != nullptr) (*m_running_arrows)--;
+            unpark();
             for (auto listener: m_listeners) {
                 listener->m_running_upstreams--;
+                listener->unpark();
             }
         }
         if (old_status != Status::Finished) {
@@ -232,8 +416,13 @@ public:
 
     void attach(JArrow* downstream) {
         m_listeners.push_back(downstream);
+        downstream->m_upstreams.push_back(this);
     };
 
+    const std::vector<JArrow*>& get_listeners() const {
+        return m_listeners;
+    }
+
 };
 
 
@@ -1,109 +1,114 @@
-
 // Copyright 2020, Jefferson Science Associates, LLC.
 // Subject to the terms in the LICENSE file found in the top-level directory.
 
 #ifndef JANA2_JARROWMETRIC_H
 #define JANA2_JARROWMETRIC_H
 
-#include <mutex>
+#include <atomic>
 #include <chrono>
+#include <string>
 
-class JArrowMetrics {
+/// JArrowMetrics accumulates what some executions of an arrow did. Every instance has exactly one writer (a worker,
+/// or whoever calls execute() directly), but any thread may read it at any time without stopping that writer:
+/// each field is a relaxed atomic, so a reader sees every total exactly, although one total may be slightly ahead
+/// of another. Instances are cache-line aligned, so that the per-worker instances inside a JArrow
+/// (see JArrow::get_metrics(worker_id)) never share a line.
+class alignas(64) JArrowMetrics {
 
 public:
     enum class Status {KeepGoing, ComeBackLater, Finished, NotRunYet, Error};
-    using duration_t = std::chrono::steady_clock::duration;
+    using clock_t = std::chrono::steady_clock;
+    using duration_t = clock_t::duration;
 
 private:
-    mutable std::mutex m_mutex;
-    // Mutex is mutable so that we can lock before reading from a const ref
+    std::atomic<Status> m_last_status {Status::NotRunYet};
+    std::atomic<size_t> m_total_message_count {0};
+    std::atomic<size_t> m_last_message_count {0};
+    std::atomic<size_t> m_total_queue_visits {0};
+    std::atomic<size_t> m_last_queue_visits {0};
+    std::atomic<duration_t> m_total_latency {duration_t::zero()};
+    std::atomic<duration_t> m_last_latency {duration_t::zero()};
+    std::atomic<duration_t> m_total_queue_latency {duration_t::zero()};
+    std::atomic<duration_t> m_last_queue_latency {duration_t::zero()};
+    std::atomic<size_t> m_total_steal_count {0};   // Messages this arrow took from another location's queue
+    std::atomic<clock_t::time_point> m_last_time {clock_t::time_point()};  // When last_message_count was recorded
+
+    // Only the writer modifies a field, so a plain load and store suffices and never needs a locked instruction
+    template <typename T, typename U>
+    static void add(std::atomic<T>& field, const U& delta) {
+        field.store(field.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+    template <typename T>
+    static T read(const std::atomic<T>& field) {
+        return field.load(std::memory_order_relaxed);
+    }
+    template <typename T, typename U>
+    static void write(std::atomic<T>& field, const U& value) {
+        field.store(value, std::memory_order_relaxed);
+    }
 
-    Status m_last_status;
-    size_t m_total_message_count;
-    size_t m_last_message_count;
-    size_t m_total_queue_visits;
-    size_t m_last_queue_visits;
-    duration_t m_total_latency;
-    duration_t m_last_latency;
-    duration_t m_total_queue_latency;
-    duration_t m_last_queue_latency;
+public:
+    JArrowMetrics() = default;
 
+    JArrowMetrics(const JArrowMetrics& other) {
+        update(other);
+    }
 
-    // TODO: We might want to add a timestamp, so that
-    // the 'last_*' measurements can reflect the most recent value,
-    // rather than the last-to-be-accumulated value.
+    JArrowMetrics& operator=(const JArrowMetrics& other) {
+        if (this != &other) {
+            clear();
+            update(other);
+        }
+        return *this;
+    }
 
-public:
     void clear() {
-
-        m_mutex.lock();
-        m_last_status = Status::NotRunYet;
-        m_total_message_count = 0;
-        m_last_message_count = 0;
-        m_total_queue_visits = 0;
-        m_last_queue_visits = 0;
-        m_total_latency = duration_t::zero();
-        m_last_latency = duration_t::zero();
-        m_total_queue_latency = duration_t::zero();
-        m_last_queue_latency = duration_t::zero();
-        m_mutex.unlock();
+        write(m_last_status, Status::NotRunYet);
+        write(m_total_message_count, 0);
+        write(m_last_message_count, 0);
+        write(m_total_queue_visits, 0);
+        write(m_last_queue_visits, 0);
+        write(m_total_latency, duration_t::zero());
+        write(m_last_latency, duration_t::zero());
+        write(m_total_queue_latency, duration_t::zero());
+        write(m_last_queue_latency, duration_t::zero());
+        write(m_total_steal_count, 0);
+        write(m_last_time, clock_t::time_point());
     }
 
+    /// take() moves everything from other into this. The caller has to be the writer of both.
     void take(JArrowMetrics& other) {
-
-        m_mutex.lock();
-        other.m_mutex.lock();
-
-        if (other.m_last_message_count != 0) {
-            m_last_message_count = other.m_last_message_count;
-            m_last_latency = other.m_last_latency;
-        }
-
-        m_last_status = other.m_last_status;
-        m_total_message_count += other.m_total_message_count;
-        m_total_queue_visits += other.m_total_queue_visits;
-        m_last_queue_visits = other.m_last_queue_visits;
-        m_total_latency += other.m_total_latency;
-        m_total_queue_latency += other.m_total_queue_latency;
-        m_last_queue_latency = other.m_last_queue_latency;
-
-        other.m_last_status = Status::NotRunYet;
-        other.m_total_message_count = 0;
-        other.m_last_message_count = 0;
-        other.m_total_queue_visits = 0;
-        other.m_last_queue_visits = 0;
-        other.m_total_latency = duration_t::zero();
-        other.m_last_latency = duration_t::zero();
-        other.m_total_queue_latency = duration_t::zero();
-        other.m_last_queue_latency = duration_t::zero();
-        other.m_mutex.unlock();
-        m_mutex.unlock();
+        update(other);
+        other.clear();
     };
 
+    /// update() adds other's totals to ours. The 'last' measurements are kept from whichever side recorded them
+    /// most recently, which is what makes this usable both for handing in metrics and for summing up workers.
     void update(const JArrowMetrics &other) {
 
-        m_mutex.lock();
-        other.m_mutex.lock();
-
-        if (other.m_last_message_count != 0) {
-            m_last_message_count = other.m_last_message_count;
-            m_last_latency = other.m_last_latency;
+        if (read(other.m_last_message_count) != 0 && read(other.m_last_time) >= read(m_last_time)) {
+            write(m_last_message_count, read(other.m_last_message_count));
+            write(m_last_latency, read(other.m_last_latency));
+            write(m_last_time, read(other.m_last_time));
         }
-        m_total_latency += other.m_total_latency;
-        m_last_status = other.m_last_status;
-        m_total_message_count += other.m_total_message_count;
-        m_total_queue_visits += other.m_total_queue_visits;
-        m_last_queue_visits = other.m_last_queue_visits;
-        m_total_queue_latency += other.m_total_queue_latency;
-        m_last_queue_latency = other.m_last_queue_latency;
-        other.m_mutex.unlock();
-        m_mutex.unlock();
+        write(m_last_status, read(other.m_last_status));
+        write(m_last_queue_visits, read(other.m_last_queue_visits));
+        write(m_last_queue_latency, read(other.m_last_queue_latency));
+        add(m_total_message_count, read(other.m_total_message_count));
+        add(m_total_queue_visits, read(other.m_total_queue_visits));
+        add(m_total_latency, read(other.m_total_latency));
+        add(m_total_queue_latency, read(other.m_total_queue_latency));
+        add(m_total_steal_count, read(other.m_total_steal_count));
     };
 
+    /// update_steal_count records messages which were taken from another location's queue via work stealing
+    void update_steal_count(size_t steal_count_delta) {
+        if (steal_count_delta == 0) return;
+        add(m_total_steal_count, steal_count_delta);
+    }
+
     void update_finished() {
-        m_mutex.lock();
-        m_last_status = Status::Finished;
-        m_mutex.unlock();
+        write(m_last_status, Status::Finished);
     }
 
     void update(const Status& last_status,
@@ -112,24 +117,22 @@ public:
                 const duration_t& latency_delta,
                 const duration_t& queue_latency_delta) {
 
-        m_mutex.lock();
-        m_last_status = last_status;
+        write(m_last_status, last_status);
 
         if (message_count_delta > 0) {
             // We don't want to lose our most recent latency numbers
             // when the most recent execute() encounters an empty
             // queue and consequently processes zero items.
-            m_last_message_count = message_count_delta;
-            m_last_latency = latency_delta;
+            write(m_last_message_count, message_count_delta);
+            write(m_last_latency, latency_delta);
+            write(m_last_time, clock_t::now());
         }
-        m_total_message_count += message_count_delta;
-        m_total_queue_visits += queue_visit_delta;
-        m_last_queue_visits = queue_visit_delta;
-        m_total_latency += latency_delta;
-        m_total_queue_latency += queue_latency_delta;
-        m_last_queue_latency = queue_latency_delta;
-        m_mutex.unlock();
-
+        add(m_total_message_count, message_count_delta);
+        add(m_total_queue_visits, queue_visit_delta);
+        write(m_last_queue_visits, queue_visit_delta);
+        add(m_total_latency, latency_delta);
+        add(m_total_queue_latency, queue_latency_delta);
+        write(m_last_queue_latency, queue_latency_delta);
     };
 
     void get(Status& last_status,
@@ -140,29 +143,44 @@ public:
              duration_t& total_latency,
              duration_t& last_latency,
              duration_t& total_queue_latency,
-             duration_t& last_queue_latency) {
+             duration_t& last_queue_latency) const {
+
+        last_status = read(m_last_status);
+        total_message_count = read(m_total_message_count);
+        last_message_count = read(m_last_message_count);
+        total_queue_visits = read(m_total_queue_visits);
+        last_queue_visits = read(m_last_queue_visits);
+        total_latency = read(m_total_latency);
+        last_latency = read(m_last_latency);
+        total_queue_latency = read(m_total_queue_latency);
+        last_queue_latency = read(m_last_queue_latency);
+    }
+
+    size_t get_total_message_count() const {
+        return read(m_total_message_count);
+    }
+
+    duration_t get_total_latency() const {
+        return read(m_total_latency);
+    }
+
+    duration_t get_total_queue_latency() const {
+        return read(m_total_queue_latency);
+    }
 
-        m_mutex.lock();
-        last_status = m_last_status;
-        total_message_count = m_total_message_count;
-        last_message_count = m_last_message_count;
-        total_queue_visits = m_total_queue_visits;
-        last_queue_visits = m_last_queue_visits;
-        total_latency = m_total_latency;
-        last_latency = m_last_latency;
-        total_queue_latency = m_total_queue_latency;
-        last_queue_latency = m_last_queue_latency;
-        m_mutex.unlock();
+    size_t get_total_steal_count() const {
+        return read(m_total_steal_count);
     }
 
-    size_t get_total_message_count() {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_total_message_count;
+    /// Latency per message of the most recent execution which processed anything, or zero if none has yet
+    duration_t get_last_latency_per_message() const {
+        size_t last_message_count = read(m_last_message_count);
+        if (last_message_count == 0) return duration_t::zero();
+        return read(m_last_latency) / last_message_count;
     }
 
-    Status get_last_status() {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_last_status;
+    Status get_last_status() const {
+        return read(m_last_status);
     }
 
     void summarize() {
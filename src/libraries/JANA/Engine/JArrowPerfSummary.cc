@@ -7,6 +7,26 @@
 
 #include <ostream>
 #include <iomanip>
+#include <algorithm>
+
+static void print_latencies(std::ostream& os, const std::vector<LatencySummary>& latencies, size_t max_rows) {
+    os << "  +--------------------------+----------+----------+----------+----------+----------+" << std::endl;
+    os << "  |           Name           |  Count   |   p50    |   p99    |  p99.9   |   Max    |" << std::endl;
+    os << "  |                          | [events] |   [ms]   |   [ms]   |   [ms]   |   [ms]   |" << std::endl;
+    os << "  +--------------------------+----------+----------+----------+----------+----------+" << std::endl;
+    for (size_t i=0; i<latencies.size() && i<max_rows; ++i) {
+        auto& ls = latencies[i];
+        os << "  | " << std::setprecision(3)
+           << std::setw(24) << std::left << ls.name << " |"
+           << std::setw(9) << std::right << ls.count << " |"
+           << std::setw(9) << ls.p50_ms << " |"
+           << std::setw(9) << ls.p99_ms << " |"
+           << std::setw(9) << ls.p999_ms << " |"
+           << std::setw(9) << ls.max_ms << " |"
+           << std::endl;
+    }
+    os << "  +--------------------------+----------+----------+----------+----------+----------+" << std::endl;
+}
 
 std::ostream& operator<<(std::ostream& os, const JArrowPerfSummary& s) {
 
@@ -20,6 +40,14 @@ std::ostream& operator<<(std::ostream& os, const JArrowPerfSummary& s) {
     os << "  Sequential bottleneck [Hz]:  " << std::setprecision(3) << s.avg_seq_bottleneck_hz << std::endl;
     os << "  Parallel bottleneck [Hz]:    " << std::setprecision(3) << s.avg_par_bottleneck_hz << std::endl;
     os << "  Efficiency [0..1]:           " << std::setprecision(3) << s.avg_efficiency_frac << std::endl;
+    if (s.max_bytes_in_flight != 0) {
+        os << "  Bytes in flight [MB]:        " << std::setprecision(4) << s.bytes_in_flight / 1e6
+           << " of " << s.max_bytes_in_flight / 1e6 << std::endl;
+        os << "  Queued bytes [MB]:           " << std::setprecision(4) << s.queued_bytes / 1e6 << std::endl;
+        os << "  Avg/max event size [MB]:     " << std::setprecision(4) << s.avg_event_bytes / 1e6
+           << " / " << s.max_event_bytes / 1e6 << std::endl;
+        os << "  Byte budget rejections:      " << s.byte_budget_rejections << std::endl;
+    }
     os << std::endl;
 
     os << "  +--------------------------+------------+--------+-----+---------+-------+--------+---------+-------------+" << std::endl;
@@ -33,7 +61,7 @@ std::ostream& operator<<(std::ostream& os, const JArrowPerfSummary& s) {
            << std::setw(6) << std::left << as.arrow_type << " | "
            << std::setw(3) << std::right << (as.is_parallel ? " T " : " F ") << " | "
            << std::setw(7) << as.thread_count << " |"
-           << std::setw(6) << as.chunksize << " |";
+           << std::setw(5) << as.chunksize << (as.is_chunksize_adaptive ? "*" : " ") << " |";
 
         if (as.arrow_type != JArrow::NodeType::Source) {
 
@@ -48,12 +76,21 @@ std::ostream& operator<<(std::ostream& os, const JArrowPerfSummary& s) {
            << std::endl;
     }
     os << "  +--------------------------+------------+--------+-----+---------+-------+--------+---------+-------------+" << std::endl;
+    std::string chunksize_changes;
+    for (auto as : s.arrows) {
+        if (!as.is_chunksize_adaptive) continue;
+        if (!chunksize_changes.empty()) chunksize_changes += ", ";
+        chunksize_changes += as.arrow_name + "=" + std::to_string(as.chunksize_changes);
+    }
+    if (!chunksize_changes.empty()) {
+        os << "  * Chunk size is tuned while running. Changes so far: " << chunksize_changes << std::endl;
+    }
 
 
-    os << "  +--------------------------+-------------+--------------+----------------+--------------+----------------+" << std::endl;
-    os << "  |           Name           | Avg latency | Inst latency | Queue latency  | Queue visits | Queue overhead | " << std::endl;
-    os << "  |                          | [ms/event]  |  [ms/event]  |   [ms/visit]   |    [count]   |     [0..1]     | " << std::endl;
-    os << "  +--------------------------+-------------+--------------+----------------+--------------+----------------+" << std::endl;
+    os << "  +--------------------------+-------------+--------------+----------------+--------------+----------------+-------------+" << std::endl;
+    os << "  |           Name           | Avg latency | Inst latency | Queue latency  | Queue visits | Queue overhead |   Steals    |" << std::endl;
+    os << "  |                          | [ms/event]  |  [ms/event]  |   [ms/visit]   |    [count]   |     [0..1]     |   [count]   |" << std::endl;
+    os << "  +--------------------------+-------------+--------------+----------------+--------------+----------------+-------------+" << std::endl;
 
     for (auto as : s.arrows) {
         os << "  | " << std::setprecision(3)
@@ -63,10 +100,63 @@ std::ostream& operator<<(std::ostream& os, const JArrowPerfSummary& s) {
            << std::setw(15) << as.avg_queue_latency_ms << " |"
            << std::setw(13) << as.queue_visit_count << " |"
            << std::setw(15) << as.avg_queue_overhead_frac << " |"
+           << std::setw(12) << as.steal_count << " |"
            << std::endl;
     }
-    os << "  +--------------------------+-------------+--------------+----------------+--------------+----------------+" << std::endl;
+    os << "  +--------------------------+-------------+--------------+----------------+--------------+----------------+-------------+" << std::endl;
+
+
+    bool has_reorder_buffer = false;
+    for (auto as : s.arrows) {
+        if (as.reorder_window != 0) has_reorder_buffer = true;
+    }
+    if (has_reorder_buffer) {
+        os << "  +--------------------------+--------+---------+-----------+--------------+" << std::endl;
+        os << "  |           Name           | Window |  Depth  | Max depth |  Stall time  |" << std::endl;
+        os << "  |                          |[count] | [count] |  [count]  |     [ms]     |" << std::endl;
+        os << "  +--------------------------+--------+---------+-----------+--------------+" << std::endl;
+        for (auto as : s.arrows) {
+            if (as.reorder_window == 0) continue;
+            os << "  | " << std::setprecision(3)
+               << std::setw(24) << std::left << as.arrow_name << " |"
+               << std::setw(7) << std::right << as.reorder_window << " |"
+               << std::setw(8) << as.reorder_depth << " |"
+               << std::setw(10) << as.reorder_max_depth << " |"
+               << std::setw(13) << as.reorder_stall_ms << " |"
+               << std::endl;
+        }
+        os << "  +--------------------------+--------+---------+-----------+--------------+" << std::endl;
+    }
 
+    if (!s.arrow_latencies.empty()) {
+        os << "  Arrow latency per event:" << std::endl;
+        print_latencies(os, s.arrow_latencies, s.arrow_latencies.size());
+    }
+    if (!s.factory_latencies.empty()) {
+        // Only the slowest factories, so that the ticker stays readable
+        size_t shown = std::min<size_t>(s.factory_latencies.size(), 10);
+        os << "  Factory latency per event, including the factories it calls (slowest " << shown
+           << " of " << s.factory_latencies.size() << "):" << std::endl;
+        print_latencies(os, s.factory_latencies, shown);
+    }
+    if (!s.factory_pools.empty()) {
+        size_t shown = std::min<size_t>(s.factory_pools.size(), 10);
+        os << "  Factory object pools (lowest hit rate " << shown << " of " << s.factory_pools.size() << "):" << std::endl;
+        os << "  +--------------------------+------------+------------+----------+" << std::endl;
+        os << "  |           Name           |    Hits    |   Misses   | Hit rate |" << std::endl;
+        os << "  |                          |  [count]   |  [count]   |  [0..1]  |" << std::endl;
+        os << "  +--------------------------+------------+------------+----------+" << std::endl;
+        for (size_t i=0; i<shown; ++i) {
+            auto& ps = s.factory_pools[i];
+            os << "  | " << std::setprecision(3)
+               << std::setw(24) << std::left << ps.name << " |"
+               << std::setw(11) << std::right << ps.hits << " |"
+               << std::setw(11) << ps.misses << " |"
+               << std::setw(9) << ps.hit_rate << " |"
+               << std::endl;
+        }
+        os << "  +--------------------------+------------+------------+----------+" << std::endl;
+    }
 
     os << "  +----+----------------------+-------------+------------+-----------+----------------+------------------+" << std::endl;
     os << "  | ID | Last arrow name      | Useful time | Retry time | Idle time | Scheduler time | Scheduler visits |" << std::endl;
@@ -85,6 +175,42 @@ std::ostream& operator<<(std::ostream& os, const JArrowPerfSummary& s) {
            << std::endl;
     }
     os << "  +----+----------------------+-------------+------------+-----------+----------------+------------------+" << std::endl;
+
+    if (s.event_pool.size() > 1) {
+        os << "  +----------+------+------+--------+----------+-----------+-----------+-----------------+" << std::endl;
+        os << "  | Location | Cpu  | NUMA | Pinned | Capacity | Available | In flight | Foreign returns |" << std::endl;
+        os << "  +----------+------+------+--------+----------+-----------+-----------+-----------------+" << std::endl;
+        for (auto& ps : s.event_pool) {
+            os << "  |" << std::right
+               << std::setw(9) << ps.location_id << " |"
+               << std::setw(5) << ps.cpu_id << " |"
+               << std::setw(5) << ps.numa_domain_id << " |"
+               << std::setw(7) << (ps.is_pinned ? "T" : "F") << " |"
+               << std::setw(9) << ps.capacity << " |"
+               << std::setw(10) << ps.available << " |"
+               << std::setw(10) << (ps.capacity > ps.available ? ps.capacity - ps.available : 0) << " |"
+               << std::setw(16) << ps.foreign_returns << " |"
+               << std::endl;
+        }
+        os << "  +----------+------+------+--------+----------+-----------+-----------+-----------------+" << std::endl;
+    }
+
+    if (!s.autoscale_decisions.empty()) {
+        // Only the most recent decisions, so that the ticker stays readable. The rest are in the log.
+        size_t shown = std::min<size_t>(s.autoscale_decisions.size(), 8);
+        os << "  Autoscaler decisions (latest " << shown << "):" << std::endl;
+        for (size_t i=s.autoscale_decisions.size()-shown; i<s.autoscale_decisions.size(); ++i) {
+            auto& d = s.autoscale_decisions[i];
+            os << "    " << std::setprecision(4)
+               << "t=" << std::setw(7) << std::left << d.uptime_s << " "
+               << std::setw(3) << std::right << d.old_thread_count << " => " << std::setw(3) << d.new_thread_count
+               << " | " << std::setprecision(3)
+               << std::setw(9) << d.throughput_hz << " Hz | idle "
+               << std::setw(5) << d.idle_frac << " | busy "
+               << std::setw(5) << d.busy_cores << " | "
+               << d.reason << std::endl;
+        }
+    }
     return os;
 }
 
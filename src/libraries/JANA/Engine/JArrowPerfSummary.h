@@ -24,6 +24,8 @@ struct ArrowSummary {
     size_t messages_pending;
     size_t threshold;
     size_t chunksize;
+    bool is_chunksize_adaptive = false;
+    size_t chunksize_changes = 0;
 
     size_t total_messages_completed;
     size_t last_messages_completed;
@@ -33,6 +35,13 @@ struct ArrowSummary {
     double last_queue_latency_ms;
     double avg_queue_overhead_frac;
     size_t queue_visit_count;
+    size_t steal_count;
+
+    // Only filled in for arrows with a reorder buffer, i.e. JEventReorderArrow
+    size_t reorder_window = 0;
+    size_t reorder_depth = 0;
+    size_t reorder_max_depth = 0;
+    double reorder_stall_ms = 0;
 };
 
 struct WorkerSummary {
@@ -57,6 +66,26 @@ struct WorkerSummary {
     size_t last_arrow_queue_visit_count;
 };
 
+struct EventPoolSummary {
+    size_t location_id;
+    size_t cpu_id;               // Cpu which allocated this location's events
+    size_t numa_domain_id;
+    bool is_pinned;              // Whether allocation really happened on cpu_id
+    size_t capacity;
+    size_t available;            // Events currently in the pool, as opposed to in flight
+    size_t foreign_returns;      // Events finished by a worker from another location
+};
+
+struct AutoscaleDecision {
+    double uptime_s;             // Time since the autoscaler started sampling
+    size_t old_thread_count;
+    size_t new_thread_count;
+    double throughput_hz;        // Measured over the preceding sampling interval
+    double idle_frac;            // Fraction of worker time spent idle or retrying, over the same interval
+    double busy_cores;           // Worker time spent doing useful work, divided by the interval
+    std::string reason;
+};
+
 struct JArrowPerfSummary : public JPerfSummary {
 
     double avg_seq_bottleneck_hz;
@@ -65,6 +94,16 @@ struct JArrowPerfSummary : public JPerfSummary {
 
     std::vector<WorkerSummary> workers;
     std::vector<ArrowSummary> arrows;
+    std::vector<EventPoolSummary> event_pool;  // One entry per location
+
+    // Byte budget, only filled in when jana:max_bytes_in_flight is set
+    size_t max_bytes_in_flight = 0;
+    size_t bytes_in_flight = 0;                // As charged by the event pool
+    size_t queued_bytes = 0;                   // Held by events sitting in queues
+    size_t avg_event_bytes = 0;
+    size_t max_event_bytes = 0;
+    size_t byte_budget_rejections = 0;         // Times the pool refused an event because of the budget
+    std::vector<AutoscaleDecision> autoscale_decisions;  // Most recent last. Empty unless jana:autoscale is enabled
 
     JArrowPerfSummary() = default;
     JArrowPerfSummary(const JArrowPerfSummary&) = default;
@@ -4,14 +4,28 @@
 
 #include <JANA/Engine/JArrowProcessingController.h>
 #include <JANA/Engine/JArrowPerfSummary.h>
+#include <JANA/Engine/JEventReorderArrow.h>
+#include <JANA/Engine/JScalableScheduler.h>
 #include <JANA/Utils/JCpuInfo.h>
 #include <JANA/JLogger.h>
 
+#include <algorithm>
 #include <memory>
 
 using millisecs = std::chrono::duration<double, std::milli>;
 using secs = std::chrono::duration<double>;
 
+static LatencySummary summarize_latency(const std::string& name, const JLatencyHistogram::Snapshot& snapshot) {
+    LatencySummary summary;
+    summary.name = name;
+    summary.count = snapshot.get_count();
+    summary.p50_ms = millisecs(snapshot.get_percentile(0.5)).count();
+    summary.p99_ms = millisecs(snapshot.get_percentile(0.99)).count();
+    summary.p999_ms = millisecs(snapshot.get_percentile(0.999)).count();
+    summary.max_ms = millisecs(snapshot.get_max()).count();
+    return summary;
+}
+
 void JArrowProcessingController::acquire_services(JServiceLocator * sl) {
     auto ls = sl->get<JLoggingService>();
     m_logger = ls->get_logger("JArrowProcessingController");
@@ -23,14 +37,52 @@ void JArrowProcessingController::acquire_services(JServiceLocator * sl) {
     params->SetDefaultParameter("jana:timeout", m_timeout_s, "Max time (in seconds) JANA will wait for a thread to update its heartbeat before hard-exiting. 0 to disable timeout completely.");
     params->SetDefaultParameter("jana:warmup_timeout", m_warmup_timeout_s, "Max time (in seconds) JANA will wait for 'initial' events to complete before hard-exiting.");
     // Originally "THREAD_TIMEOUT" and "THREAD_TIMEOUT_FIRST_EVENT"
+    params->SetDefaultParameter("jana:scheduler", m_scheduler_type, "Scheduler implementation. locking: Every checkin takes a global mutex. scalable: Per-worker cursors and atomic thread counts.")
+            ->SetIsAdvanced(true);
+    params->SetDefaultParameter("jana:scheduler_policy", m_scheduler_policy, "Order in which the scheduler offers arrows to workers. round_robin: Fixed rotation. backlog: Bottleneck stages first, ranked by queue fill and recent latency.")
+            ->SetIsAdvanced(true);
+
+    m_autoscale_config.max_threads = JCpuInfo::GetNumCpus();
+    m_autoscale_config.cpu_budget = JCpuInfo::GetNumCpus();
+    params->SetDefaultParameter("jana:autoscale", m_autoscale_target, "Adjust the number of worker threads while running. off: Keep nthreads. throughput: Add workers while each one raises throughput enough. cpu_budget: Keep the number of busy cores within jana:autoscale_cpu_budget.")
+            ->SetIsAdvanced(true);
+    params->SetDefaultParameter("jana:autoscale_interval_ms", m_autoscale_interval_ms, "Time between autoscaler samples. Each sample may add or retire one worker.")
+            ->SetIsAdvanced(true);
+    params->SetDefaultParameter("jana:autoscale_min_threads", m_autoscale_config.min_threads, "Fewest worker threads the autoscaler may scale down to")
+            ->SetIsAdvanced(true);
+    params->SetDefaultParameter("jana:autoscale_max_threads", m_autoscale_config.max_threads, "Most worker threads the autoscaler may scale up to. Defaults to the number of cpus.")
+            ->SetIsAdvanced(true);
+    params->SetDefaultParameter("jana:autoscale_cpu_budget", m_autoscale_config.cpu_budget, "Max number of cores doing useful work, for jana:autoscale=cpu_budget. Defaults to the number of cpus.")
+            ->SetIsAdvanced(true);
+    params->SetDefaultParameter("jana:autoscale_min_gain", m_autoscale_config.min_gain, "For jana:autoscale=throughput: an added worker has to raise throughput by this fraction of the average per-worker throughput, or it gets retired again.")
+            ->SetIsAdvanced(true);
 }
 
 void JArrowProcessingController::initialize() {
 
-    m_scheduler = new JScheduler(m_topology);
+    if (m_scheduler_type == "scalable") {
+        m_scheduler = new JScalableScheduler(m_topology);
+    }
+    else if (m_scheduler_type == "locking") {
+        m_scheduler = new JScheduler(m_topology);
+    }
+    else {
+        throw JException("Invalid value for jana:scheduler: '%s'. Options are 'locking' and 'scalable'.", m_scheduler_type.c_str());
+    }
+    if (m_scheduler_policy == "backlog") {
+        m_scheduler->set_policy(JScheduler::Policy::Backlog);
+    }
+    else if (m_scheduler_policy != "round_robin") {
+        throw JException("Invalid value for jana:scheduler_policy: '%s'. Options are 'round_robin' and 'backlog'.", m_scheduler_policy.c_str());
+    }
     m_scheduler->logger = m_scheduler_logger;
     LOG_INFO(m_logger) << m_topology->mapping << LOG_END;
 
+    m_autoscale_config.target = JAutoscaler::parse_target(m_autoscale_target);
+    if (m_autoscale_config.target != JAutoscaler::Target::Off) {
+        m_autoscaler = std::unique_ptr<JAutoscaler>(new JAutoscaler(m_autoscale_config));
+    }
+
     m_topology->initialize();
 
 }
@@ -49,56 +101,179 @@ void JArrowProcessingController::run(size_t nthreads) {
     // topology->run needs to happen _before_ threads are started so that threads don't quit due to lack of assignments
     m_topology->run(nthreads);
 
-    bool pin_to_cpu = (m_topology->mapping.get_affinity() != JProcessorMapping::AffinityStrategy::None);
-
-    size_t next_worker_id = 0;
-    while (next_worker_id < nthreads) {
-        size_t next_cpu_id = m_topology->mapping.get_cpu_id(next_worker_id);
-        size_t next_loc_id = m_topology->mapping.get_loc_id(next_worker_id);
-        auto worker = new JWorker(this, m_scheduler, next_worker_id, next_cpu_id, next_loc_id, pin_to_cpu);
-        worker->logger = m_worker_logger;
-        m_workers.push_back(worker);
-        next_worker_id++;
+    {
+        std::lock_guard<std::mutex> lock(m_workers_mutex);
+        start_workers(nthreads);
+    }
+    if (m_autoscaler != nullptr && m_autoscaler_thread == nullptr) {
+        LOG_INFO(m_logger) << "run(): Autoscaling towards target '" << m_autoscaler->get_config().target << "'" << LOG_END;
+        m_autoscaler_stop = false;
+        m_autoscaler_thread = new std::thread(&JArrowProcessingController::autoscale_loop, this);
     }
-    for (size_t i=0; i<nthreads; ++i) {
-        m_workers.at(i)->start();
-    };
     // It's tempting to put a barrier here so that JAPC::run() blocks until all workers have entered loop().
     // The reason it doesn't work is that the topology might exit immediately (or close to immediately), leaving
     // the supervisor thread waiting forever for workers to reach RunState::Running when they've already Stopped.
 }
 
+/// @brief Changes the number of workers while the topology keeps running.
+///
+/// Workers are added or retired one id at a time, always at the top end, so that the running workers are exactly
+/// ids [0, nthreads) and keep the cpu and location that JProcessorMapping gave them. Retiring a worker lets it finish
+/// its current assignment and hand it back to the scheduler; the other workers are never interrupted. Only if the
+/// topology is paused (so there is nothing in flight to disrupt) does this restart it with the new team.
+///
+/// @param [in] nthreads The number of worker threads which should be running afterwards
 void JArrowProcessingController::scale(size_t nthreads) {
 
-    LOG_INFO(m_logger) << "scale(): Stopping all running workers" << LOG_END;
-    m_topology->request_pause();
-    for (JWorker* worker : m_workers) {
+    std::unique_lock<std::mutex> lock(m_workers_mutex);
+    auto status = m_topology->m_current_status.load();
+
+    if (status == JArrowTopology::Status::Finished) {
+        LOG_INFO(m_logger) << "scale(): Topology has already finished; nothing to scale" << LOG_END;
+        return;
+    }
+    if (status == JArrowTopology::Status::Paused || status == JArrowTopology::Status::Uninitialized) {
+        LOG_INFO(m_logger) << "scale(): Topology is paused; restarting with " << nthreads << " workers" << LOG_END;
+        for (JWorker* worker : m_workers) {
+            worker->wait_for_stop();
+        }
+        m_active_worker_count = 0;
+        // topology->run needs to happen _before_ threads are started so that threads don't quit due to lack of assignments
+        m_topology->run(nthreads);
+        start_workers(nthreads);
+        return;
+    }
+
+    auto retired = scale_incrementally(nthreads);
+    lock.unlock();
+    for (JWorker* worker : retired) {
         worker->wait_for_stop();
     }
-    m_topology->achieve_pause();
+}
+
+/// Adds or retires workers so that exactly [0, nthreads) are running, without pausing the topology.
+/// Must be called with m_workers_mutex held. Returns the retired workers, which the caller should
+/// wait_for_stop() once it has released the mutex.
+std::vector<JWorker*> JArrowProcessingController::scale_incrementally(size_t nthreads) {
+
+    std::vector<JWorker*> retired;
+    auto previous_count = m_active_worker_count;
+    if (nthreads > previous_count) {
+        LOG_INFO(m_logger) << "scale(): Adding workers " << previous_count << ".." << nthreads-1 << LOG_END;
+        start_workers(nthreads);
+    }
+    else if (nthreads < previous_count) {
+        LOG_INFO(m_logger) << "scale(): Retiring workers " << nthreads << ".." << previous_count-1 << LOG_END;
+        retired = retire_workers(nthreads);
+    }
+    else {
+        return retired;
+    }
+    // The stopwatch is meant to be restarted whenever the thread count changes
+    m_topology->metrics.reset();
+    m_topology->metrics.start(get_monotonic_event_count(), nthreads);
+    return retired;
+}
+
+/// Starts workers [m_active_worker_count, nthreads), reusing retired JWorkers where they exist.
+/// Must be called with m_workers_mutex held.
+void JArrowProcessingController::start_workers(size_t nthreads) {
 
-    LOG_INFO(m_logger) << "scale(): All workers are stopped" << LOG_END;
     bool pin_to_cpu = (m_topology->mapping.get_affinity() != JProcessorMapping::AffinityStrategy::None);
-    size_t next_worker_id = m_workers.size();
 
+    size_t next_worker_id = m_workers.size();
     while (next_worker_id < nthreads) {
-
         size_t next_cpu_id = m_topology->mapping.get_cpu_id(next_worker_id);
         size_t next_loc_id = m_topology->mapping.get_loc_id(next_worker_id);
-
         auto worker = new JWorker(this, m_scheduler, next_worker_id, next_cpu_id, next_loc_id, pin_to_cpu);
         worker->logger = m_worker_logger;
+        worker->set_factory_tasks(m_topology->factory_tasks.get());
         m_workers.push_back(worker);
         next_worker_id++;
     }
+    for (size_t i=m_active_worker_count; i<nthreads; ++i) {
+        m_workers.at(i)->start();
+    }
+    m_active_worker_count = nthreads;
+}
 
-    LOG_INFO(m_logger) << "scale(): Restarting " << nthreads << " workers" << LOG_END;
-    // topology->run needs to happen _before_ threads are started so that threads don't quit due to lack of assignments
-    m_topology->run(nthreads);
+/// Asks workers [nthreads, m_active_worker_count) to stop and takes them off the active range. Returns them, so
+/// that the caller can wait for each to hand back its assignment without holding m_workers_mutex meanwhile.
+/// Must be called with m_workers_mutex held.
+std::vector<JWorker*> JArrowProcessingController::retire_workers(size_t nthreads) {
 
-    for (size_t i=0; i<nthreads; ++i) {
-        m_workers.at(i)->start();
-    };
+    std::vector<JWorker*> retired;
+    for (size_t i=nthreads; i<m_active_worker_count; ++i) {
+        m_workers.at(i)->request_stop();
+        retired.push_back(m_workers.at(i));
+    }
+    m_active_worker_count = nthreads;
+    return retired;
+}
+
+/// Samples performance every jana:autoscale_interval_ms and applies whatever JAutoscaler decides,
+/// for as long as the topology is running
+void JArrowProcessingController::autoscale_loop() {
+
+    auto prev_sample_time = jclock_t::now();
+    std::unique_lock<std::mutex> lock(m_autoscaler_mutex);
+    while (!m_autoscaler_stop) {
+        m_autoscaler_cv.wait_for(lock, std::chrono::milliseconds(m_autoscale_interval_ms), [&]{ return m_autoscaler_stop; });
+        if (m_autoscaler_stop) break;
+        lock.unlock();
+
+        if (m_topology->m_current_status == JArrowTopology::Status::Running) {
+            auto sample = sample_internal_performance();
+            auto sample_time = jclock_t::now();
+            size_t current_threads;
+            {
+                std::lock_guard<std::mutex> workers_lock(m_workers_mutex);
+                current_threads = m_active_worker_count;
+            }
+            auto decision = m_autoscaler->decide(*sample, current_threads, secs(sample_time - prev_sample_time).count());
+            prev_sample_time = sample_time;
+
+            if (decision.new_thread_count != decision.old_thread_count) {
+                LOG_INFO(m_logger) << "Autoscaler: " << decision.old_thread_count << " => " << decision.new_thread_count
+                                   << " workers: " << decision.reason << LOG_END;
+                std::vector<JWorker*> retired;
+                {
+                    std::lock_guard<std::mutex> workers_lock(m_workers_mutex);
+                    // Somebody may have paused the topology or called scale() in the meantime, in which case this decision is stale
+                    if (m_topology->m_current_status == JArrowTopology::Status::Running && m_active_worker_count == current_threads) {
+                        retired = scale_incrementally(decision.new_thread_count);
+                    }
+                }
+                for (JWorker* worker : retired) {
+                    worker->wait_for_stop();
+                }
+            }
+            else {
+                LOG_DEBUG(m_logger) << "Autoscaler: Holding at " << decision.old_thread_count << " workers: " << decision.reason << LOG_END;
+            }
+        }
+        lock.lock();
+    }
+}
+
+void JArrowProcessingController::stop_autoscaler() {
+    if (m_autoscaler_thread == nullptr) return;
+    {
+        std::lock_guard<std::mutex> lock(m_autoscaler_mutex);
+        m_autoscaler_stop = true;
+    }
+    m_autoscaler_cv.notify_all();
+    m_autoscaler_thread->join();
+    delete m_autoscaler_thread;
+    m_autoscaler_thread = nullptr;
+}
+
+size_t JArrowProcessingController::get_monotonic_event_count() {
+    size_t monotonic_event_count = 0;
+    for (JArrow* arrow : m_topology->sinks) {
+        monotonic_event_count += arrow->get_metrics().get_total_message_count();
+    }
+    return monotonic_event_count;
 }
 
 void JArrowProcessingController::request_pause() {
@@ -110,6 +285,7 @@ void JArrowProcessingController::request_pause() {
 }
 
 void JArrowProcessingController::wait_until_paused() {
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
     for (JWorker* worker : m_workers) {
         worker->wait_for_stop();
     }
@@ -132,7 +308,10 @@ void JArrowProcessingController::request_stop() {
 }
 
 void JArrowProcessingController::wait_until_stopped() {
+    // The autoscaler mustn't add workers behind our back
+    stop_autoscaler();
     // Join all workers
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
     for (JWorker* worker : m_workers) {
         worker->wait_for_stop();
     }
@@ -175,6 +354,7 @@ bool JArrowProcessingController::is_timed_out() {
     }
 
     // Find all workers whose last heartbeat exceeds timeout
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
     bool found_timeout = false;
     for (size_t i=0; i<metrics->workers.size(); ++i) {
         if (metrics->workers[i].last_heartbeat_ms > (timeout_s * 1000)) {
@@ -188,6 +368,7 @@ bool JArrowProcessingController::is_timed_out() {
 }
 
 bool JArrowProcessingController::is_excepted() {
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
     for (auto worker : m_workers) {
         if (worker->get_runstate() == JWorker::RunState::Excepted) {
             return true;
@@ -198,6 +379,7 @@ bool JArrowProcessingController::is_excepted() {
 
 std::vector<JException> JArrowProcessingController::get_exceptions() const {
     std::vector<JException> exceptions;
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
     for (auto worker : m_workers) {
         if (worker->get_runstate() == JWorker::RunState::Excepted) {
             exceptions.push_back(worker->get_exception());
@@ -208,6 +390,8 @@ std::vector<JException> JArrowProcessingController::get_exceptions() const {
 
 JArrowProcessingController::~JArrowProcessingController() {
 
+    stop_autoscaler();
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
     for (JWorker* worker : m_workers) {
         worker->request_stop();
     }
@@ -231,24 +415,42 @@ void JArrowProcessingController::print_final_report() {
 }
 
 std::unique_ptr<const JArrowPerfSummary> JArrowProcessingController::measure_internal_performance() {
+    return measure(true);
+}
+
+/// Same as measure_internal_performance(), except that it leaves the stopwatch's latest interval alone,
+/// so that sampling every jana:autoscale_interval_ms doesn't disturb the ticker's instantaneous throughput
+std::unique_ptr<const JArrowPerfSummary> JArrowProcessingController::sample_internal_performance() {
+    return measure(false);
+}
+
+std::unique_ptr<const JArrowPerfSummary> JArrowProcessingController::measure(bool split_stopwatch) {
+
+    std::lock_guard<std::mutex> perf_lock(m_perf_mutex);
 
     // Measure perf on all Workers first, as this will prompt them to publish
     // any ArrowMetrics they have collected
+    // Retired workers aren't heartbeating, so leave them out lest they look timed out
     m_perf_summary.workers.clear();
-    for (JWorker* worker : m_workers) {
-        WorkerSummary summary;
-        worker->measure_perf(summary);
-        m_perf_summary.workers.push_back(summary);
+    {
+        std::lock_guard<std::mutex> lock(m_workers_mutex);
+        for (size_t i=0; i<m_active_worker_count; ++i) {
+            WorkerSummary summary;
+            m_workers[i]->measure_perf(summary);
+            m_perf_summary.workers.push_back(summary);
+        }
     }
 
-    size_t monotonic_event_count = 0;
-    for (JArrow* arrow : m_topology->sinks) {
-        monotonic_event_count += arrow->get_metrics().get_total_message_count();
-    }
+    size_t monotonic_event_count = get_monotonic_event_count();
 
     // Uptime
-    m_topology->metrics.split(monotonic_event_count);
-    m_topology->metrics.summarize(m_perf_summary);
+    if (split_stopwatch) {
+        m_topology->metrics.split(monotonic_event_count);
+        m_topology->metrics.summarize(m_perf_summary);
+    }
+    else {
+        m_topology->metrics.peek(monotonic_event_count, m_perf_summary);
+    }
 
     double worst_seq_latency = 0;
     double worst_par_latency = 0;
@@ -277,6 +479,8 @@ std::unique_ptr<const JArrowPerfSummary> JArrowProcessingController::measure_int
         summary.thread_count = arrow->get_thread_count();
         summary.arrow_name = arrow->get_name();
         summary.chunksize = arrow->get_chunksize();
+        summary.is_chunksize_adaptive = arrow->is_chunksize_adaptive();
+        summary.chunksize_changes = arrow->get_chunksize_changes();
         summary.messages_pending = arrow->get_pending();
         summary.running_upstreams = arrow->get_running_upstreams();
         summary.threshold = arrow->get_threshold();
@@ -285,6 +489,7 @@ std::unique_ptr<const JArrowPerfSummary> JArrowProcessingController::measure_int
         summary.total_messages_completed = total_message_count;
         summary.last_messages_completed = last_message_count;
         summary.queue_visit_count = total_queue_visits;
+        summary.steal_count = arrow->get_metrics().get_total_steal_count();
 
         summary.avg_queue_latency_ms = (total_queue_visits == 0)
                                        ? std::numeric_limits<double>::infinity()
@@ -300,6 +505,14 @@ std::unique_ptr<const JArrowPerfSummary> JArrowProcessingController::measure_int
                                 ? std::numeric_limits<double>::infinity()
                                 : millisecs(last_latency).count()/last_message_count;
 
+        auto reorder_arrow = dynamic_cast<JEventReorderArrow*>(arrow);
+        if (reorder_arrow != nullptr) {
+            summary.reorder_window = reorder_arrow->get_window();
+            summary.reorder_depth = reorder_arrow->get_depth();
+            summary.reorder_max_depth = reorder_arrow->get_max_depth();
+            summary.reorder_stall_ms = millisecs(reorder_arrow->get_stall_time()).count();
+        }
+
         if (arrow->is_parallel()) {
             worst_par_latency = std::max(worst_par_latency, summary.avg_latency_ms);
         } else {
@@ -318,6 +531,67 @@ std::unique_ptr<const JArrowPerfSummary> JArrowProcessingController::measure_int
                                       ? std::numeric_limits<double>::infinity()
                                       : m_perf_summary.avg_throughput_hz / tighter_bottleneck;
 
+    m_perf_summary.event_pool.clear();
+    auto& pool = m_topology->event_pool;
+    if (pool != nullptr && pool->get_max_bytes_in_flight() != 0) {
+        m_perf_summary.max_bytes_in_flight = pool->get_max_bytes_in_flight();
+        m_perf_summary.bytes_in_flight = pool->get_bytes_in_flight();
+        m_perf_summary.avg_event_bytes = pool->get_avg_event_bytes();
+        m_perf_summary.max_event_bytes = pool->get_max_event_bytes();
+        m_perf_summary.byte_budget_rejections = pool->get_byte_budget_rejections();
+        m_perf_summary.queued_bytes = 0;
+        for (auto queue : m_topology->queues) {
+            m_perf_summary.queued_bytes += queue->get_bytes();
+        }
+    }
+    for (size_t loc=0; pool != nullptr && loc<pool->get_location_count(); ++loc) {
+        auto stats = pool->get_stats(loc);
+        EventPoolSummary summary;
+        summary.location_id = loc;
+        summary.cpu_id = stats.cpu_id;
+        summary.numa_domain_id = stats.numa_domain_id;
+        summary.is_pinned = stats.is_pinned;
+        summary.capacity = stats.capacity;
+        summary.available = stats.available;
+        summary.foreign_returns = stats.foreign_returns;
+        m_perf_summary.event_pool.push_back(summary);
+    }
+
+    // Latency percentiles per event
+    m_perf_summary.arrow_latencies.clear();
+    for (JArrow* arrow : m_topology->arrows) {
+        auto snapshot = arrow->get_latency_histogram().get_snapshot();
+        if (snapshot.get_count() == 0) continue;
+        m_perf_summary.arrow_latencies.push_back(summarize_latency(arrow->get_name(), snapshot));
+    }
+    m_perf_summary.factory_latencies.clear();
+    m_perf_summary.factory_pools.clear();
+    if (m_topology->component_manager != nullptr) {
+        for (auto& item : m_topology->component_manager->get_factory_latencies()) {
+            auto snapshot = item.second->get_snapshot();
+            if (snapshot.get_count() == 0) continue;
+            m_perf_summary.factory_latencies.push_back(summarize_latency(item.first, snapshot));
+        }
+        std::stable_sort(m_perf_summary.factory_latencies.begin(), m_perf_summary.factory_latencies.end(),
+                         [](const LatencySummary& a, const LatencySummary& b) { return a.p99_ms > b.p99_ms; });
+
+        for (auto& item : m_topology->component_manager->get_factory_pool_statistics()) {
+            PoolSummary pool;
+            pool.name = item.first;
+            pool.hits = item.second->get_hits();
+            pool.misses = item.second->get_misses();
+            if (pool.hits + pool.misses == 0) continue;
+            pool.hit_rate = item.second->get_hit_rate();
+            m_perf_summary.factory_pools.push_back(pool);
+        }
+        std::stable_sort(m_perf_summary.factory_pools.begin(), m_perf_summary.factory_pools.end(),
+                         [](const PoolSummary& a, const PoolSummary& b) { return a.hit_rate < b.hit_rate; });
+    }
+
+    if (m_autoscaler != nullptr) {
+        m_perf_summary.autoscale_decisions = m_autoscaler->get_history();
+    }
+
     return std::unique_ptr<JArrowPerfSummary>(new JArrowPerfSummary(m_perf_summary));
 }
 
@@ -11,7 +11,9 @@
 #include <JANA/Engine/JWorker.h>
 #include <JANA/Engine/JArrowTopology.h>
 #include <JANA/Engine/JArrowPerfSummary.h>
+#include <JANA/Engine/JAutoscaler.h>
 
+#include <condition_variable>
 #include <vector>
 
 class JArrowProcessingController : public JProcessingController {
@@ -48,16 +50,39 @@ private:
     using jclock_t = std::chrono::steady_clock;
     int m_timeout_s = 8;
     int m_warmup_timeout_s = 30;
+    std::string m_scheduler_type = "locking";
+    std::string m_scheduler_policy = "round_robin";
+    std::string m_autoscale_target = "off";
+    int m_autoscale_interval_ms = 2000;
+    JAutoscaler::Config m_autoscale_config;
 
     JArrowPerfSummary m_perf_summary;
+    std::mutex m_perf_mutex;                  // The supervisor and the autoscaler both measure
     std::shared_ptr<JArrowTopology> m_topology;       // Owned by JArrowProcessingController
     JScheduler* m_scheduler = nullptr;
 
-    std::vector<JWorker*> m_workers;
+    std::vector<JWorker*> m_workers;          // Indexed by worker id. Workers [0, m_active_worker_count) are running
+    size_t m_active_worker_count = 0;
+    mutable std::mutex m_workers_mutex;       // Lets scale() add workers while the supervisor thread is measuring them
     JLogger m_logger;
     JLogger m_worker_logger;
     JLogger m_scheduler_logger;
 
+    std::unique_ptr<JAutoscaler> m_autoscaler;
+    std::thread* m_autoscaler_thread = nullptr;
+    std::mutex m_autoscaler_mutex;
+    std::condition_variable m_autoscaler_cv;
+    bool m_autoscaler_stop = false;
+
+    void autoscale_loop();
+    void stop_autoscaler();
+    std::vector<JWorker*> scale_incrementally(size_t nthreads);
+    void start_workers(size_t nthreads);
+    std::vector<JWorker*> retire_workers(size_t nthreads);
+    size_t get_monotonic_event_count();
+    std::unique_ptr<const JArrowPerfSummary> sample_internal_performance();
+    std::unique_ptr<const JArrowPerfSummary> measure(bool split_stopwatch);
+
 };
 
 #endif //JANA2_JARROWPROCESSINGCONTROLLER_H
@@ -11,6 +11,7 @@
 #include <JANA/Status/JPerfMetrics.h>
 #include <JANA/Utils/JEventPool.h>
 #include <JANA/Utils/JProcessorMapping.h>
+#include <JANA/Engine/JFactoryTaskPool.h>
 
 #include "JArrow.h"
 #include "JMailbox.h"
@@ -36,6 +37,7 @@ struct JArrowTopology {
     std::vector<JArrow*> sources;           // Sources needed for activation
     std::vector<JArrow*> sinks;             // Sinks needed for finished message count // TODO: Not anymore
     std::vector<EventQueue*> queues;        // Queues shared between arrows
+    std::shared_ptr<JFactoryTaskPool> factory_tasks;  // Only with jana:parallel_factories. Idle workers help out here.
     JProcessorMapping mapping;
 
     std::atomic<Status> m_current_status {Status::Uninitialized};
@@ -0,0 +1,140 @@
+
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include <JANA/Engine/JAutoscaler.h>
+#include <JANA/JException.h>
+
+#include <sstream>
+
+
+JAutoscaler::JAutoscaler(Config config) : m_config(std::move(config)) {
+    m_config.min_threads = std::max<size_t>(m_config.min_threads, 1);
+    m_config.max_threads = std::max(m_config.max_threads, m_config.min_threads);
+}
+
+AutoscaleDecision JAutoscaler::decide(const JArrowPerfSummary& sample, size_t current_threads, double elapsed_s) {
+
+    AutoscaleDecision decision;
+    decision.old_thread_count = current_threads;
+    decision.new_thread_count = current_threads;
+    decision.throughput_hz = 0;
+    decision.idle_frac = 0;
+    decision.busy_cores = 0;
+
+    // Turn the cumulative totals in the sample into rates over the interval since the previous sample
+    double useful_ms = 0, wasted_ms = 0, total_ms = 0;
+    for (const auto& ws : sample.workers) {
+        WorkerTotals totals {ws.total_useful_time_ms, ws.total_retry_time_ms, ws.total_idle_time_ms, ws.total_scheduler_time_ms};
+        auto prev = m_prev_worker_totals.find(ws.worker_id);
+        if (prev != m_prev_worker_totals.end()) {
+            useful_ms += totals.useful_ms - prev->second.useful_ms;
+            wasted_ms += (totals.retry_ms - prev->second.retry_ms) + (totals.idle_ms - prev->second.idle_ms);
+            total_ms += (totals.useful_ms - prev->second.useful_ms) + (totals.retry_ms - prev->second.retry_ms)
+                      + (totals.idle_ms - prev->second.idle_ms) + (totals.scheduler_ms - prev->second.scheduler_ms);
+        }
+        m_prev_worker_totals[ws.worker_id] = totals;
+    }
+    if (m_has_baseline && elapsed_s > 0) {
+        m_uptime_s += elapsed_s;
+        decision.throughput_hz = (sample.monotonic_events_completed - m_prev_event_count) / elapsed_s;
+        decision.busy_cores = useful_ms / (1000 * elapsed_s);
+        decision.idle_frac = (total_ms > 0) ? wasted_ms / total_ms : 0;
+    }
+    m_prev_event_count = sample.monotonic_events_completed;
+    decision.uptime_s = m_uptime_s;
+
+    auto n = current_threads;
+    std::ostringstream reason;
+    reason.precision(3);
+
+    if (!m_has_baseline) {
+        m_has_baseline = true;
+        reason << "Taking baseline sample";
+    }
+    else if (m_config.target == Target::Off) {
+        reason << "Autoscaling is off";
+    }
+    else if (n < m_config.min_threads) {
+        decision.new_thread_count = m_config.min_threads;
+        reason << "Below min_threads";
+    }
+    else if (n > m_config.max_threads) {
+        decision.new_thread_count = m_config.max_threads;
+        reason << "Above max_threads";
+    }
+    else if (m_is_probing) {
+        // Judge the worker we added last time
+        m_is_probing = false;
+        auto per_worker_hz = (n > 1) ? m_throughput_before_probe / (n - 1) : m_throughput_before_probe;
+        auto gain_hz = decision.throughput_hz - m_throughput_before_probe;
+        if (gain_hz < m_config.min_gain * per_worker_hz) {
+            decision.new_thread_count = n - 1;
+            m_cooldown = m_config.cooldown_intervals;
+            reason << "Worker " << n << " added " << gain_hz << " Hz, less than " << m_config.min_gain
+                   << " x " << per_worker_hz << " Hz per worker";
+        }
+        else {
+            reason << "Worker " << n << " added " << gain_hz << " Hz";
+        }
+    }
+    else if (decision.idle_frac > m_config.max_idle_frac && n > m_config.min_threads) {
+        decision.new_thread_count = n - 1;
+        reason << "Workers spent " << decision.idle_frac << " of their time idle or retrying";
+    }
+    else if (m_config.target == Target::CpuBudget) {
+        if (decision.busy_cores > m_config.cpu_budget && n > m_config.min_threads) {
+            decision.new_thread_count = n - 1;
+            reason << "Busy cores " << decision.busy_cores << " exceed budget of " << m_config.cpu_budget;
+        }
+        else if (decision.busy_cores + 1 <= m_config.cpu_budget && n < m_config.max_threads) {
+            decision.new_thread_count = n + 1;
+            reason << "Busy cores " << decision.busy_cores << " leave room in budget of " << m_config.cpu_budget;
+        }
+        else {
+            reason << "Busy cores " << decision.busy_cores << " are within budget of " << m_config.cpu_budget;
+        }
+    }
+    else if (m_cooldown > 0) {
+        m_cooldown--;
+        reason << "Cooling down after unprofitable worker";
+    }
+    else if (n < m_config.max_threads) {
+        decision.new_thread_count = n + 1;
+        m_is_probing = true;
+        m_throughput_before_probe = decision.throughput_hz;
+        reason << "Probing whether another worker raises throughput of " << decision.throughput_hz << " Hz";
+    }
+    else {
+        reason << "At max_threads";
+    }
+    decision.reason = reason.str();
+
+    std::lock_guard<std::mutex> lock(m_history_mutex);
+    m_history.push_back(decision);
+    while (m_history.size() > m_config.history_size) {
+        m_history.pop_front();
+    }
+    return decision;
+}
+
+std::vector<AutoscaleDecision> JAutoscaler::get_history() const {
+    std::lock_guard<std::mutex> lock(m_history_mutex);
+    return {m_history.begin(), m_history.end()};
+}
+
+JAutoscaler::Target JAutoscaler::parse_target(const std::string& target) {
+    if (target == "off") return Target::Off;
+    if (target == "throughput") return Target::Throughput;
+    if (target == "cpu_budget") return Target::CpuBudget;
+    throw JException("Invalid value for jana:autoscale: '%s'. Options are 'off', 'throughput', and 'cpu_budget'.", target.c_str());
+}
+
+std::ostream& operator<<(std::ostream& os, JAutoscaler::Target target) {
+    switch (target) {
+        case JAutoscaler::Target::Off: os << "off"; break;
+        case JAutoscaler::Target::Throughput: os << "throughput"; break;
+        case JAutoscaler::Target::CpuBudget: os << "cpu_budget"; break;
+    }
+    return os;
+}
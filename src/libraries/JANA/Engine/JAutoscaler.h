@@ -0,0 +1,76 @@
+
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JAUTOSCALER_H
+#define JANA2_JAUTOSCALER_H
+
+#include <JANA/Engine/JArrowPerfSummary.h>
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <ostream>
+
+/// JAutoscaler decides how many workers JArrowProcessingController should be running, based on successive
+/// samples from measure_internal_performance(). It only decides; the controller samples it periodically and
+/// applies the decision via incremental scaling. Every decision, including 'hold', is kept in a short history
+/// so that it can be audited via JArrowPerfSummary::autoscale_decisions.
+///
+/// Targets:
+/// - Throughput: Hill-climb towards maximum throughput per core. Add a worker, and keep it only if it raised
+///   throughput by at least min_gain times the average per-worker throughput. Otherwise remove it again and
+///   wait a few intervals before probing again.
+/// - CpuBudget: Keep the number of cores doing useful work at or below cpu_budget. Unlike capping the thread
+///   count, this lets I/O-bound workloads run more threads than the budget, as long as they mostly wait.
+///
+/// Under either target, workers which are mostly idle (waiting on empty queues or retrying) get retired.
+class JAutoscaler {
+
+public:
+    enum class Target { Off, Throughput, CpuBudget };
+
+    struct Config {
+        Target target = Target::Off;
+        size_t min_threads = 1;
+        size_t max_threads = 1;
+        double cpu_budget = 1;         // Cores. Only used by Target::CpuBudget
+        double min_gain = 0.5;         // Fraction of average per-worker throughput a new worker has to contribute
+        double max_idle_frac = 0.5;    // Shrink once workers spend more than this fraction of time idle or retrying
+        size_t cooldown_intervals = 5; // How long to hold after a failed probe
+        size_t history_size = 32;
+    };
+
+private:
+    Config m_config;
+
+    bool m_has_baseline = false;
+    double m_uptime_s = 0;
+    size_t m_prev_event_count = 0;
+    struct WorkerTotals { double useful_ms, retry_ms, idle_ms, scheduler_ms; };
+    std::map<int, WorkerTotals> m_prev_worker_totals;  // Keyed by worker id, because retired workers come back
+
+    bool m_is_probing = false;         // The previous decision added a worker to see whether it pays off
+    double m_throughput_before_probe = 0;
+    size_t m_cooldown = 0;
+
+    mutable std::mutex m_history_mutex;
+    std::deque<AutoscaleDecision> m_history;
+
+public:
+    explicit JAutoscaler(Config config);
+
+    const Config& get_config() const { return m_config; }
+
+    /// decide() consumes the latest sample, taken elapsed_s after the previous one, and returns the thread count
+    /// the controller should scale to. Must only be called from one thread at a time.
+    AutoscaleDecision decide(const JArrowPerfSummary& sample, size_t current_threads, double elapsed_s);
+
+    std::vector<AutoscaleDecision> get_history() const;
+
+    static Target parse_target(const std::string& target);
+};
+
+std::ostream& operator<<(std::ostream& os, JAutoscaler::Target target);
+
+#endif //JANA2_JAUTOSCALER_H
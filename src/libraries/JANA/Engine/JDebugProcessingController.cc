@@ -60,6 +60,7 @@ void JDebugProcessingController::run_worker() {
                     }
                     m_total_events_processed += 1;
                     event->GetFactorySet()->Release();
+                    event->GetAssociations().Clear();
                 }
             }
         }
@@ -27,35 +27,55 @@ void JEventProcessorArrow::execute(JArrowMetrics& result, size_t location_id) {
 
     auto start_total_time = std::chrono::steady_clock::now();
 
+    // Pop and recycle events a chunk at a time, so that each chunk costs one lock round-trip on the input queue
+    // and one on the event pool (or output queue), instead of one of each per event. The buffer is thread_local
+    // because this arrow is parallel; reusing it means chunking doesn't cost an allocation either.
+    // With a chunksize of 1 there is nothing to amortize, and the single-item pop and put are cheaper.
+    thread_local std::vector<Event> events;
+
+    size_t chunksize = get_chunksize();
+    size_t stolen_count;
+    size_t message_count;
     Event x;
-    bool success;
-    auto in_status = m_input_queue->pop(x, success, location_id);
+    EventQueue::Status in_status;
+    if (chunksize == 1) {
+        bool success;
+        in_status = m_input_queue->pop(x, success, location_id, stolen_count);
+        message_count = success;
+    }
+    else {
+        events.clear();
+        in_status = m_input_queue->pop(events, chunksize, location_id, stolen_count);
+        message_count = events.size();
+    }
     LOG_TRACE(m_logger) << "JEventProcessorArrow '" << get_name() << "' [" << location_id << "]: "
-                        << "pop() returned " << ((success) ? "success" : "failure")
+                        << "pop() returned " << message_count << " events"
                         << "; queue is now " << in_status << LOG_END;
 
     auto start_latency_time = std::chrono::steady_clock::now();
-    if (success) {
-        LOG_DEBUG(m_logger) << "JEventProcessorArrow '" << get_name() << "': Starting event# " << x->GetEventNumber() << LOG_END;
-        for (JEventProcessor* processor : m_processors) {
-            JCallGraphEntryMaker cg_entry(*x->GetJCallGraphRecorder(), processor->GetTypeName()); // times execution until this goes out of scope
-            processor->DoMap(x);
-        }
-        LOG_DEBUG(m_logger) << "JEventProcessorArrow '" << get_name() << "': Finished event# " << x->GetEventNumber() << LOG_END;
+    if (chunksize == 1) {
+        if (message_count == 1) process(x);
+    }
+    else {
+        for (Event& event : events) process(event);
     }
     auto end_latency_time = std::chrono::steady_clock::now();
 
     auto out_status = EventQueue::Status::Ready;
-
-    if (success) {
+    if (message_count > 0) {
         if (m_output_queue != nullptr) {
-            // This is NOT the last arrow in the topology. Pass the event onwards.
-            out_status = m_output_queue->push(x, location_id);
+            // This is NOT the last arrow in the topology. Pass the events onwards.
+            out_status = (chunksize == 1) ? m_output_queue->push(x, 0, location_id)
+                                          : m_output_queue->push(events, 0, location_id);
         }
         else {
-            // This IS the last arrow in the topology. Notify the event source and return event to the pool.
-            if( auto es = x->GetJEventSource() ) es->DoFinish(*x);
-            m_pool->put(x, location_id);
+            // This IS the last arrow in the topology. Return the events to the pool.
+            if (chunksize == 1) {
+                m_pool->put(x, location_id);
+            }
+            else {
+                m_pool->put_many(events, location_id);
+            }
         }
     }
     auto end_queue_time = std::chrono::steady_clock::now();
@@ -72,7 +92,31 @@ void JEventProcessorArrow::execute(JArrowMetrics& result, size_t location_id) {
     }
     auto latency = (end_latency_time - start_latency_time);
     auto overhead = (end_queue_time - start_total_time) - latency;
-    result.update(status, success, 1, latency, overhead);
+    result.update(status, message_count, 1, latency, overhead);
+    result.update_steal_count(stolen_count);
+}
+
+void JEventProcessorArrow::process(Event& x) {
+    auto start_time = std::chrono::steady_clock::now();
+    LOG_DEBUG(m_logger) << "JEventProcessorArrow '" << get_name() << "': Starting event# " << x->GetEventNumber() << LOG_END;
+    auto mode = JFactoryTaskGraph::Mode::Serial;
+    if (m_factory_graph != nullptr) {
+        mode = m_factory_graph->prefetch(x);
+    }
+    for (JEventProcessor* processor : m_processors) {
+        JCallGraphEntryMaker cg_entry(*x->GetJCallGraphRecorder(), processor->GetTypeName()); // times execution until this goes out of scope
+        processor->DoMap(x);
+    }
+    if (mode == JFactoryTaskGraph::Mode::Learn) {
+        m_factory_graph->learn(x);
+    }
+    LOG_DEBUG(m_logger) << "JEventProcessorArrow '" << get_name() << "': Finished event# " << x->GetEventNumber() << LOG_END;
+    get_latency_histogram().record(std::chrono::steady_clock::now() - start_time);
+
+    if (m_output_queue == nullptr) {
+        // This IS the last arrow in the topology. Notify the event source as soon as each event is done.
+        if( auto es = x->GetJEventSource() ) es->DoFinish(*x);
+    }
 }
 
 void JEventProcessorArrow::initialize() {
@@ -104,3 +148,11 @@ void JEventProcessorArrow::set_threshold(size_t threshold) {
     m_input_queue->set_threshold(threshold);
 }
 
+bool JEventProcessorArrow::park(duration_t timeout, size_t location_id) {
+    m_input_queue->wait_for_push(location_id, timeout);
+    return true;
+}
+
+void JEventProcessorArrow::unpark() {
+    m_input_queue->wake_all();
+}
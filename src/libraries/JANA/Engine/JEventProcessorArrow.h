@@ -9,6 +9,7 @@
 #include <JANA/JEventProcessor.h>
 #include <JANA/Engine/JArrow.h>
 #include <JANA/Engine/JMailbox.h>
+#include <JANA/Engine/JFactoryTaskGraph.h>
 
 class JEventPool;
 
@@ -23,6 +24,9 @@ private:
     EventQueue* m_input_queue;
     EventQueue* m_output_queue;
     std::shared_ptr<JEventPool> m_pool;
+    std::unique_ptr<JFactoryTaskGraph> m_factory_graph;  // Null unless jana:parallel_factories
+
+    void process(Event& event);
 
 public:
 
@@ -33,6 +37,11 @@ public:
 
     void add_processor(JEventProcessor* processor);
 
+    /// With a JFactoryTaskGraph, the factories behind the processors' declared collections get created
+    /// concurrently before the processors see each event
+    void set_factory_task_graph(std::unique_ptr<JFactoryTaskGraph> graph) { m_factory_graph = std::move(graph); }
+    JFactoryTaskGraph* get_factory_task_graph() { return m_factory_graph.get(); }
+
     void initialize() final;
     void finalize() final;
     void execute(JArrowMetrics& result, size_t location_id) final;
@@ -41,6 +50,9 @@ public:
     size_t get_threshold() final;
     void set_threshold(size_t) final;
 
+    bool park(duration_t timeout, size_t location_id) final;
+    void unpark() final;
+
 };
 
 
@@ -0,0 +1,140 @@
+
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+
+#include <JANA/Engine/JEventReorderArrow.h>
+#include <JANA/Utils/JEventPool.h>
+#include <JANA/JEventProcessor.h>
+#include <JANA/JEventSource.h>
+
+
+JEventReorderArrow::JEventReorderArrow(std::string name,
+                                       EventQueue *input_queue,
+                                       size_t window,
+                                       std::shared_ptr<JEventPool> pool)
+        : JArrow(std::move(name), false, NodeType::Sink)
+        , m_input_queue(input_queue)
+        , m_pool(std::move(pool))
+        , m_window(std::max<size_t>(window, 1)) {
+
+    m_slots.resize(m_window);
+}
+
+void JEventReorderArrow::add_processor(JEventProcessor* processor) {
+    m_processors.push_back(processor);
+}
+
+void JEventReorderArrow::execute(JArrowMetrics& result, size_t location_id) {
+
+    auto start_total_time = clock_t::now();
+
+    // Every event has to pass through here, no matter which location processed it, so pop from all locations,
+    // starting with our own.
+    auto chunksize = get_chunksize();
+    auto location_count = m_input_queue->get_locations_count();
+    auto in_status = EventQueue::Status::Empty;
+    m_popped.clear();
+    for (size_t i=0; i<location_count && m_popped.size() < chunksize; ++i) {
+        auto status = m_input_queue->pop(m_popped, chunksize - m_popped.size(), (location_id + i) % location_count);
+        if (status == EventQueue::Status::Ready || status == EventQueue::Status::Full) {
+            in_status = EventQueue::Status::Ready;
+        }
+    }
+
+    auto start_latency_time = clock_t::now();
+    for (Event& event : m_popped) {
+        auto index = event->GetEventIndex();
+        auto next_index = m_next_index.load();
+        if (index < next_index || index - next_index >= m_window) {
+            throw JException("JEventReorderArrow: Event index %llu is outside of reorder window [%llu, %llu)",
+                             (unsigned long long) index, (unsigned long long) next_index,
+                             (unsigned long long) (next_index + m_window));
+        }
+        m_slots[index % m_window] = std::move(event);
+        m_depth++;
+    }
+    if (m_depth > m_max_depth) m_max_depth = m_depth.load();
+
+    // Release the contiguous run of events starting at m_next_index
+    m_released.clear();
+    while (true) {
+        auto& slot = m_slots[m_next_index % m_window];
+        if (slot == nullptr) break;
+        process(slot);
+        m_released.push_back(std::move(slot));
+        slot = nullptr;
+        m_depth--;
+        m_next_index++;  // Lets the source emit one more event
+    }
+    auto end_latency_time = clock_t::now();
+
+    // Anything still held back is waiting on an earlier event which some worker hasn't finished yet
+    if (m_is_stalled && !m_released.empty()) {
+        m_stall_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end_latency_time - m_stall_start).count();
+        m_is_stalled = false;
+    }
+    if (!m_is_stalled && m_depth > 0) {
+        m_is_stalled = true;
+        m_stall_start = end_latency_time;
+    }
+
+    auto message_count = m_released.size();
+    if (message_count > 0) {
+        m_pool->put_many(m_released, location_id);
+    }
+    auto end_queue_time = clock_t::now();
+
+    LOG_TRACE(m_logger) << "JEventReorderArrow '" << get_name() << "' [" << location_id << "]: "
+                        << "popped " << m_popped.size() << ", released " << message_count
+                        << ", holding " << m_depth.load() << LOG_END;
+
+    auto status = (message_count > 0 || in_status == EventQueue::Status::Ready)
+                  ? JArrowMetrics::Status::KeepGoing
+                  : JArrowMetrics::Status::ComeBackLater;
+
+    auto latency = (end_latency_time - start_latency_time);
+    auto overhead = (end_queue_time - start_total_time) - latency;
+    result.update(status, message_count, 1, latency, overhead);
+}
+
+void JEventReorderArrow::process(Event& x) {
+    LOG_DEBUG(m_logger) << "JEventReorderArrow '" << get_name() << "': Starting event# " << x->GetEventNumber() << LOG_END;
+    for (JEventProcessor* processor : m_processors) {
+        JCallGraphEntryMaker cg_entry(*x->GetJCallGraphRecorder(), processor->GetTypeName()); // times execution until this goes out of scope
+        processor->DoMap(x);
+    }
+    LOG_DEBUG(m_logger) << "JEventReorderArrow '" << get_name() << "': Finished event# " << x->GetEventNumber() << LOG_END;
+
+    // This is the last arrow in the topology. Notify the event source as soon as each event is done.
+    if( auto es = x->GetJEventSource() ) es->DoFinish(*x);
+}
+
+void JEventReorderArrow::initialize() {
+
+    LOG_DEBUG(m_logger) << "Initializing arrow '" << get_name() << "'" << LOG_END;
+    for (auto processor : m_processors) {
+        processor->DoInitialize();
+        LOG_INFO(m_logger) << "Initialized JEventProcessor '" << processor->GetType() << "'" << LOG_END;
+    }
+}
+
+void JEventReorderArrow::finalize() {
+    LOG_DEBUG(m_logger) << "Finalizing arrow '" << get_name() << "'" << LOG_END;
+    for (auto processor : m_processors) {
+        processor->DoFinalize();
+        LOG_INFO(m_logger) << "Finalized JEventProcessor '" << processor->GetType() << "'" << LOG_END;
+    }
+}
+
+size_t JEventReorderArrow::get_pending() {
+    return m_input_queue->size() + m_depth;
+}
+
+size_t JEventReorderArrow::get_threshold() {
+    return m_input_queue->get_threshold();
+}
+
+void JEventReorderArrow::set_threshold(size_t threshold) {
+    m_input_queue->set_threshold(threshold);
+}
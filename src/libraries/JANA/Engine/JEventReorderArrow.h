@@ -0,0 +1,77 @@
+
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JEVENTREORDERARROW_H
+#define JANA2_JEVENTREORDERARROW_H
+
+
+#include <JANA/JEventProcessor.h>
+#include <JANA/Engine/JArrow.h>
+#include <JANA/Engine/JMailbox.h>
+
+class JEventPool;
+
+/// JEventReorderArrow runs the JEventProcessors which called SetEventsOrdered(true). Events arrive from the
+/// parallel JEventProcessorArrow in whatever order the workers happened to finish them, so this arrow first
+/// parks them in a reorder buffer, indexed by JEvent::GetEventIndex(), and only hands an event to its processors
+/// once every event before it has been handed over. The buffer is a fixed window of slots: JEventSourceArrow
+/// won't emit an event until admits() says there is a slot for it, which bounds both the memory held here and
+/// how far the sources may run ahead of the slowest event.
+class JEventReorderArrow : public JArrow {
+
+public:
+    using Event = std::shared_ptr<JEvent>;
+    using EventQueue = JMailbox<Event>;
+    using clock_t = std::chrono::steady_clock;
+
+private:
+    std::vector<JEventProcessor*> m_processors;
+    EventQueue* m_input_queue;
+    std::shared_ptr<JEventPool> m_pool;
+
+    // Only the thread currently executing this (sequential) arrow touches these
+    std::vector<Event> m_slots;         // m_slots[index % window] holds the event with that index, if it has arrived
+    std::vector<Event> m_popped;
+    std::vector<Event> m_released;
+    bool m_is_stalled = false;
+    clock_t::time_point m_stall_start;
+
+    // These are read by other threads: the source arrow and measure_internal_performance()
+    const size_t m_window;
+    std::atomic<uint64_t> m_next_index {0};      // Index of the next event to release
+    std::atomic<size_t> m_depth {0};             // Events currently held back in the buffer
+    std::atomic<size_t> m_max_depth {0};
+    std::atomic<int64_t> m_stall_time_ns {0};    // Time spent holding events while an earlier one was in flight
+
+    void process(Event& event);
+
+public:
+
+    JEventReorderArrow(std::string name,
+                       EventQueue *input_queue,
+                       size_t window,
+                       std::shared_ptr<JEventPool> pool);
+
+    void add_processor(JEventProcessor* processor);
+
+    /// admits() tells the source arrow whether the event with the given index would fit in the window.
+    /// The next event to be released always fits, so this can't deadlock.
+    bool admits(uint64_t event_index) const { return event_index < m_next_index.load() + m_window; }
+
+    size_t get_window() const { return m_window; }
+    size_t get_depth() const { return m_depth; }
+    size_t get_max_depth() const { return m_max_depth; }
+    duration_t get_stall_time() const { return std::chrono::nanoseconds(m_stall_time_ns.load()); }
+
+    void initialize() final;
+    void finalize() final;
+    void execute(JArrowMetrics& result, size_t location_id) final;
+
+    size_t get_pending() final;
+    size_t get_threshold() final;
+    void set_threshold(size_t) final;
+};
+
+
+#endif //JANA2_JEVENTREORDERARROW_H
@@ -6,6 +6,7 @@
 #include <JANA/JApplication.h>
 #include <JANA/JEventSource.h>
 #include <JANA/Engine/JEventSourceArrow.h>
+#include <JANA/Engine/JEventReorderArrow.h>
 #include <JANA/Utils/JEventPool.h>
 
 
@@ -43,8 +44,14 @@ void JEventSourceArrow::execute(JArrowMetrics& result, size_t location_id) {
     }
     else {
         for (size_t i=0; i<emit_count && in_status==JEventSource::ReturnStatus::Success; ++i) {
+            if (!try_claim_index()) {
+                // The reorder buffer is still waiting on an earlier event, so don't run any further ahead
+                in_status = JEventSource::ReturnStatus::TryAgain;
+                break;
+            }
             auto event = m_pool->get(location_id);
             if (event == nullptr) {
+                m_indexer->claimed--;
                 in_status = JEventSource::ReturnStatus::TryAgain;
                 break;
             }
@@ -52,6 +59,7 @@ void JEventSourceArrow::execute(JArrowMetrics& result, size_t location_id) {
             // If there are no sources available then we are automatically finished.
             if( m_sources.empty() ) in_status = JEventSource::ReturnStatus::Finished;
             
+            auto event_start_time = std::chrono::steady_clock::now();
             while (m_current_source < m_sources.size()) {
                 in_status = m_sources[m_current_source]->DoNext(event);
 
@@ -65,9 +73,12 @@ void JEventSourceArrow::execute(JArrowMetrics& result, size_t location_id) {
                 }
             }
             if (in_status == JEventSource::ReturnStatus::Success) {
+                get_latency_histogram().record(std::chrono::steady_clock::now() - event_start_time);
+                event->SetEventIndex(m_indexer->assigned++);
                 m_chunk_buffer.push_back(std::move(event));
             }
             else {
+                m_indexer->claimed--;
                 m_pool->put(event, location_id);
             }
         }
@@ -105,6 +116,15 @@ void JEventSourceArrow::execute(JArrowMetrics& result, size_t location_id) {
     result.update(status, message_count, 1, latency, overhead);
 }
 
+bool JEventSourceArrow::try_claim_index() {
+    auto claimed = m_indexer->claimed.load();
+    do {
+        // Every assigned index is below some claim, so bounding the claims bounds the indices
+        if (m_reorder_arrow != nullptr && !m_reorder_arrow->admits(claimed)) return false;
+    } while (!m_indexer->claimed.compare_exchange_weak(claimed, claimed + 1));
+    return true;
+}
+
 void JEventSourceArrow::initialize() {
     // Initialization of individual sources happens on-demand, in order to keep us from having lots of open files
 }
@@ -15,17 +15,38 @@ using Event = std::shared_ptr<JEvent>;
 using EventQueue = JMailbox<Event>;
 
 class JEventPool;
+class JEventReorderArrow;
 
 class JEventSourceArrow : public JArrow {
+public:
+    /// EventIndexer hands out JEvent::GetEventIndex(). It is shared by every source arrow in a topology, so that
+    /// indices stay consecutive even when several arrows emit concurrently. An arrow claims an index before reading
+    /// an event (which is where the reorder window gets enforced), but only assigns one once the read succeeds,
+    /// so that failed reads don't leave holes.
+    struct EventIndexer {
+        std::atomic<uint64_t> claimed {0};
+        std::atomic<uint64_t> assigned {0};
+    };
+
 private:
     std::vector<JEventSource*> m_sources;
     size_t m_current_source = 0;
     EventQueue* m_output_queue;
     std::shared_ptr<JEventPool> m_pool;
     std::vector<Event> m_chunk_buffer;
+    std::shared_ptr<EventIndexer> m_indexer = std::make_shared<EventIndexer>();
+    const JEventReorderArrow* m_reorder_arrow = nullptr;
+
+    bool try_claim_index();
 
 public:
     JEventSourceArrow(std::string name, std::vector<JEventSource*> sources, EventQueue* output_queue, std::shared_ptr<JEventPool> pool);
+
+    /// set_reorder_arrow() makes this arrow hold back any event which wouldn't fit in the reorder arrow's window
+    void set_reorder_arrow(const JEventReorderArrow* reorder_arrow) { m_reorder_arrow = reorder_arrow; }
+
+    void set_event_indexer(std::shared_ptr<EventIndexer> indexer) { m_indexer = std::move(indexer); }
+
     void initialize() final;
     void finalize() final;
     void execute(JArrowMetrics& result, size_t location_id) final;
@@ -0,0 +1,193 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include <JANA/Engine/JFactoryTaskGraph.h>
+#include <JANA/JEvent.h>
+#include <JANA/JEventProcessor.h>
+
+#include <algorithm>
+#include <map>
+
+namespace {
+
+/// Everything the tasks of one event share. Tasks hold on to it, so it outlives whichever of them finishes last.
+struct PrefetchState {
+    std::shared_ptr<const JEvent> event;
+    std::shared_ptr<const std::vector<JFactoryTaskGraph::Node>> plan;
+    JFactoryTaskPool* pool = nullptr;
+    std::vector<JFactory*> factories;                     // Same order as plan. Null if this event doesn't have it
+    std::unique_ptr<std::atomic_size_t[]> remaining;      // Dependencies of each node which haven't finished yet
+    std::atomic_size_t unfinished {0};
+    std::atomic_bool failed {false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+};
+
+void run_node(const std::shared_ptr<PrefetchState>& state, size_t index);
+
+JFactoryTaskPool::Task make_task(const std::shared_ptr<PrefetchState>& state, size_t index) {
+    return [state, index] { run_node(state, index); };
+}
+
+void run_node(const std::shared_ptr<PrefetchState>& state, size_t index) {
+    JFactory* factory = state->factories[index];
+    if (factory != nullptr && !state->failed) {
+        try {
+            factory->Create(state->event);
+        }
+        catch (...) {
+            // Remaining factories are skipped, and the worker waiting in prefetch() rethrows this
+            std::lock_guard<std::mutex> lock(state->error_mutex);
+            if (state->error == nullptr) state->error = std::current_exception();
+            state->failed = true;
+        }
+    }
+    std::vector<JFactoryTaskPool::Task> ready;
+    for (size_t dependent : (*state->plan)[index].dependents) {
+        if (--state->remaining[dependent] == 0) ready.push_back(make_task(state, dependent));
+    }
+    state->pool->submit(ready);
+    if (--state->unfinished == 0) state->pool->notify_all();
+}
+
+} // namespace
+
+
+JFactoryTaskGraph::JFactoryTaskGraph(const std::vector<JEventProcessor*>& processors, JFactoryTaskPool* pool,
+                                     size_t learning_events, JLogger logger)
+        : m_pool(pool)
+        , m_logger(std::move(logger))
+        , m_learning_slots(std::max<size_t>(learning_events, 1))
+        , m_learning_events(std::max<size_t>(learning_events, 1)) {
+
+    for (auto processor : processors) {
+        for (auto& collection : processor->GetPrefetchedCollections()) {
+            if (std::find(m_roots.begin(), m_roots.end(), collection) == m_roots.end()) {
+                m_roots.push_back(collection);
+            }
+        }
+    }
+}
+
+JFactoryTaskGraph::Mode JFactoryTaskGraph::prefetch(const std::shared_ptr<const JEvent>& event) {
+
+    auto plan = std::atomic_load(&m_plan);
+    if (plan == nullptr) {
+        if (m_learning_slots.fetch_sub(1) > 0) {
+            event->GetJCallGraphRecorder()->SetEnabled(true);
+            return Mode::Learn;
+        }
+        // Every learning event is taken but they haven't all finished yet
+        return Mode::Serial;
+    }
+    if (plan->empty()) return Mode::Serial;
+
+    auto state = std::make_shared<PrefetchState>();
+    state->event = event;
+    state->plan = plan;
+    state->pool = m_pool;
+    state->remaining.reset(new std::atomic_size_t[plan->size()]);
+    state->unfinished = plan->size();
+
+    std::vector<JFactoryTaskPool::Task> ready;
+    for (size_t i=0; i<plan->size(); ++i) {
+        auto& node = (*plan)[i];
+        state->factories.push_back(event->GetFactory(node.name.first, node.name.second));
+        state->remaining[i] = node.dependency_count;
+    }
+    for (size_t i=0; i<plan->size(); ++i) {
+        if ((*plan)[i].dependency_count == 0) ready.push_back(make_task(state, i));
+    }
+    m_pool->submit(ready);
+
+    // Help out until our own factories are done. This may run other events' tasks too, which is fine.
+    m_pool->run_until([&] { return state->unfinished == 0; });
+    m_parallel_event_count++;
+
+    if (state->error != nullptr) std::rethrow_exception(state->error);
+    return Mode::Parallel;
+}
+
+void JFactoryTaskGraph::learn(const std::shared_ptr<const JEvent>& event) {
+
+    auto recorder = event->GetJCallGraphRecorder();
+    std::lock_guard<std::mutex> lock(m_learning_mutex);
+    for (auto& node : recorder->GetCallGraph()) {
+        m_learned_edges.insert({{node.caller_name, node.caller_tag}, {node.callee_name, node.callee_tag}});
+    }
+    recorder->SetEnabled(false);
+
+    if (++m_learned_events == m_learning_events) {
+        auto plan = build_plan(*event);
+        LOG_INFO(m_logger) << "Parallel factories: learned " << plan->size() << " factories to prefetch from "
+                           << m_learned_events << " events" << LOG_END;
+        std::atomic_store(&m_plan, std::shared_ptr<const std::vector<Node>>(std::move(plan)));
+    }
+}
+
+std::shared_ptr<const std::vector<JFactoryTaskGraph::Node>> JFactoryTaskGraph::build_plan(const JEvent& event) {
+
+    // Declared collections without a tag get the default tag, just like JEvent::Get() would give them
+    std::vector<FactoryName> roots;
+    for (auto root : m_roots) {
+        if (root.second.empty()) {
+            auto default_tag = event.GetDefaultTags().find(root.first);
+            if (default_tag != event.GetDefaultTags().end()) root.second = default_tag->second;
+        }
+        roots.push_back(root);
+    }
+
+    JCallGraphRecorder learned;
+    learned.SetEnabled(true);
+    std::map<FactoryName, std::vector<FactoryName>> callees;
+    std::set<FactoryName> graph_nodes;
+    for (auto& edge : m_learned_edges) {
+        learned.AddToCallGraph({edge.first.first, edge.first.second, edge.second.first, edge.second.second});
+        callees[edge.first].push_back(edge.second);
+        graph_nodes.insert(edge.first);
+        graph_nodes.insert(edge.second);
+    }
+    auto sorted = learned.TopologicalSort();
+    if (sorted.size() < graph_nodes.size()) {
+        LOG_ERROR(m_logger) << "Parallel factories: the factories call each other in a cycle, so they will keep running serially" << LOG_END;
+        return std::make_shared<std::vector<Node>>();
+    }
+
+    // Everything the declared collections need, directly or indirectly
+    std::set<FactoryName> needed(roots.begin(), roots.end());
+    std::vector<FactoryName> frontier(roots.begin(), roots.end());
+    while (!frontier.empty()) {
+        auto name = frontier.back();
+        frontier.pop_back();
+        for (auto& callee : callees[name]) {
+            if (needed.insert(callee).second) frontier.push_back(callee);
+        }
+    }
+
+    // Dependencies first. Declared collections which never showed up in a call graph depend on nothing.
+    auto plan = std::make_shared<std::vector<Node>>();
+    std::map<FactoryName, size_t> indices;
+    auto add_node = [&](const FactoryName& name) {
+        if (needed.count(name) == 0 || indices.count(name) != 0) return;
+        indices[name] = plan->size();
+        plan->emplace_back();
+        plan->back().name = name;
+    };
+    for (auto& name : sorted) add_node(name);
+    for (auto& name : roots) add_node(name);
+
+    for (auto& edge : m_learned_edges) {
+        auto caller = indices.find(edge.first);
+        auto callee = indices.find(edge.second);
+        if (caller == indices.end() || callee == indices.end()) continue;
+        (*plan)[caller->second].dependency_count++;
+        (*plan)[callee->second].dependents.push_back(caller->second);
+    }
+    return plan;
+}
+
+std::vector<JFactoryTaskGraph::Node> JFactoryTaskGraph::get_plan() const {
+    auto plan = std::atomic_load(&m_plan);
+    if (plan == nullptr) return {};
+    return *plan;
+}
@@ -0,0 +1,80 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JFACTORYTASKGRAPH_H
+#define JANA2_JFACTORYTASKGRAPH_H
+
+#include <JANA/Engine/JFactoryTaskPool.h>
+#include <JANA/Services/JLoggingService.h>
+#include <JANA/Utils/JCallGraphRecorder.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+class JEvent;
+class JEventProcessor;
+
+/// JFactoryTaskGraph creates the collections which a set of JEventProcessors declared with DeclarePrefetch(),
+/// running the independent factories of one event concurrently on a JFactoryTaskPool.
+///
+/// The dependencies between factories are learned rather than declared: the first few events run serially with
+/// call graph recording switched on, and the union of their call graphs is put in order with
+/// JCallGraphRecorder::TopologicalSort(). From then on, each event starts every factory whose dependencies have
+/// all been created, and starts the factories depending on it as soon as it finishes. A dependency which the
+/// learning events didn't exercise is harmless, because the factory which needs it simply creates it inline
+/// (or waits for whoever is creating it, see JFactory::Create).
+///
+/// Factories which run concurrently mustn't Insert() into collections which have no factory of their own,
+/// since that adds to the event's JFactorySet while other factories are looking things up in it.
+class JFactoryTaskGraph {
+public:
+    enum class Mode { Serial, Learn, Parallel };
+
+    using FactoryName = std::pair<std::string, std::string>;  // (object name, tag)
+
+    struct Node {
+        FactoryName name;
+        size_t dependency_count = 0;     // How many other nodes this one calls
+        std::vector<size_t> dependents;  // The nodes which call this one
+    };
+
+private:
+    std::vector<FactoryName> m_roots;
+    JFactoryTaskPool* m_pool;
+    JLogger m_logger;
+
+    std::atomic<int64_t> m_learning_slots;    // Learning events which haven't started yet
+    size_t m_learning_events;
+    size_t m_learned_events = 0;
+    std::set<std::pair<FactoryName, FactoryName>> m_learned_edges;  // (caller, callee)
+    std::mutex m_learning_mutex;
+
+    std::shared_ptr<const std::vector<Node>> m_plan;  // Dependencies first. Null until learning is done.
+    std::atomic_size_t m_parallel_event_count {0};
+
+    std::shared_ptr<const std::vector<Node>> build_plan(const JEvent& event);
+
+public:
+    JFactoryTaskGraph(const std::vector<JEventProcessor*>& processors, JFactoryTaskPool* pool,
+                      size_t learning_events, JLogger logger);
+
+    /// prefetch() is called before the processors see the event. In Parallel mode it has already created every
+    /// declared collection by the time it returns, and rethrows the first exception any factory threw. In Learn mode
+    /// it has switched on the event's call graph recording, and learn() must be called once the processors are done.
+    Mode prefetch(const std::shared_ptr<const JEvent>& event);
+
+    void learn(const std::shared_ptr<const JEvent>& event);
+
+    const std::vector<FactoryName>& get_roots() const { return m_roots; }
+
+    /// The factories which prefetch() creates in Parallel mode, dependencies first. Empty while still learning.
+    std::vector<Node> get_plan() const;
+
+    size_t get_parallel_event_count() const { return m_parallel_event_count; }
+};
+
+#endif //JANA2_JFACTORYTASKGRAPH_H
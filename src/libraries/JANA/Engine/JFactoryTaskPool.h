@@ -0,0 +1,84 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JFACTORYTASKPOOL_H
+#define JANA2_JFACTORYTASKPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/// JFactoryTaskPool holds the factory tasks of every event which is currently being prefetched in parallel
+/// (see JFactoryTaskGraph). Each task creates one factory for one event. Any worker may run them: the worker which
+/// is waiting on its own event's factories, and workers which have run out of events (see JWorker::loop).
+class JFactoryTaskPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    std::deque<Task> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::atomic_size_t m_pending {0};
+    std::atomic_size_t m_tasks_run {0};
+    std::function<void()> m_wake_workers;
+
+public:
+    /// set_wake_callback() tells the pool how to rouse workers which are parked waiting for events,
+    /// so that they come and help as soon as there are tasks
+    void set_wake_callback(std::function<void()> wake_workers) {
+        m_wake_workers = std::move(wake_workers);
+    }
+
+    void submit(std::vector<Task>& tasks) {
+        if (tasks.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& task : tasks) m_tasks.push_back(std::move(task));
+            m_pending += tasks.size();
+        }
+        tasks.clear();
+        m_cv.notify_all();
+        if (m_wake_workers) m_wake_workers();
+    }
+
+    /// run_one() runs the oldest task, if there is any. Returns false if there wasn't.
+    bool run_one() {
+        if (m_pending.load(std::memory_order_relaxed) == 0) return false;
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_tasks.empty()) return false;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            m_pending--;
+        }
+        task();
+        m_tasks_run++;
+        return true;
+    }
+
+    /// run_until() runs tasks, from any event, until done() is true. In between tasks it sleeps until
+    /// somebody calls submit() or notify_all().
+    void run_until(const std::function<bool()>& done) {
+        while (!done()) {
+            if (run_one()) continue;
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [&] { return !m_tasks.empty() || done(); });
+        }
+    }
+
+    /// notify_all() wakes everybody in run_until(), so that they check their done() again
+    void notify_all() {
+        { std::lock_guard<std::mutex> lock(m_mutex); }
+        m_cv.notify_all();
+    }
+
+    size_t get_pending() const { return m_pending.load(std::memory_order_relaxed); }
+    size_t get_tasks_run() const { return m_tasks_run.load(std::memory_order_relaxed); }
+};
+
+#endif //JANA2_JFACTORYTASKPOOL_H
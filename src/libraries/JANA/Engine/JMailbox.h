@@ -8,7 +8,13 @@
 
 #include <queue>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <vector>
 #include <JANA/Services/JLoggingService.h>
+#include <JANA/Engine/JRingBuffer.h>
 
 /// JMailbox is a threadsafe event queue designed for communication between Arrows.
 /// It is different from the standard data structure in the following ways:
@@ -18,6 +24,9 @@
 ///   - when the .reserve() method is used, the queue size is bounded
 ///   - the underlying queue may be shared by all threads, NUMA-domain-local, or thread-local
 ///   - the Arrow doesn't have to know anything about locality.
+///   - the underlying storage is either a mutex-protected deque or a lock-free ring buffer (see JMailboxBackend)
+///   - threads which find the queue empty may park in wait_for_push() until somebody pushes
+///   - optionally, the queue tracks the estimated bytes it holds and refuses reservations beyond a byte budget
 ///
 /// To handle memory locality at different granularities, we introduce the concept of a domain.
 /// Each thread belongs to exactly one domain. Domains are represented by contiguous unsigned
@@ -28,14 +37,28 @@
 ///
 /// Improvements:
 ///   1. Pad DomainLocalMailbox
-///   2. Enable work stealing
-///   3. Triple mutex trick to give push() priority?
+///   2. Triple mutex trick to give push() priority?
 
 
 #ifndef CACHE_LINE_BYTES
 #define CACHE_LINE_BYTES 64
 #endif
 
+/// JMailboxBackend selects the storage behind each location of a JMailbox.
+///   - Deque: std::deque guarded by a mutex. pop() uses try_lock, so it reports Congested under contention.
+///   - RingBuffer: a bounded lock-free JRingBuffer sized to twice the threshold. Pushes which don't fit
+///     (because the caller didn't reserve, or the threshold was raised afterwards) spill into the
+///     mutex-protected deque, so that push() still never fails.
+enum class JMailboxBackend { Deque, RingBuffer };
+
+inline std::ostream& operator<<(std::ostream& os, const JMailboxBackend& b) {
+    switch (b) {
+        case JMailboxBackend::Deque:      os << "deque"; break;
+        case JMailboxBackend::RingBuffer: os << "ringbuffer"; break;
+    }
+    return os;
+}
+
 
 template <typename T>
 class JMailbox {
@@ -44,17 +67,35 @@ private:
 
     struct LocalMailbox {
         std::mutex mutex;
-        std::deque<T> queue;
+        std::deque<T> queue;              // Deque backend: everything. RingBuffer backend: overflow only.
         size_t reserved_count = 0;
+
+        // RingBuffer backend only
+        std::unique_ptr<JRingBuffer<T>> ring;
+        std::atomic<size_t> overflow_count {0};
+        std::atomic<size_t> ring_reserved_count {0};
     };
 
     // TODO: Copy these params into DLMB for better locality
     size_t m_threshold;
     size_t m_locations_count;
     bool m_enable_work_stealing = false;
+    JMailboxBackend m_backend = JMailboxBackend::Deque;
     std::unique_ptr<LocalMailbox[]> m_mailboxes;
+    std::vector<std::vector<size_t>> m_steal_orders;  // {thief location : [victim locations, nearest first]}
     JLogger m_logger;
 
+    // Parking. push() only touches the mutex when somebody is actually parked.
+    std::mutex m_park_mutex;
+    std::condition_variable m_park_cv;
+    std::atomic<size_t> m_parked_count {0};
+    std::atomic<size_t> m_push_epoch {0};
+
+    // Byte accounting. Only active once set_byte_budget() has provided an estimator.
+    std::function<size_t(const T&)> m_byte_estimator;
+    size_t m_max_bytes = 0;
+    std::atomic<int64_t> m_bytes {0};  // Signed, in case an item's estimate changed while it was queued
+
 public:
 
     enum class Status {Ready, Congested, Empty, Full};
@@ -74,12 +115,26 @@ public:
     /// threshold: the (soft) maximum number of items in the queue at any time
     /// domain_count: the number of domains
     /// enable_work_stealing: allow domains to pop from other domains' queues when theirs is empty
-    JMailbox(size_t threshold=100, size_t locations_count=1, bool enable_work_stealing=false)
+    /// backend: whether each domain is backed by a locked deque or a lock-free ring buffer
+    JMailbox(size_t threshold=100, size_t locations_count=1, bool enable_work_stealing=false,
+             JMailboxBackend backend=JMailboxBackend::Deque)
         : m_threshold(threshold)
         , m_locations_count(locations_count)
-        , m_enable_work_stealing(enable_work_stealing) {
+        , m_enable_work_stealing(enable_work_stealing)
+        , m_backend(backend) {
 
         m_mailboxes = std::unique_ptr<LocalMailbox[]>(new LocalMailbox[locations_count]);
+        m_steal_orders.resize(locations_count);
+        for (size_t thief=0; thief<locations_count; ++thief) {
+            for (size_t offset=1; offset<locations_count; ++offset) {
+                m_steal_orders[thief].push_back((thief + offset) % locations_count);
+            }
+        }
+        if (m_backend == JMailboxBackend::RingBuffer) {
+            for (size_t i=0; i<locations_count; ++i) {
+                m_mailboxes[i].ring = std::unique_ptr<JRingBuffer<T>>(new JRingBuffer<T>(2*threshold));
+            }
+        }
     }
 
     virtual ~JMailbox() {
@@ -92,6 +147,10 @@ public:
     size_t size() {
         size_t result = 0;
         for (size_t i = 0; i<m_locations_count; ++i) {
+            if (m_backend == JMailboxBackend::RingBuffer) {
+                result += size(i);
+                continue;
+            }
             std::lock_guard<std::mutex> lock(m_mailboxes[i].mutex);
             result += m_mailboxes[i].queue.size();
         }
@@ -101,9 +160,17 @@ public:
     /// size(domain) counts the number of items in the queue for a particular domain
     /// Meant to be used by Scheduler::next_assignment() and measure_perf(), eventually
     size_t size(size_t domain) {
-        return m_mailboxes[domain].queue.size();
+        auto& mb = m_mailboxes[domain];
+        if (m_backend == JMailboxBackend::RingBuffer) {
+            return mb.ring->size() + mb.overflow_count.load(std::memory_order_relaxed);
+        }
+        return mb.queue.size();
     }
 
+    JMailboxBackend get_backend() const { return m_backend; }
+
+    size_t get_locations_count() const { return m_locations_count; }
+
     /// reserve(requested_count) keeps our queues bounded in size. The caller should
     /// reserve their desired chunk size on the output queue first. The output
     /// queue will return a reservation which is less than or equal to requested_count.
@@ -113,9 +180,24 @@ public:
     /// alongside the items, to avoid a "reservation leak".
     size_t reserve(size_t requested_count, size_t domain = 0) {
 
+        if (m_max_bytes != 0 && m_bytes.load(std::memory_order_relaxed) >= static_cast<int64_t>(m_max_bytes)) {
+            return 0;
+        }
         LocalMailbox& mb = m_mailboxes[domain];
+        if (m_backend == JMailboxBackend::RingBuffer) {
+            size_t reserved = mb.ring_reserved_count.load(std::memory_order_relaxed);
+            while (true) {
+                size_t occupied = size(domain) + reserved;
+                if (occupied >= m_threshold) return 0;
+                size_t reservation = std::min(m_threshold - occupied, requested_count);
+                if (mb.ring_reserved_count.compare_exchange_weak(reserved, reserved + reservation)) {
+                    return reservation;
+                }
+            }
+        }
         std::lock_guard<std::mutex> lock(mb.mutex);
-        size_t doable_count = m_threshold - mb.queue.size() - mb.reserved_count;
+        size_t occupied_count = mb.queue.size() + mb.reserved_count;
+        size_t doable_count = (occupied_count < m_threshold) ? m_threshold - occupied_count : 0;
         if (doable_count > 0) {
             size_t reservation = std::min(doable_count, requested_count);
             mb.reserved_count += reservation;
@@ -131,44 +213,211 @@ public:
     Status push(std::vector<T>& buffer, size_t reserved_count = 0, size_t domain = 0) {
 
         auto& mb = m_mailboxes[domain];
-        std::lock_guard<std::mutex> lock(mb.mutex);
-        mb.reserved_count -= reserved_count;
-        for (const T& t : buffer) {
-             mb.queue.push_back(std::move(t));
+        if (m_byte_estimator) {
+            for (const T& t : buffer) add_bytes(t);
         }
-        buffer.clear();
-        if (mb.queue.size() > m_threshold) {
-            return Status::Full;
+        if (m_backend == JMailboxBackend::RingBuffer) {
+            bool pushed_anything = !buffer.empty();
+            for (T& t : buffer) {
+                push_to_ring(mb, t);
+            }
+            buffer.clear();
+            mb.ring_reserved_count -= reserved_count;
+            if (pushed_anything) notify_parked();
+            return (size(domain) > m_threshold) ? Status::Full : Status::Ready;
+        }
+        Status status;
+        bool pushed_anything = !buffer.empty();
+        {
+            std::lock_guard<std::mutex> lock(mb.mutex);
+            mb.reserved_count -= reserved_count;
+            for (const T& t : buffer) {
+                 mb.queue.push_back(std::move(t));
+            }
+            buffer.clear();
+            status = (mb.queue.size() > m_threshold) ? Status::Full : Status::Ready;
         }
-        return Status::Ready;
+        if (pushed_anything) notify_parked();
+        return status;
     }
 
     Status push(T& item, size_t reserved_count = 0, size_t domain = 0) {
 
         auto& mb = m_mailboxes[domain];
-        std::lock_guard<std::mutex> lock(mb.mutex);
-        mb.reserved_count -= reserved_count;
-        mb.queue.push_back(std::move(item));
-        size_t size = mb.queue.size();
-        if (size > m_threshold) {
-            return Status::Full;
+        if (m_byte_estimator) add_bytes(item);
+        if (m_backend == JMailboxBackend::RingBuffer) {
+            push_to_ring(mb, item);
+            mb.ring_reserved_count -= reserved_count;
+            notify_parked();
+            return (size(domain) > m_threshold) ? Status::Full : Status::Ready;
+        }
+        Status status;
+        {
+            std::lock_guard<std::mutex> lock(mb.mutex);
+            mb.reserved_count -= reserved_count;
+            mb.queue.push_back(std::move(item));
+            status = (mb.queue.size() > m_threshold) ? Status::Full : Status::Ready;
         }
-        return Status::Ready;
+        notify_parked();
+        return status;
     }
 
 
     /// pop() will pop up to requested_count items for the desired domain.
     /// If many threads are contending for the queue, this will fail with Status::Contention,
     /// in which case the caller should probably consult the Scheduler.
+    /// If work stealing is enabled and the local domain is empty, pop() takes items from the
+    /// other domains instead, nearest first (see set_steal_order()). stolen_count reports how
+    /// many of the returned items came from another domain.
     Status pop(std::vector<T>& buffer, size_t requested_count, size_t location_id = 0) {
+        size_t stolen_count;
+        return pop(buffer, requested_count, location_id, stolen_count);
+    }
+
+    Status pop(std::vector<T>& buffer, size_t requested_count, size_t location_id, size_t& stolen_count) {
+
+        stolen_count = 0;
+        size_t initial_size = buffer.size();
+        auto status = pop_local(buffer, requested_count, location_id);
+        if (!m_enable_work_stealing || status != Status::Empty || buffer.size() != initial_size) {
+            return status;
+        }
+        for (size_t victim : m_steal_orders[location_id]) {
+            auto victim_status = pop_local(buffer, requested_count, victim);
+            if (buffer.size() != initial_size) {
+                stolen_count = buffer.size() - initial_size;
+                return victim_status;
+            }
+        }
+        return status;
+    }
+
+    Status pop(T& item, bool& success, size_t location_id = 0) {
+        size_t stolen_count;
+        return pop(item, success, location_id, stolen_count);
+    }
+
+    Status pop(T& item, bool& success, size_t location_id, size_t& stolen_count) {
+
+        stolen_count = 0;
+        auto status = pop_local(item, success, location_id);
+        if (!m_enable_work_stealing || status != Status::Empty || success) {
+            return status;
+        }
+        for (size_t victim : m_steal_orders[location_id]) {
+            auto victim_status = pop_local(item, success, victim);
+            if (success) {
+                stolen_count = 1;
+                return victim_status;
+            }
+        }
+        return status;
+    }
+
+    /// set_steal_order() tells the given location which other locations to steal from, and in which order.
+    /// By default this is simply round-robin starting from the next location. JTopologyBuilder overrides it
+    /// with an order based on NUMA distance (see JProcessorMapping::get_steal_order()).
+    void set_steal_order(size_t location_id, std::vector<size_t> victims) {
+        m_steal_orders[location_id] = std::move(victims);
+    }
+
+    const std::vector<size_t>& get_steal_order(size_t location_id) const {
+        return m_steal_orders[location_id];
+    }
+
+    bool is_work_stealing_enabled() const { return m_enable_work_stealing; }
+
+
+    /// wait_for_push() parks the calling thread until another thread pushes onto this mailbox or calls wake_all(),
+    /// or until the timeout expires. It returns immediately if items are already available to this location
+    /// (including via work stealing). Returns false if it timed out. Because any push wakes every parked thread,
+    /// the caller must still expect pop() to come back empty-handed.
+    template <typename Rep, typename Period>
+    bool wait_for_push(size_t location_id, const std::chrono::duration<Rep, Period>& timeout) {
+
+        // Announce ourselves before looking at the queue, so that a concurrent push either is visible
+        // to has_items() or sees m_parked_count > 0 and notifies us. Either way, no wakeup is lost.
+        m_parked_count++;
+        size_t epoch = m_push_epoch.load();
+        bool woken = true;
+        if (!has_items(location_id)) {
+            std::unique_lock<std::mutex> lock(m_park_mutex);
+            woken = m_park_cv.wait_for(lock, timeout, [&]{ return m_push_epoch.load() != epoch; });
+        }
+        m_parked_count--;
+        return woken;
+    }
+
+    /// wake_all() releases every thread parked in wait_for_push(), e.g. because upstream has stopped
+    /// and nothing is ever going to be pushed.
+    void wake_all() {
+        notify_parked();
+    }
+
+    size_t get_parked_count() const { return m_parked_count; }
+
+    size_t get_threshold() { return m_threshold; }
+    void set_threshold(size_t threshold) { m_threshold = threshold; }
+
+    /// set_byte_budget() turns on byte accounting: estimator(item) is charged on push and credited on pop, and
+    /// reserve() refuses to hand out space while the queue holds max_bytes or more. max_bytes=0 only accounts.
+    /// Call this before any items are pushed.
+    void set_byte_budget(size_t max_bytes, std::function<size_t(const T&)> estimator) {
+        m_max_bytes = max_bytes;
+        m_byte_estimator = std::move(estimator);
+    }
+
+    /// get_bytes() is the estimated size of everything currently queued, or 0 without a byte estimator
+    size_t get_bytes() const {
+        auto bytes = m_bytes.load(std::memory_order_relaxed);
+        return (bytes > 0) ? bytes : 0;
+    }
+
+    size_t get_max_bytes() const { return m_max_bytes; }
+
+private:
+
+    void add_bytes(const T& item) {
+        m_bytes.fetch_add(static_cast<int64_t>(m_byte_estimator(item)), std::memory_order_relaxed);
+    }
+
+    void remove_bytes(const T& item) {
+        m_bytes.fetch_sub(static_cast<int64_t>(m_byte_estimator(item)), std::memory_order_relaxed);
+    }
+
+    /// pop_local() pops up to requested_count items from exactly one location, without stealing.
+    Status pop_local(std::vector<T>& buffer, size_t requested_count, size_t location_id) {
 
         auto& mb = m_mailboxes[location_id];
+        if (m_backend == JMailboxBackend::RingBuffer) {
+            bool congested = false;
+            size_t nitems = 0;
+            auto consume = [&](T&& t) {
+                if (m_byte_estimator) remove_bytes(t);
+                buffer.push_back(std::move(t));
+            };
+            while (nitems < requested_count && pop_from_ring(mb, consume, congested)) {
+                nitems++;
+            }
+            if (nitems == 0 && congested) {
+                return Status::Congested;
+            }
+            auto size = this->size(location_id);
+            if (size >= m_threshold) {
+                return Status::Full;
+            }
+            else if (size != 0) {
+                return Status::Ready;
+            }
+            return Status::Empty;
+        }
         if (!mb.mutex.try_lock()) {
             return Status::Congested;
         }
         auto nitems = std::min(requested_count, mb.queue.size());
         buffer.reserve(nitems);
         for (size_t i=0; i<nitems; ++i) {
+            if (m_byte_estimator) remove_bytes(mb.queue.front());
             buffer.push_back(std::move(mb.queue.front()));
             mb.queue.pop_front();
         }
@@ -184,14 +433,28 @@ public:
     }
 
 
-    Status pop(T& item, bool& success, size_t location_id = 0) {
+    Status pop_local(T& item, bool& success, size_t location_id) {
 
         success = false;
         auto& mb = m_mailboxes[location_id];
+        if (m_backend == JMailboxBackend::RingBuffer) {
+            bool congested = false;
+            success = pop_from_ring(mb, [&](T&& t) {
+                if (m_byte_estimator) remove_bytes(t);
+                item = std::move(t);
+            }, congested);
+            if (!success) {
+                return (congested) ? Status::Congested : Status::Empty;
+            }
+            return (size(location_id) != 0) ? Status::Ready : Status::Empty;
+        }
         if (!mb.mutex.try_lock()) {
             return Status::Congested;
         }
         size_t nitems = mb.queue.size();
+        if (nitems > 0 && m_byte_estimator) {
+            remove_bytes(mb.queue.front());
+        }
         if (nitems > 1) {
             item = std::move(mb.queue.front());
             mb.queue.pop_front();
@@ -211,8 +474,73 @@ public:
     }
 
 
-    size_t get_threshold() { return m_threshold; }
-    void set_threshold(size_t threshold) { m_threshold = threshold; }
+    void notify_parked() {
+        m_push_epoch++;
+        if (m_parked_count.load() > 0) {
+            // Taking the mutex ensures that a thread between its predicate check and its wait gets notified
+            { std::lock_guard<std::mutex> lock(m_park_mutex); }
+            m_park_cv.notify_all();
+        }
+    }
+
+    bool has_items(size_t location_id) {
+        if (has_local_items(location_id)) return true;
+        if (m_enable_work_stealing) {
+            for (size_t victim : m_steal_orders[location_id]) {
+                if (has_local_items(victim)) return true;
+            }
+        }
+        return false;
+    }
+
+    bool has_local_items(size_t location_id) {
+        auto& mb = m_mailboxes[location_id];
+        if (m_backend == JMailboxBackend::RingBuffer) {
+            return size(location_id) > 0;
+        }
+        std::lock_guard<std::mutex> lock(mb.mutex);
+        return !mb.queue.empty();
+    }
+
+    /// push_to_ring tries the lock-free path first. The ring only refuses an item when it is genuinely full,
+    /// which happens when the caller didn't reserve, or when a consumer was preempted halfway through a pop.
+    /// In that case the item spills into the mutex-protected overflow deque.
+    void push_to_ring(LocalMailbox& mb, T& item) {
+        if (mb.ring->try_push(item)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mb.mutex);
+        mb.queue.push_back(std::move(item));
+        mb.overflow_count++;
+    }
+
+    /// pop_from_ring drains any overflow first so that spilled items don't starve, but only if it can get the
+    /// overflow mutex without waiting. Otherwise it falls back to the ring. Like the Deque backend, it reports
+    /// congestion instead of blocking.
+    template <typename F>
+    bool pop_from_ring(LocalMailbox& mb, F&& consume, bool& congested) {
+        if (mb.overflow_count.load(std::memory_order_acquire) != 0) {
+            if (mb.mutex.try_lock()) {
+                bool success = false;
+                if (!mb.queue.empty()) {
+                    consume(std::move(mb.queue.front()));
+                    mb.queue.pop_front();
+                    mb.overflow_count--;
+                    success = true;
+                }
+                mb.mutex.unlock();
+                if (success) return true;
+            }
+            else if (mb.ring->try_pop_with(consume)) {
+                return true;
+            }
+            else {
+                congested = true;
+                return false;
+            }
+        }
+        return mb.ring->try_pop_with(consume);
+    }
 
 };
 
@@ -0,0 +1,131 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+
+#ifndef JANA2_JRINGBUFFER_H
+#define JANA2_JRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#ifndef CACHE_LINE_BYTES
+#define CACHE_LINE_BYTES 64
+#endif
+
+/// JRingBuffer is a bounded multi-producer, multi-consumer queue which never takes a lock.
+/// It follows Dmitry Vyukov's design: every cell carries a sequence number which tells producers
+/// and consumers whether the cell is ready to be written or read, so that each thread only needs
+/// a single compare-and-swap on the shared enqueue or dequeue position to claim a cell.
+///
+/// JRingBuffer is the building block for JMailbox's RingBuffer backend. It deliberately does not
+/// know anything about thresholds or reservations; JMailbox layers those on top.
+///
+/// \tparam T must be move-constructible. Usually this is shared_ptr<JEvent>.
+template <typename T>
+class JRingBuffer {
+
+private:
+    struct alignas(CACHE_LINE_BYTES) Cell {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage; // Only holds a live T between push and pop
+        T* data() { return reinterpret_cast<T*>(&storage); }
+    };
+
+    size_t m_capacity;
+    size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+
+    alignas(CACHE_LINE_BYTES) std::atomic<size_t> m_enqueue_pos {0};
+    alignas(CACHE_LINE_BYTES) std::atomic<size_t> m_dequeue_pos {0};
+
+public:
+
+    /// min_capacity gets rounded up to the next power of two so that indexing is a mask instead of a modulo
+    explicit JRingBuffer(size_t min_capacity) {
+        m_capacity = 2;
+        while (m_capacity < min_capacity) m_capacity *= 2;
+        m_mask = m_capacity - 1;
+        m_cells = std::unique_ptr<Cell[]>(new Cell[m_capacity]);
+        for (size_t i=0; i<m_capacity; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~JRingBuffer() {
+        auto noop = [](T&&) {};
+        while (try_pop_with(noop));
+    }
+
+    JRingBuffer(const JRingBuffer&) = delete;
+    JRingBuffer& operator=(const JRingBuffer&) = delete;
+
+    /// try_push moves item into the buffer and returns true, unless the buffer is full,
+    /// in which case it leaves item untouched and returns false.
+    bool try_push(T& item) {
+        Cell* cell;
+        size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false; // Full
+            }
+            else {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        new (&cell->storage) T(std::move(item));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// try_pop moves the oldest claimable item into item and returns true, unless the buffer is empty.
+    bool try_pop(T& item) {
+        return try_pop_with([&](T&& t) { item = std::move(t); });
+    }
+
+    /// try_pop_with hands the oldest claimable item to consume(T&&), which lets callers
+    /// move it straight into a container without T needing a default constructor.
+    template <typename F>
+    bool try_pop_with(F&& consume) {
+        Cell* cell;
+        size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false; // Empty
+            }
+            else {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        consume(std::move(*cell->data()));
+        cell->data()->~T();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// size() is only a snapshot, because other threads may push or pop concurrently.
+    size_t size() const {
+        size_t dequeue_pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        size_t enqueue_pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        return (enqueue_pos > dequeue_pos) ? enqueue_pos - dequeue_pos : 0;
+    }
+
+    size_t capacity() const { return m_capacity; }
+};
+
+
+#endif //JANA2_JRINGBUFFER_H
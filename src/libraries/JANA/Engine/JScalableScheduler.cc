@@ -0,0 +1,127 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include <JANA/Engine/JScalableScheduler.h>
+#include <JANA/Engine/JArrowTopology.h>
+
+
+JScalableScheduler::JScalableScheduler(std::shared_ptr<JArrowTopology> topology, size_t max_workers)
+    : JScheduler(std::move(topology))
+    , m_max_workers(max_workers == 0 ? 1 : max_workers)
+    {
+        m_worker_states = std::unique_ptr<WorkerState[]>(new WorkerState[m_max_workers]);
+        size_t arrow_count = m_topology->arrows.size();
+        for (size_t i=0; i<m_max_workers; ++i) {
+            // Spread workers out so that they don't all start by contending for the same arrow
+            m_worker_states[i].next_idx.store((arrow_count == 0) ? 0 : i % arrow_count, std::memory_order_relaxed);
+        }
+    }
+
+
+void JScalableScheduler::try_deactivate(JArrow* arrow) {
+
+    std::lock_guard<std::mutex> lock(m_deactivation_mutex);
+
+    // Re-check under the lock, since another worker may have gotten here first
+    if (arrow->get_status() != JArrow::Status::Running ||
+        arrow->get_type() == JArrow::NodeType::Source ||
+        arrow->get_running_upstreams() != 0 ||
+        arrow->get_pending() != 0 ||
+        arrow->get_thread_count() != 0) {
+        return;
+    }
+
+    LOG_DEBUG(logger) << "Deactivating arrow '" << arrow->get_name() << "' (" << m_topology->running_arrow_count - 1 << " remaining)" << LOG_END;
+    arrow->pause();
+    assert(m_topology->running_arrow_count >= 0);
+    if (m_topology->running_arrow_count == 0) {
+        LOG_DEBUG(logger) << "All arrows deactivated. Deactivating topology." << LOG_END;
+        m_topology->achieve_pause();
+    }
+}
+
+
+JArrow* JScalableScheduler::next_assignment(uint32_t worker_id, JArrow* assignment, JArrowMetrics::Status last_result) {
+
+    // Check latest arrow back in
+    if (assignment != nullptr) {
+        assignment->update_thread_count(-1);
+
+        if (assignment->get_running_upstreams() == 0 &&
+            assignment->get_pending() == 0 &&
+            assignment->get_thread_count() == 0 &&
+            assignment->get_type() != JArrow::NodeType::Source &&
+            assignment->get_status() == JArrow::Status::Running) {
+
+            try_deactivate(assignment);
+        }
+    }
+
+    // Choose a new arrow. Loop over all arrows, starting at where this worker last left off, and pick the first
+    // arrow that works
+    auto& arrows = m_topology->arrows;
+    size_t arrow_count = arrows.size();
+    if (arrow_count != 0) {
+        WorkerState& state = m_worker_states[worker_id % m_max_workers];
+        size_t start_idx = state.next_idx.load(std::memory_order_relaxed) % arrow_count;
+        if (m_policy == Policy::Backlog) {
+            start_idx = find_bottleneck(start_idx);
+        }
+        size_t current_idx = start_idx;
+        do {
+            JArrow* candidate = arrows[current_idx];
+            current_idx += 1;
+            current_idx %= arrow_count;
+
+            if (candidate->get_status() == JArrow::Status::Running &&
+                (candidate->is_parallel() || candidate->get_thread_count() == 0)) {
+
+                // Found a plausible candidate.
+
+                if (candidate->get_type() == JArrow::NodeType::Source ||
+                    candidate->get_running_upstreams() > 0 ||
+                    candidate->get_pending() > 0) {
+
+                    // Candidate still has work they can do, unless another worker just claimed this sequential arrow
+                    if (candidate->try_acquire_thread()) {
+                        state.next_idx.store(current_idx, std::memory_order_relaxed);
+
+                        LOG_DEBUG(logger) << "Worker " << worker_id << ", "
+                                          << ((assignment == nullptr) ? "idle" : assignment->get_name())
+                                          << ", " << to_string(last_result) << " => "
+                                          << candidate->get_name() << "  [" << candidate->get_thread_count() << " threads]" << LOG_END;
+                        return candidate;
+                    }
+                }
+                else if (candidate->get_thread_count() == 0) {
+                    // Candidate can be paused immediately because there is no more work coming
+                    try_deactivate(candidate);
+                }
+            }
+
+        } while (current_idx != start_idx);
+    }
+
+    if (m_topology->running_arrow_count == 0 && m_topology->m_current_status == JArrowTopology::Status::Running) {
+        // See JScheduler::next_assignment: this handles topologies which cannot self-exit
+        std::lock_guard<std::mutex> lock(m_deactivation_mutex);
+        if (m_topology->m_current_status == JArrowTopology::Status::Running) {
+            LOG_DEBUG(logger) << "No active arrows found. Deactivating topology." << LOG_END;
+            m_topology->achieve_pause();
+        }
+    }
+
+    return nullptr;  // We've looped through everything with no luck
+}
+
+
+void JScalableScheduler::last_assignment(uint32_t worker_id, JArrow* assignment, JArrowMetrics::Status result) {
+
+    LOG_DEBUG(logger) << "Worker " << worker_id << ", "
+                       << ((assignment == nullptr) ? "idle" : assignment->get_name())
+                       << ", " << to_string(result) << ") => Shutting down!" << LOG_END;
+    if (assignment != nullptr) {
+        assignment->update_thread_count(-1);
+    }
+}
+
@@ -0,0 +1,49 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JSCALABLESCHEDULER_H
+#define JANA2_JSCALABLESCHEDULER_H
+
+#include <JANA/Engine/JScheduler.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#ifndef CACHE_LINE_BYTES
+#define CACHE_LINE_BYTES 64
+#endif
+
+
+/// JScalableScheduler makes the same decisions as JScheduler, but without serializing every checkin
+/// behind a single mutex. Each worker keeps its own round-robin cursor on a separate cache line, and
+/// claims arrows by atomically updating the arrow's thread count, so that the common case (a worker
+/// hands back one arrow and receives another) never takes a lock. The mutex is only needed on the rare
+/// path where an arrow or the whole topology gets deactivated, since JArrow::pause() must not race with itself.
+///
+/// Because each worker starts from its own cursor rather than a shared one, the order in which arrows are
+/// handed out to a team of workers differs from JScheduler's strict round-robin.
+class JScalableScheduler : public JScheduler {
+
+public:
+    /// Worker ids beyond max_workers share cursors, which is harmless because the cursors are atomic.
+    explicit JScalableScheduler(std::shared_ptr<JArrowTopology> topology, size_t max_workers=256);
+
+    JArrow* next_assignment(uint32_t worker_id, JArrow* assignment, JArrowMetrics::Status result) override;
+
+    void last_assignment(uint32_t worker_id, JArrow* assignment, JArrowMetrics::Status result) override;
+
+private:
+    struct alignas(CACHE_LINE_BYTES) WorkerState {
+        std::atomic<size_t> next_idx {0};
+    };
+
+    std::unique_ptr<WorkerState[]> m_worker_states;
+    size_t m_max_workers;
+    std::mutex m_deactivation_mutex;
+
+    void try_deactivate(JArrow* arrow);
+};
+
+
+#endif //JANA2_JSCALABLESCHEDULER_H
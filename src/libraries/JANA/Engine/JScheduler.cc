@@ -6,6 +6,8 @@
 #include <JANA/Engine/JArrowTopology.h>
 #include <JANA/Services/JLoggingService.h>
 
+#include <algorithm>
+
 
 JScheduler::JScheduler(std::shared_ptr<JArrowTopology> topology)
     : m_topology(topology)
@@ -40,7 +42,11 @@ JArrow* JScheduler::next_assignment(uint32_t worker_id, JArrow* assignment, JArr
 
     // Choose a new arrow. Loop over all arrows, starting at where we last left off, and pick the first
     // arrow that works
-    size_t current_idx = m_next_idx;
+    size_t start_idx = m_next_idx;
+    if (m_policy == Policy::Backlog) {
+        start_idx = find_bottleneck(start_idx);
+    }
+    size_t current_idx = start_idx;
     do {
         JArrow* candidate = m_topology->arrows[current_idx];
         current_idx += 1;
@@ -67,8 +73,10 @@ JArrow* JScheduler::next_assignment(uint32_t worker_id, JArrow* assignment, JArr
                 return candidate;
 
             }
-            else {
-                // Candidate can be paused immediately because there is no more work coming
+            else if (candidate->get_thread_count() == 0) {
+                // Candidate can be paused immediately because there is no more work coming. We can't pause
+                // a parallel arrow which other workers are still executing, because their output would then
+                // land in a downstream queue which may already have been deactivated.
                 LOG_DEBUG(logger) << "Deactivating arrow '" << candidate->get_name() << "' (" << m_topology->running_arrow_count - 1 << " remaining)" << LOG_END;
                 candidate->pause();
                 assert(m_topology->running_arrow_count >= 0);
@@ -79,7 +87,7 @@ JArrow* JScheduler::next_assignment(uint32_t worker_id, JArrow* assignment, JArr
             }
         }
 
-    } while (current_idx != m_next_idx);
+    } while (current_idx != start_idx);
 
     if (m_topology->running_arrow_count == 0 && m_topology->m_current_status == JArrowTopology::Status::Running) {
         // This exists just in case the user provided a topology that cannot self-exit, e.g. because no event sources
@@ -108,4 +116,63 @@ void JScheduler::last_assignment(uint32_t worker_id, JArrow* assignment, JArrowM
 }
 
 
+double JScheduler::get_fill(JArrow* arrow) {
+    size_t pending = arrow->get_pending();
+    size_t threshold = arrow->get_threshold();
+    if (threshold == 0) {
+        return (pending > 0) ? 1.0 : 0.0;
+    }
+    return std::min(1.0, static_cast<double>(pending) / threshold);
+}
+
+
+double JScheduler::get_backlog_score(JArrow* arrow, double mean_latency) {
+
+    double output_fill = 0.0;
+    for (JArrow* listener : arrow->get_listeners()) {
+        output_fill = std::max(output_fill, get_fill(listener));
+    }
+    double input_fill = (arrow->get_type() == JArrow::NodeType::Source) ? 1.0 - output_fill : get_fill(arrow);
+
+    double latency_factor = 1.0;
+    double latency = std::chrono::duration<double>(arrow->get_last_latency_per_message()).count();
+    if (latency > 0 && mean_latency > 0) {
+        latency_factor = latency / mean_latency;
+    }
+    return input_fill * (1.0 - output_fill) * latency_factor;
+}
+
+
+size_t JScheduler::find_bottleneck(size_t start_idx) {
+
+    auto& arrows = m_topology->arrows;
+    size_t arrow_count = arrows.size();
+
+    double total_latency = 0;
+    size_t measured_count = 0;
+    for (JArrow* arrow : arrows) {
+        double latency = std::chrono::duration<double>(arrow->get_last_latency_per_message()).count();
+        if (latency > 0) {
+            total_latency += latency;
+            measured_count++;
+        }
+    }
+    double mean_latency = (measured_count == 0) ? 0 : total_latency / measured_count;
+
+    size_t best_idx = start_idx;
+    double best_score = 0;
+    for (size_t i=0; i<arrow_count; ++i) {
+        size_t current_idx = (start_idx + i) % arrow_count;
+        JArrow* candidate = arrows[current_idx];
+        if (candidate->get_status() == JArrow::Status::Running &&
+            (candidate->is_parallel() || candidate->get_thread_count() == 0)) {
 
+            double score = get_backlog_score(candidate, mean_latency);
+            if (score > best_score) {
+                best_score = score;
+                best_idx = current_idx;
+            }
+        }
+    }
+    return best_idx;
+}
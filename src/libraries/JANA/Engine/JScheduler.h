@@ -14,11 +14,33 @@
     struct JArrowTopology;
 
     /// Scheduler assigns Arrows to Workers in a first-come-first-serve manner,
-    /// not unlike OpenMP's `schedule dynamic`.
+    /// not unlike OpenMP's `schedule dynamic`. Every checkin is serialized by a single mutex.
+    /// See JScalableScheduler for an alternative which avoids this.
     class JScheduler {
 
-    private:
+    public:
+        /// RoundRobin offers arrows in a fixed rotation. Backlog starts each search at the arrow with the
+        /// most urgent backlog, so that workers go to the bottleneck first. Ties fall back to the rotation.
+        enum class Policy { RoundRobin, Backlog };
+
+    protected:
         std::shared_ptr<JArrowTopology> m_topology;
+        Policy m_policy = Policy::RoundRobin;
+
+        /// Returns the index of the arrow with the highest backlog score among those which could be assigned
+        /// right now, or start_idx if none of them has any backlog. Scanning starts at start_idx so that ties
+        /// are broken the same way as RoundRobin.
+        size_t find_bottleneck(size_t start_idx);
+
+        /// Scores an arrow by how full its input queue is, discounted by how full its output queues are, and
+        /// weighted by its recent latency per message relative to mean_latency. Sources have no input queue,
+        /// so their urgency is how starved their downstream is.
+        static double get_backlog_score(JArrow* arrow, double mean_latency);
+
+        /// Fraction of an arrow's input queue threshold which is occupied, clamped to [0,1]
+        static double get_fill(JArrow* arrow);
+
+    private:
         size_t m_next_idx;
         std::mutex m_mutex;
 
@@ -27,21 +49,36 @@
         /// Constructor. Note that a Scheduler operates on a vector of Arrow*s.
         JScheduler(std::shared_ptr<JArrowTopology> topology);
 
+        virtual ~JScheduler() = default;
+
+        void set_policy(Policy policy) { m_policy = policy; }
+
+        Policy get_policy() const { return m_policy; }
+
         /// Lets a Worker ask the Scheduler for another assignment. If no assignments make sense,
         /// Scheduler returns nullptr, which tells that Worker to idle until his next checkin.
         /// If next_assignment() makes any changes to internal Scheduler state or to any of its arrows,
         /// it must be synchronized.
-        JArrow* next_assignment(uint32_t worker_id, JArrow* assignment, JArrowMetrics::Status result);
+        virtual JArrow* next_assignment(uint32_t worker_id, JArrow* assignment, JArrowMetrics::Status result);
 
         /// Lets a Worker tell the scheduler that he is shutting down and won't be working on his assignment
         /// any more. The scheduler is thus free to reassign the arrow to one of the remaining workers.
-        void last_assignment(uint32_t worker_id, JArrow* assignment, JArrowMetrics::Status result);
+        virtual void last_assignment(uint32_t worker_id, JArrow* assignment, JArrowMetrics::Status result);
 
         /// Logger is public so that somebody else can configure it
         JLogger logger;
     };
 
 
+    inline std::ostream& operator<<(std::ostream& os, JScheduler::Policy policy) {
+        switch (policy) {
+            case JScheduler::Policy::RoundRobin: os << "round_robin"; break;
+            case JScheduler::Policy::Backlog: os << "backlog"; break;
+        }
+        return os;
+    }
+
+
 #endif // _JSCHEDULER_H_
 
 
@@ -8,6 +8,7 @@
 #include <JANA/Engine/JArrowTopology.h>
 #include "JEventSourceArrow.h"
 #include "JEventProcessorArrow.h"
+#include "JEventReorderArrow.h"
 #include <memory>
 
 class JTopologyBuilder : public JService {
@@ -21,10 +22,19 @@ class JTopologyBuilder : public JService {
     size_t m_event_queue_threshold = 80;
     size_t m_event_source_chunksize = 40;
     size_t m_event_processor_chunksize = 1;
-    size_t m_location_count = 1;
+    bool m_adaptive_chunksize = false;
+    size_t m_min_chunksize = 1;
+    size_t m_max_chunksize = 64;
+    size_t m_reorder_window = 0;
+    size_t m_max_bytes_in_flight = 0;
+    std::string m_event_queue_backend = "deque";
+    std::string m_backoff_strategy = "park";
     bool m_enable_call_graph_recording = false;
     bool m_enable_stealing = false;
     bool m_limit_total_events_in_flight = true;
+    bool m_concurrent_sources = false;
+    bool m_parallel_factories = false;
+    size_t m_parallel_factories_learning_events = 10;
     int m_affinity = 0;
     int m_locality = 0;
     JLogger m_arrow_logger;
@@ -95,9 +105,34 @@ public:
         m_params->SetDefaultParameter("jana:event_source_chunksize", m_event_source_chunksize,
                                       "Max number of events that a JEventSource may enqueue at once. Higher => less queue contention; Lower => better load balancing")
                 ->SetIsAdvanced(true);
+        m_params->SetDefaultParameter("jana:concurrent_sources", m_concurrent_sources,
+                                      "Give each JEventSource its own arrow, so that several sources (e.g. input files) are read at the same time. Otherwise sources are read one after another. jana:nevents and jana:nskip apply to each source either way.")
+                ->SetIsAdvanced(true);
         m_params->SetDefaultParameter("jana:event_processor_chunksize", m_event_processor_chunksize,
                                       "Max number of events that the JEventProcessors may dequeue at once. Higher => less queue contention; Lower => better load balancing")
                 ->SetIsAdvanced(true);
+        m_params->SetDefaultParameter("jana:adaptive_chunksize", m_adaptive_chunksize,
+                                      "Tune each arrow's chunksize while running, from its per-event latency and queue overhead. jana:event_source_chunksize and jana:event_processor_chunksize become the starting points.")
+                ->SetIsAdvanced(true);
+        m_params->SetDefaultParameter("jana:adaptive_chunksize_min", m_min_chunksize,
+                                      "Smallest chunksize that jana:adaptive_chunksize may choose")
+                ->SetIsAdvanced(true);
+        m_params->SetDefaultParameter("jana:adaptive_chunksize_max", m_max_chunksize,
+                                      "Largest chunksize that jana:adaptive_chunksize may choose. Never more than jana:event_queue_threshold.")
+                ->SetIsAdvanced(true);
+        m_reorder_window = m_event_pool_size;
+        m_params->SetDefaultParameter("jana:reorder_window", m_reorder_window,
+                                      "Max number of events held back for JEventProcessors which require ordered events, i.e. how far the sources may run ahead of the oldest unfinished event. Defaults to jana:event_pool_size.")
+                ->SetIsAdvanced(true);
+        m_params->SetDefaultParameter("jana:max_bytes_in_flight", m_max_bytes_in_flight,
+                                      "Max estimated bytes held by all events in flight, and by any one event queue. 0=No limit, only jana:event_pool_size applies. Event sizes come from JFactory::GetEstimatedBytes().")
+                ->SetIsAdvanced(true);
+        m_params->SetDefaultParameter("jana:event_queue_backend", m_event_queue_backend,
+                                      "Storage behind the main event queue. 'deque'=Mutex-protected deque. 'ringbuffer'=Lock-free bounded ring buffer, which avoids Congested pops when many threads contend.")
+                ->SetIsAdvanced(true);
+        m_params->SetDefaultParameter("jana:backoff_strategy", m_backoff_strategy,
+                                      "What a worker does when the JEventProcessors' queue is empty. 'park'=Sleep until an event is pushed (falls back to 'exponential' when no source is running). 'constant', 'linear', 'exponential'=Poll with the given backoff.")
+                ->SetIsAdvanced(true);
         m_params->SetDefaultParameter("jana:enable_stealing", m_enable_stealing,
                                       "Enable work stealing. Improves load balancing when jana:locality != 0; otherwise does nothing.")
                 ->SetIsAdvanced(true);
@@ -107,6 +142,12 @@ public:
         m_params->SetDefaultParameter("jana:locality", m_locality,
                                       "Constrain memory locality. 0=No constraint. 1=Events stay on the same socket. 2=Events stay on the same NUMA domain. 3=Events stay on same core. 4=Events stay on same cpu/hyperthread.")
                 ->SetIsAdvanced(true);
+        m_params->SetDefaultParameter("jana:parallel_factories", m_parallel_factories,
+                                      "Create the collections which processors declare up front by running independent factories of an event in parallel")
+                ->SetIsAdvanced(true);
+        m_params->SetDefaultParameter("jana:parallel_factories_learning_events", m_parallel_factories_learning_events,
+                                      "Number of events which run serially while the dependencies between factories are learned")
+                ->SetIsAdvanced(true);
         m_params->SetDefaultParameter("record_call_stack", m_enable_call_graph_recording,
                                       "Records a trace of who called each factory. Reduces performance but necessary for plugins such as janadot.")
                 ->SetIsAdvanced(true);
@@ -114,19 +155,92 @@ public:
         m_arrow_logger = sl->get<JLoggingService>()->get_logger("JArrow");
     };
 
+    /// Lets the processor arrow create the processors' declared collections with a JFactoryTaskGraph
+    inline void apply_parallel_factories(JEventProcessorArrow* proc_arrow, const std::vector<JEventProcessor*>& procs) {
+        bool any_declared = false;
+        for (auto proc : procs) {
+            any_declared |= !proc->GetPrefetchedCollections().empty();
+        }
+        if (!any_declared) {
+            LOG_WARN(m_arrow_logger) << "jana:parallel_factories is set, but no processor declared the collections it needs. Factories will run serially." << LOG_END;
+            return;
+        }
+        if (m_enable_call_graph_recording) {
+            // The call graph recorder of an event isn't thread safe
+            LOG_WARN(m_arrow_logger) << "jana:parallel_factories can't be used together with record_call_stack. Factories will run serially." << LOG_END;
+            return;
+        }
+        auto pool = std::make_shared<JFactoryTaskPool>();
+        auto topology = m_topology.get();
+        pool->set_wake_callback([topology] {
+            for (auto arrow : topology->arrows) arrow->unpark();
+        });
+        m_topology->factory_tasks = pool;
+        proc_arrow->set_factory_task_graph(std::unique_ptr<JFactoryTaskGraph>(
+                new JFactoryTaskGraph(procs, pool.get(), m_parallel_factories_learning_events, m_arrow_logger)));
+    }
+
     inline std::shared_ptr<JArrowTopology> create_empty() {
         m_topology = std::make_shared<JArrowTopology>();
         m_topology->component_manager = m_components;  // Ensure the lifespan of the component manager exceeds that of the topology
         m_topology->mapping.initialize(static_cast<JProcessorMapping::AffinityStrategy>(m_affinity),
                                        static_cast<JProcessorMapping::LocalityStrategy>(m_locality));
 
+        // Every location gets its own share of the event pool, allocated on that location's memory
+        m_topology->location_count = m_topology->mapping.get_loc_count();
         m_topology->event_pool = std::make_shared<JEventPool>(m_components,
                                                               m_event_pool_size,
-                                                              m_location_count,
-                                                              m_limit_total_events_in_flight);
+                                                              m_topology->location_count,
+                                                              m_limit_total_events_in_flight,
+                                                              &m_topology->mapping);
+        m_topology->event_pool->set_max_bytes_in_flight(m_max_bytes_in_flight);
         return m_topology;
 
     }
+
+    /// Byte accounting costs a walk over the event's factories on every push and pop, so it is only enabled along
+    /// with jana:max_bytes_in_flight
+    inline void apply_byte_budget(EventQueue* queue) const {
+        if (m_max_bytes_in_flight == 0) return;
+        queue->set_byte_budget(m_max_bytes_in_flight, [](const std::shared_ptr<JEvent>& event) {
+            return event->GetEstimatedBytes();
+        });
+    }
+
+    /// A source can only emit a chunk once the whole chunk fits in the queue, so chunks never outgrow the queue threshold
+    inline void apply_adaptive_chunksize(JArrow* arrow) const {
+        if (!m_adaptive_chunksize) return;
+        auto max_chunksize = std::max<size_t>(1, std::min(m_max_chunksize, m_event_queue_threshold));
+        arrow->set_adaptive_chunksize(true, std::min(m_min_chunksize, max_chunksize), max_chunksize);
+    }
+
+    inline JMailboxBackend get_event_queue_backend() const {
+        if (m_event_queue_backend == "deque") {
+            return JMailboxBackend::Deque;
+        }
+        else if (m_event_queue_backend == "ringbuffer") {
+            return JMailboxBackend::RingBuffer;
+        }
+        throw JException("Invalid value for jana:event_queue_backend: '%s'. Expected 'deque' or 'ringbuffer'.",
+                         m_event_queue_backend.c_str());
+    }
+
+    inline JArrow::BackoffStrategy get_backoff_strategy() const {
+        if (m_backoff_strategy == "park") {
+            return JArrow::BackoffStrategy::Park;
+        }
+        else if (m_backoff_strategy == "exponential") {
+            return JArrow::BackoffStrategy::Exponential;
+        }
+        else if (m_backoff_strategy == "linear") {
+            return JArrow::BackoffStrategy::Linear;
+        }
+        else if (m_backoff_strategy == "constant") {
+            return JArrow::BackoffStrategy::Constant;
+        }
+        throw JException("Invalid value for jana:backoff_strategy: '%s'. Expected 'park', 'exponential', 'linear', or 'constant'.",
+                         m_backoff_strategy.c_str());
+    }
 /*
     inline void add_eventsource_arrows() {
 
@@ -150,7 +264,12 @@ public:
 
         create_empty();
 
-        auto queue = new EventQueue(m_event_queue_threshold, m_topology->mapping.get_loc_count(), m_enable_stealing);
+        auto queue = new EventQueue(m_event_queue_threshold, m_topology->mapping.get_loc_count(), m_enable_stealing,
+                                    get_event_queue_backend());
+        for (size_t loc=0; loc<m_topology->mapping.get_loc_count(); ++loc) {
+            queue->set_steal_order(loc, m_topology->mapping.get_steal_order(loc));
+        }
+        apply_byte_budget(queue);
         m_topology->queues.push_back(queue);
 
         // We generally want to assert that there is at least one event source (or block source, or any arrow in topology->sources, really),
@@ -159,29 +278,90 @@ public:
         // 2. Oftentimes we want to call JApplication::Initialize() just to set up plugins and services, i.e. for testing.
         //    We don't want to force the user to create a dummy event source if they know they are never going to call JApplication::Run().
 
-        // Create arrow for sources.
-        JArrow *arrow = new JEventSourceArrow("sources", m_components->get_evt_srces(), queue, m_topology->event_pool);
-        arrow->set_backoff_tries(0);
-        m_topology->arrows.push_back(arrow);
-        m_topology->sources.push_back(arrow);
-        arrow->set_chunksize(m_event_source_chunksize);
-        arrow->set_logger(m_arrow_logger);
-        arrow->set_running_arrows(&m_topology->running_arrow_count);
+        // Create arrows for sources. Either one arrow drains every source in turn, or each source gets its own arrow,
+        // in which case they all push onto the same queue. The arrows share an indexer so that event indices stay consecutive.
+        std::vector<JEventSourceArrow*> src_arrows;
+        auto evt_srces = m_components->get_evt_srces();
+        if (m_concurrent_sources && evt_srces.size() > 1) {
+            for (size_t i=0; i<evt_srces.size(); ++i) {
+                src_arrows.push_back(new JEventSourceArrow("sources[" + std::to_string(i) + "]", {evt_srces[i]}, queue, m_topology->event_pool));
+            }
+        }
+        else {
+            src_arrows.push_back(new JEventSourceArrow("sources", evt_srces, queue, m_topology->event_pool));
+        }
+        auto indexer = std::make_shared<JEventSourceArrow::EventIndexer>();
+        for (auto arrow : src_arrows) {
+            arrow->set_event_indexer(indexer);
+            arrow->set_backoff_tries(0);
+            m_topology->arrows.push_back(arrow);
+            m_topology->sources.push_back(arrow);
+            arrow->set_chunksize(m_event_source_chunksize);
+            apply_adaptive_chunksize(arrow);
+            arrow->set_logger(m_arrow_logger);
+            arrow->set_running_arrows(&m_topology->running_arrow_count);
+        }
 
 
-        auto proc_arrow = new JEventProcessorArrow("processors", queue, nullptr, m_topology->event_pool);
+        // Processors which need to see events in order run after a reorder buffer, on their own sequential arrow.
+        // Everything else keeps running in parallel, upstream of the reorder buffer.
+        std::vector<JEventProcessor*> unordered_procs;
+        std::vector<JEventProcessor*> ordered_procs;
+        for (auto proc: m_components->get_evt_procs()) {
+            if (proc->AreEventsOrdered()) {
+                ordered_procs.push_back(proc);
+            }
+            else {
+                unordered_procs.push_back(proc);
+            }
+        }
+
+        EventQueue* ordered_queue = nullptr;
+        if (!ordered_procs.empty()) {
+            ordered_queue = new EventQueue(m_event_queue_threshold, m_topology->mapping.get_loc_count(), m_enable_stealing,
+                                           get_event_queue_backend());
+            apply_byte_budget(ordered_queue);
+            m_topology->queues.push_back(ordered_queue);
+        }
+
+        auto proc_arrow = new JEventProcessorArrow("processors", queue, ordered_queue, m_topology->event_pool);
         proc_arrow->set_chunksize(m_event_processor_chunksize);
+        apply_adaptive_chunksize(proc_arrow);
+        proc_arrow->set_backoff_strategy(get_backoff_strategy());
         proc_arrow->set_logger(m_arrow_logger);
         proc_arrow->set_running_arrows(&m_topology->running_arrow_count);
         m_topology->arrows.push_back(proc_arrow);
 
-        for (auto proc: m_components->get_evt_procs()) {
+        for (auto proc: unordered_procs) {
             proc_arrow->add_processor(proc);
         }
+        if (m_parallel_factories) {
+            apply_parallel_factories(proc_arrow, unordered_procs);
+        }
         for (auto src_arrow : m_topology->sources) {
             src_arrow->attach(proc_arrow);
         }
-        m_topology->sinks.push_back(proc_arrow);
+
+        if (ordered_queue == nullptr) {
+            m_topology->sinks.push_back(proc_arrow);
+            return m_topology;
+        }
+
+        auto reorder_arrow = new JEventReorderArrow("ordered_processors", ordered_queue, m_reorder_window, m_topology->event_pool);
+        reorder_arrow->set_chunksize(m_event_source_chunksize);
+        apply_adaptive_chunksize(reorder_arrow);
+        reorder_arrow->set_logger(m_arrow_logger);
+        reorder_arrow->set_running_arrows(&m_topology->running_arrow_count);
+        m_topology->arrows.push_back(reorder_arrow);
+
+        for (auto proc: ordered_procs) {
+            reorder_arrow->add_processor(proc);
+        }
+        for (auto arrow : src_arrows) {
+            arrow->set_reorder_arrow(reorder_arrow);
+        }
+        proc_arrow->attach(reorder_arrow);
+        m_topology->sinks.push_back(reorder_arrow);
         return m_topology;
     }
 
@@ -4,6 +4,7 @@
 
 #include <JANA/Engine/JWorker.h>
 #include <JANA/Engine/JArrowProcessingController.h>
+#include <JANA/Engine/JFactoryTaskPool.h>
 #include <JANA/Utils/JCpuInfo.h>
 
 /// This allows someone (aka JArrowProcessingController) to declare that this
@@ -22,35 +23,21 @@ void JWorker::declare_timeout() {
 }
 
 void JWorker::measure_perf(WorkerSummary& summary) {
-    // Read (do not clear) worker metrics
-    // Read and clear arrow metrics
-    // Push arrow metrics upstream
+    // Read (do not clear) worker metrics, and our own metrics for whichever arrow we are assigned to.
+    // Both are only ever written by the worker thread, so reading them doesn't need to stop it. The arrow metrics
+    // only include what was handed in at the worker's most recent check-in.
 
     JArrowMetrics latest_arrow_metrics;
-    latest_arrow_metrics.clear();
-    latest_arrow_metrics.take(m_arrow_metrics); // move local arrow metrics onto stack
     std::string arrow_name = "idle";
-    {
-        std::lock_guard<std::mutex> lock(m_assignment_mutex);
-        if (m_assignment != nullptr) {
-            m_assignment->get_metrics().update(latest_arrow_metrics); // propagate to global arrow context
-            arrow_name = m_assignment->get_name();
-        }
+    JArrow* assignment = m_assignment.load(std::memory_order_acquire);
+    if (assignment != nullptr) {
+        latest_arrow_metrics = assignment->get_metrics(m_worker_id);
+        arrow_name = assignment->get_name();
     }
-    // Unpack latest_arrow_metrics, add to WorkerSummary
-
-    // If we wanted to average over our measurement interval only, we would also do:
-    // From inside JProcessingController, do _after_ JWorker::measure_perf() for all workers:
-    // for all arrows:
-    //     arrow->overall_metrics.take(arrow->interval_metrics);
-
-    // From right here, at the very end:
-    //     worker->overall_metrics.take(worker->interval_metrics);
 
     JWorkerMetrics latest_worker_metrics;
     latest_worker_metrics.clear();
     latest_worker_metrics.update(m_worker_metrics); // nondestructive
-    // Unpack latest_worker_metrics, add to WorkerSummary
 
     using millis = std::chrono::duration<double, std::milli>;
 
@@ -127,9 +114,16 @@ JWorker::~JWorker() {
 }
 
 void JWorker::start() {
-    // start() requires a wait_until_stopped() first. Otherwise everything gets very confused.
+    std::lock_guard<std::mutex> lock(m_thread_mutex);
+
+    // A worker which is still being retired has to finish stopping before it can start again
+    if (m_run_state == RunState::Stopping) {
+        join_thread();
+    }
     if (m_run_state == RunState::Stopped) {
 
+        // A worker which stopped itself (because the topology paused) still needs its old thread joined
+        join_thread();
         m_run_state = RunState::Running;
         m_thread = new std::thread(&JWorker::loop, this);
 
@@ -142,10 +136,23 @@ void JWorker::start() {
 void JWorker::request_stop() {
     if (m_run_state == RunState::Running) {
         m_run_state = RunState::Stopping;
+
+        // Don't leave the worker backing off or parked until its next checkin
+        { std::lock_guard<std::mutex> lock(m_backoff_mutex); }
+        m_backoff_cv.notify_all();
+        JArrow* assignment = m_assignment.load(std::memory_order_acquire);
+        if (assignment != nullptr) {
+            assignment->unpark();
+        }
     }
 }
 
 void JWorker::wait_for_stop() {
+    std::lock_guard<std::mutex> lock(m_thread_mutex);
+    join_thread();
+}
+
+void JWorker::join_thread() {
     if (m_thread != nullptr) {
         if (m_run_state == RunState::TimedOut) {
             m_thread->detach();
@@ -174,15 +181,14 @@ void JWorker::loop() {
     try {
         LOG_DEBUG(logger) << "Worker " << m_worker_id << " has entered loop()." << LOG_END;
         JArrowMetrics::Status last_result = JArrowMetrics::Status::NotRunYet;
+        JArrow* assignment = nullptr;
 
         while (m_run_state == RunState::Running) {
 
             auto start_time = jclock_t::now();
 
-            {
-                std::lock_guard<std::mutex> lock(m_assignment_mutex);
-                m_assignment = m_scheduler->next_assignment(m_worker_id, m_assignment, last_result);
-            }
+            assignment = m_scheduler->next_assignment(m_worker_id, assignment, last_result);
+            m_assignment.store(assignment, std::memory_order_release);  // Only so that measure_perf() can see it
             last_result = JArrowMetrics::Status::NotRunYet;
 
             auto scheduler_time = jclock_t::now();
@@ -192,7 +198,7 @@ void JWorker::loop() {
             auto retry_duration = jclock_t::duration::zero();
             auto useful_duration = jclock_t::duration::zero();
 
-            if (m_assignment == nullptr) {
+            if (assignment == nullptr) {
                 LOG_DEBUG(logger) << "Worker " << m_worker_id << " shutdown driven by topology pause" << LOG_END;
                 m_run_state = RunState::Stopped;
                 return;
@@ -203,10 +209,10 @@ void JWorker::loop() {
             }
             else {
 
-                auto initial_backoff_time = m_assignment->get_initial_backoff_time();
-                auto backoff_strategy = m_assignment->get_backoff_strategy();
-                auto backoff_tries = m_assignment->get_backoff_tries();
-                auto checkin_time = m_assignment->get_checkin_time();
+                auto initial_backoff_time = assignment->get_initial_backoff_time();
+                auto backoff_strategy = assignment->get_backoff_strategy();
+                auto backoff_tries = assignment->get_backoff_tries();
+                auto checkin_time = assignment->get_checkin_time();
 
                 uint32_t current_tries = 0;
                 auto backoff_duration = initial_backoff_time;
@@ -217,49 +223,71 @@ void JWorker::loop() {
                        (jclock_t::now() - start_time) < checkin_time) {
 
                     LOG_TRACE(logger) << "Worker " << m_worker_id << " is executing "
-                                      << m_assignment->get_name() << LOG_END;
+                                      << assignment->get_name() << LOG_END;
                     auto before_execute_time = jclock_t::now();
-                    m_assignment->execute(m_arrow_metrics, m_location_id);
+                    assignment->execute(m_arrow_metrics, m_location_id);
                     last_result = m_arrow_metrics.get_last_status();
-                    useful_duration += (jclock_t::now() - before_execute_time);
+                    auto after_execute_time = jclock_t::now();
+                    useful_duration += (after_execute_time - before_execute_time);
 
 
                     if (last_result == JArrowMetrics::Status::KeepGoing) {
                         LOG_DEBUG(logger) << "Worker " << m_worker_id << " succeeded at "
-                                          << m_assignment->get_name() << LOG_END;
+                                          << assignment->get_name() << LOG_END;
+                        current_tries = 0;
+                        backoff_duration = initial_backoff_time;
+                    }
+                    else if (m_factory_tasks != nullptr && m_factory_tasks->run_one()) {
+                        // Nothing to do here, but another worker's event had a factory waiting to run
+                        useful_duration += (jclock_t::now() - after_execute_time);
                         current_tries = 0;
                         backoff_duration = initial_backoff_time;
                     }
                     else {
                         current_tries++;
                         if (backoff_tries > 0) {
-                            if (backoff_strategy == JArrow::BackoffStrategy::Linear) {
-                                backoff_duration += initial_backoff_time;
+                            bool parked = false;
+                            if (backoff_strategy == JArrow::BackoffStrategy::Park && assignment->has_active_upstream() &&
+                                m_run_state == RunState::Running) {
+                                // Block until upstream pushes something, but never past our next checkin
+                                auto park_start_time = jclock_t::now();
+                                auto park_timeout = checkin_time - (park_start_time - start_time);
+                                LOG_TRACE(logger) << "Worker " << m_worker_id << " parking on "
+                                                  << assignment->get_name() << ", tries = " << current_tries
+                                                  << LOG_END;
+                                parked = assignment->park(park_timeout, m_location_id);
+                                retry_duration += (jclock_t::now() - park_start_time);
                             }
-                            else if (backoff_strategy == JArrow::BackoffStrategy::Exponential) {
-                                backoff_duration *= 2;
+                            if (!parked) {
+                                if (backoff_strategy == JArrow::BackoffStrategy::Linear) {
+                                    backoff_duration += initial_backoff_time;
+                                }
+                                else if (backoff_strategy == JArrow::BackoffStrategy::Exponential ||
+                                         backoff_strategy == JArrow::BackoffStrategy::Park) {
+                                    backoff_duration *= 2;
+                                }
+                                LOG_TRACE(logger) << "Worker " << m_worker_id << " backing off with "
+                                                  << assignment->get_name() << ", tries = " << current_tries
+                                                  << LOG_END;
+
+                                std::unique_lock<std::mutex> backoff_lock(m_backoff_mutex);
+                                m_backoff_cv.wait_for(backoff_lock, backoff_duration,
+                                                      [&]{ return m_run_state != RunState::Running; });
+                                retry_duration += backoff_duration;
                             }
-                            LOG_TRACE(logger) << "Worker " << m_worker_id << " backing off with "
-                                              << m_assignment->get_name() << ", tries = " << current_tries
-                                              << LOG_END;
-
-                            std::this_thread::sleep_for(backoff_duration);
-                            retry_duration += backoff_duration;
                         }
                     }
                 }
             }
             m_worker_metrics.update(start_time, 1, useful_duration, retry_duration, scheduler_duration, idle_duration);
-            if (m_assignment != nullptr) {
-                JArrowMetrics latest_arrow_metrics;
-                latest_arrow_metrics.clear();
-                latest_arrow_metrics.take(m_arrow_metrics); // move local arrow metrics onto stack
-                m_assignment->get_metrics().update(latest_arrow_metrics); // propagate to global arrow context
+            if (assignment != nullptr) {
+                assignment->tune_chunksize(m_arrow_metrics);
+                assignment->hand_in_metrics(m_worker_id, m_arrow_metrics); // hand in to our own slot in the arrow
             }
         }
 
-        m_scheduler->last_assignment(m_worker_id, m_assignment, last_result);
-        m_assignment = nullptr; // Worker has 'handed in' the assignment
+        m_scheduler->last_assignment(m_worker_id, assignment, last_result);
+        m_assignment.store(nullptr, std::memory_order_release); // Worker has 'handed in' the assignment
         LOG_DEBUG(logger) << "Worker " << m_worker_id << " shutdown due to worker->request_stop()." << LOG_END;
     }
     catch (const JException& e) {
@@ -11,9 +11,12 @@
 #include <JANA/Engine/JWorkerMetrics.h>
 #include <JANA/Engine/JArrowPerfSummary.h>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 
 class JArrowProcessingController;
+class JFactoryTaskPool;
 
 class JWorker {
     /// Designed so that the Worker checks in with the Scheduler on his own terms;
@@ -38,12 +41,15 @@ private:
     unsigned m_location_id;
     bool m_pin_to_cpu;
     std::atomic<RunState> m_run_state;
-    JArrow* m_assignment;
+    std::atomic<JArrow*> m_assignment;  // Only written by the worker thread
     std::thread* m_thread;    // JWorker encapsulates a thread of some kind. Nothing else should care how.
+    std::mutex m_thread_mutex;  // Retiring a worker waits for it outside JAPC's lock, so start() may race with that wait
+    std::mutex m_backoff_mutex;
+    std::condition_variable m_backoff_cv;  // Lets request_stop() cut a backoff short
     JWorkerMetrics m_worker_metrics;
     JArrowMetrics m_arrow_metrics;
-    std::mutex m_assignment_mutex;
     JException m_exception;
+    JFactoryTaskPool* m_factory_tasks = nullptr;
 
 public:
     JWorker(JArrowProcessingController* japc, JScheduler* scheduler, unsigned worker_id, unsigned cpu_id, unsigned domain_id, bool pin_to_cpu);
@@ -64,6 +70,14 @@ public:
     void declare_timeout();
     const JException& get_exception() const;
 
+private:
+    void join_thread();  // Requires m_thread_mutex
+
+public:
+
+    /// Workers which find nothing to do at their assignment run factory tasks from here before backing off
+    void set_factory_tasks(JFactoryTaskPool* factory_tasks) { m_factory_tasks = factory_tasks; }
+
     /// This is what the encapsulated thread is supposed to be doing
     void loop();
 
@@ -6,16 +6,18 @@
 #ifndef JANA2_JWORKERMETRICS_H
 #define JANA2_JWORKERMETRICS_H
 
+#include <atomic>
 #include <chrono>
-#include <mutex>
 
-class JWorkerMetrics {
+class alignas(64) JWorkerMetrics {
     /// Workers need to maintain metrics. Similar to Arrow::Metrics, these form a monoid
-    /// where the identity element is (0,0,0) and the combine operation accumulates totals
-    /// in a thread-safe way. Alas, the combine operation mutates state for performance reasons.
+    /// where the identity element is (0,0,0) and the combine operation accumulates totals.
+    /// Alas, the combine operation mutates state for performance reasons.
     /// We've separated Metrics from the Worker itself because it is not always obvious
     /// who should be performing the accumulation or when, and this gives us the freedom to
     /// try different possibilities.
+    /// Like JArrowMetrics, each instance has a single writer (its worker) and may be read by anybody at any time
+    /// without a lock, since every field is a relaxed atomic.
 
 public:
     using clock_t = std::chrono::steady_clock;
@@ -23,72 +25,63 @@ public:
     using time_point_t = clock_t::time_point;
 
 private:
-    mutable std::mutex m_mutex;
-    // mutex is mutable so that we can lock before reading from a const ref
-
-    time_point_t m_last_heartbeat;
-    long m_scheduler_visit_count;
-
-    duration_t m_total_useful_time;
-    duration_t m_total_retry_time;
-    duration_t m_total_scheduler_time;
-    duration_t m_total_idle_time;
-    duration_t m_last_useful_time;
-    duration_t m_last_retry_time;
-    duration_t m_last_scheduler_time;
-    duration_t m_last_idle_time;
+    std::atomic<time_point_t> m_last_heartbeat {clock_t::now()};
+    std::atomic<long> m_scheduler_visit_count {0};
+
+    std::atomic<duration_t> m_total_useful_time {duration_t::zero()};
+    std::atomic<duration_t> m_total_retry_time {duration_t::zero()};
+    std::atomic<duration_t> m_total_scheduler_time {duration_t::zero()};
+    std::atomic<duration_t> m_total_idle_time {duration_t::zero()};
+    std::atomic<duration_t> m_last_useful_time {duration_t::zero()};
+    std::atomic<duration_t> m_last_retry_time {duration_t::zero()};
+    std::atomic<duration_t> m_last_scheduler_time {duration_t::zero()};
+    std::atomic<duration_t> m_last_idle_time {duration_t::zero()};
+
+    // Only the writer modifies a field, so a plain load and store suffices and never needs a locked instruction
+    template <typename T, typename U>
+    static void add(std::atomic<T>& field, const U& delta) {
+        field.store(field.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+    template <typename T>
+    static T read(const std::atomic<T>& field) {
+        return field.load(std::memory_order_relaxed);
+    }
+    template <typename T, typename U>
+    static void write(std::atomic<T>& field, const U& value) {
+        field.store(value, std::memory_order_relaxed);
+    }
 
 
 public:
-    JWorkerMetrics() {
-        m_mutex.lock();
-        m_last_heartbeat = clock_t::now();
-        m_scheduler_visit_count = 0;
-        auto zero = duration_t::zero();
-        m_total_useful_time = zero;
-        m_total_retry_time = zero;
-        m_total_scheduler_time = zero;
-        m_total_idle_time = zero;
-        m_last_useful_time = zero;
-        m_last_retry_time = zero;
-        m_last_scheduler_time = zero;
-        m_last_idle_time = zero;
-        m_mutex.unlock();
-    }
+    JWorkerMetrics() = default;
 
     void clear() {
-        m_mutex.lock();
-        m_last_heartbeat = clock_t::now();
-        m_scheduler_visit_count = 0;
+        write(m_last_heartbeat, clock_t::now());
+        write(m_scheduler_visit_count, 0);
         auto zero = duration_t::zero();
-        m_total_useful_time = zero;
-        m_total_retry_time = zero;
-        m_total_scheduler_time = zero;
-        m_total_idle_time = zero;
-        m_last_useful_time = zero;
-        m_last_retry_time = zero;
-        m_last_scheduler_time = zero;
-        m_last_idle_time = zero;
-        m_mutex.unlock();
+        write(m_total_useful_time, zero);
+        write(m_total_retry_time, zero);
+        write(m_total_scheduler_time, zero);
+        write(m_total_idle_time, zero);
+        write(m_last_useful_time, zero);
+        write(m_last_retry_time, zero);
+        write(m_last_scheduler_time, zero);
+        write(m_last_idle_time, zero);
     }
 
 
     void update(const JWorkerMetrics &other) {
 
-        m_mutex.lock();
-        other.m_mutex.lock();
-        m_last_heartbeat = other.m_last_heartbeat;
-        m_scheduler_visit_count += other.m_scheduler_visit_count;
-        m_total_useful_time += other.m_total_useful_time;
-        m_total_retry_time += other.m_total_retry_time;
-        m_total_scheduler_time += other.m_total_scheduler_time;
-        m_total_idle_time += other.m_total_idle_time;
-        m_last_useful_time = other.m_last_useful_time;
-        m_last_retry_time = other.m_last_retry_time;
-        m_last_scheduler_time = other.m_last_scheduler_time;
-        m_last_idle_time = other.m_last_idle_time;
-        other.m_mutex.unlock();
-        m_mutex.unlock();
+        write(m_last_heartbeat, read(other.m_last_heartbeat));
+        add(m_scheduler_visit_count, read(other.m_scheduler_visit_count));
+        add(m_total_useful_time, read(other.m_total_useful_time));
+        add(m_total_retry_time, read(other.m_total_retry_time));
+        add(m_total_scheduler_time, read(other.m_total_scheduler_time));
+        add(m_total_idle_time, read(other.m_total_idle_time));
+        write(m_last_useful_time, read(other.m_last_useful_time));
+        write(m_last_retry_time, read(other.m_last_retry_time));
+        write(m_last_scheduler_time, read(other.m_last_scheduler_time));
+        write(m_last_idle_time, read(other.m_last_idle_time));
     }
 
 
@@ -100,18 +93,16 @@ public:
                 const duration_t& scheduler_time,
                 const duration_t& idle_time) {
 
-        m_mutex.lock();
-        m_scheduler_visit_count += scheduler_visit_count;
-        m_total_useful_time += useful_time;
-        m_total_retry_time += retry_time;
-        m_total_scheduler_time += scheduler_time;
-        m_total_idle_time += idle_time;
-        m_last_useful_time = useful_time;
-        m_last_retry_time = retry_time;
-        m_last_scheduler_time = scheduler_time;
-        m_last_idle_time = idle_time;
-        m_last_heartbeat = heartbeat;
-        m_mutex.unlock();
+        add(m_scheduler_visit_count, scheduler_visit_count);
+        add(m_total_useful_time, useful_time);
+        add(m_total_retry_time, retry_time);
+        add(m_total_scheduler_time, scheduler_time);
+        add(m_total_idle_time, idle_time);
+        write(m_last_useful_time, useful_time);
+        write(m_last_retry_time, retry_time);
+        write(m_last_scheduler_time, scheduler_time);
+        write(m_last_idle_time, idle_time);
+        write(m_last_heartbeat, heartbeat);
     }
 
 
@@ -125,20 +116,18 @@ public:
              duration_t& last_useful_time,
              duration_t& last_retry_time,
              duration_t& last_scheduler_time,
-             duration_t& last_idle_time) {
-
-        m_mutex.lock();
-        scheduler_visit_count = m_scheduler_visit_count;
-        total_useful_time = m_total_useful_time;
-        total_retry_time = m_total_retry_time;
-        total_scheduler_time = m_total_scheduler_time;
-        total_idle_time = m_total_idle_time;
-        last_useful_time = m_last_useful_time;
-        last_retry_time = m_last_retry_time;
-        last_scheduler_time = m_last_scheduler_time;
-        last_idle_time = m_last_idle_time;
-        last_heartbeat = m_last_heartbeat;
-        m_mutex.unlock();
+             duration_t& last_idle_time) const {
+
+        scheduler_visit_count = read(m_scheduler_visit_count);
+        total_useful_time = read(m_total_useful_time);
+        total_retry_time = read(m_total_retry_time);
+        total_scheduler_time = read(m_total_scheduler_time);
+        total_idle_time = read(m_total_idle_time);
+        last_useful_time = read(m_last_useful_time);
+        last_retry_time = read(m_last_retry_time);
+        last_scheduler_time = read(m_last_scheduler_time);
+        last_idle_time = read(m_last_idle_time);
+        last_heartbeat = read(m_last_heartbeat);
     }
 
 };
@@ -0,0 +1,121 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JASSOCIATIONTABLE_H
+#define JANA2_JASSOCIATIONTABLE_H
+
+#include <JANA/JObject.h>
+#include <JANA/Utils/JTypeInfo.h>
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// JAssociationTable records associations between JObjects for a whole event, as one flat vector of (from, to)
+/// pairs, instead of inside each JObject. Factories which link many objects (e.g. tens of thousands of hits to their
+/// clusters) can use it to avoid touching the objects at all:
+///
+///     event->GetAssociations().Add(cluster, hit);
+///     auto hits = event->GetAssociations().Get<Hit>(cluster);
+///
+/// Adding only appends. The pairs are sorted (and duplicates dropped) the first time anyone asks after that, so that
+/// the lookups are binary searches and come out in the same order as JObject::Get<T>() would give. Every JEvent owns
+/// one, which JANA clears when it recycles the event. The table doesn't own anything it points to.
+class JAssociationTable {
+public:
+    using Link = std::pair<const JObject*, const JObject*>;
+
+    void Add(const JObject* from, const JObject* to) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_links.emplace_back(from, to);
+        m_sorted = false;
+    }
+
+    /// Add associates from with every object in to, taking the lock only once
+    template <typename T>
+    void Add(const JObject* from, const std::vector<T*>& to) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto obj : to) m_links.emplace_back(from, obj);
+        m_sorted = false;
+    }
+
+    void Remove(const JObject* from, const JObject* to) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Sort();
+        auto iter = std::lower_bound(m_links.begin(), m_links.end(), Link(from, to));
+        if (iter != m_links.end() && *iter == Link(from, to)) m_links.erase(iter);
+    }
+
+    bool IsAssociated(const JObject* from, const JObject* to) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Sort();
+        return std::binary_search(m_links.begin(), m_links.end(), Link(from, to));
+    }
+
+    /// Get returns every object of type T associated with from, the same way JObject::Get<T>() does: by dynamic_cast,
+    /// or by class name if that finds nothing.
+    template <typename T>
+    std::vector<const T*> Get(const JObject* from) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Sort();
+        auto range = Find(from);
+        std::vector<const T*> results;
+        for (auto iter = range.first; iter != range.second; ++iter) {
+            auto t = dynamic_cast<const T*>(iter->second);
+            if (t != nullptr) results.push_back(t);
+        }
+        if (results.empty()) {
+            // See JObject::Get<T>() for why
+            std::string classname = JTypeInfo::demangle<T>();
+            for (auto iter = range.first; iter != range.second; ++iter) {
+                if (iter->second->className() == classname) results.push_back(reinterpret_cast<const T*>(iter->second));
+            }
+        }
+        return results;
+    }
+
+    /// GetSingle returns the one object of type T associated with from, or nullptr if there is none. Like
+    /// JObject::GetSingle<T>(), it throws if there is more than one.
+    template <typename T>
+    const T* GetSingle(const JObject* from) const {
+        auto results = Get<T>(from);
+        if (results.size() > 1) throw JException("JAssociationTable::GetSingle(): Multiple objects found.");
+        return results.empty() ? nullptr : results[0];
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Sort();
+        return m_links.size();
+    }
+
+    /// Clear keeps the capacity, so that the next event doesn't need to grow it again
+    void Clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_links.clear();
+        m_sorted = true;
+    }
+
+private:
+    void Sort() const {
+        if (m_sorted) return;
+        std::sort(m_links.begin(), m_links.end());
+        m_links.erase(std::unique(m_links.begin(), m_links.end()), m_links.end());
+        m_sorted = true;
+    }
+
+    std::pair<std::vector<Link>::const_iterator, std::vector<Link>::const_iterator> Find(const JObject* from) const {
+        auto begin = std::lower_bound(m_links.begin(), m_links.end(), Link(from, nullptr));
+        auto end = begin;
+        while (end != m_links.end() && end->first == from) ++end;
+        return {begin, end};
+    }
+
+    mutable std::vector<Link> m_links;
+    mutable bool m_sorted = true;
+    mutable std::mutex m_mutex;
+};
+
+#endif //JANA2_JASSOCIATIONTABLE_H
@@ -44,7 +44,7 @@ public:
     void Process(const std::shared_ptr<const JEvent>& event) override {
 
         auto event_nr = event->GetEventNumber();
-        auto jobjs = event->Get<T>(m_tag);
+        auto jobjs = event->GetSpan<T>(m_tag);
 
         std::lock_guard<std::mutex> lock(m_mutex);
 
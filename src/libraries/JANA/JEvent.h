@@ -7,9 +7,12 @@
 
 
 #include <JANA/JObject.h>
+#include <JANA/JAssociationTable.h>
 #include <JANA/JException.h>
 #include <JANA/JFactoryT.h>
 #include <JANA/JFactorySet.h>
+#include <JANA/JFactoryHandle.h>
+#include <JANA/JFactorySoA.h>
 #include <JANA/JLogger.h>
 
 #include <JANA/Utils/JResettable.h>
@@ -74,6 +77,7 @@ class JEvent : public JResettable, public std::enable_shared_from_this<JEvent>
         std::vector<JFactory*> GetAllFactories() const;
         template<class T> JFactoryT<T>* GetFactory(const std::string& tag = "", bool throw_on_missing=false) const;
         template<class T> std::vector<JFactoryT<T>*> GetFactoryAll(bool throw_on_missing = false) const;
+        template<class T> JFactoryT<T>* GetFactory(const JFactoryHandle<T>& handle, bool throw_on_missing=false) const;
 
         template<class T> JMetadata<T> GetMetadata(const std::string& tag = "") const;
 
@@ -91,6 +95,18 @@ class JEvent : public JResettable, public std::enable_shared_from_this<JEvent>
         template<class T> std::vector<const T*> GetAll() const;
         template<class T> std::map<std::pair<std::string,std::string>,std::vector<T*>> GetAllChildren() const;
 
+        // Span getters, which return a view of the factory's own vector instead of copying it. Valid until the event is cleared
+        template<class T> JSpan<const T* const> GetSpan(const std::string& tag = "") const;
+        template<class T> JSpan<const T* const> GetSpan(const JFactoryHandle<T>& handle) const;
+
+        // Handle getters, for hot paths. Same behavior as the getters above with the handle's tag.
+        template<class T> std::vector<const T*> Get(const JFactoryHandle<T>& handle) const;
+        template<class T> const T* GetSingle(const JFactoryHandle<T>& handle) const;
+        template<class T> typename JFactoryT<T>::PairType GetIterators(const JFactoryHandle<T>& handle) const;
+
+        // Column getter, for the output of a JFactorySoA
+        template<class... Columns> const JSoA<Columns...>& GetColumns(const std::string& tag = "") const;
+
         // JANA1 compatibility getters
         template<class T> JFactoryT<T>* GetSingle(const T* &t, const char *tag="", bool exception_if_not_one=true) const;
 
@@ -113,7 +129,9 @@ class JEvent : public JResettable, public std::enable_shared_from_this<JEvent>
         void SetJApplication(JApplication* app){mApplication = app;}
         void SetJEventSource(JEventSource* aSource){mEventSource = aSource;}
         void SetDefaultTags(std::map<std::string, std::string> aDefaultTags){mDefaultTags=aDefaultTags; mUseDefaultTags = !mDefaultTags.empty();}
+        const std::map<std::string, std::string>& GetDefaultTags() const {return mDefaultTags;}
         void SetSequential(bool isSequential) {mIsBarrierEvent = isSequential;}
+        void SetEventIndex(uint64_t aEventIndex) {mEventIndex = aEventIndex;}
 
         //GETTERS
         int32_t GetRunNumber() const {return mRunNumber;}
@@ -122,8 +140,16 @@ class JEvent : public JResettable, public std::enable_shared_from_this<JEvent>
         JEventSource* GetJEventSource() const {return mEventSource; }
         JCallGraphRecorder* GetJCallGraphRecorder() const {return &mCallGraph;}
         JInspector* GetJInspector() const {return &mInspector;}
+        /// GetAssociations() is this event's JAssociationTable, an alternative to JObject::AddAssociatedObject() for
+        /// factories which link many objects. It is cleared along with the factories when the event is recycled.
+        JAssociationTable& GetAssociations() const {return mAssociations;}
         void Inspect() const { mInspector.Loop();} // TODO: Force this not to be inlined AND used so it is defined in libJANA.a
         bool GetSequential() const {return mIsBarrierEvent;}
+        /// GetEventIndex() is the position of this event in the stream emitted by the JEventSources, starting at 0.
+        /// Unlike the event number, it is assigned by JANA and is always consecutive, so it is what orders events.
+        uint64_t GetEventIndex() const {return mEventIndex;}
+        /// GetEstimatedBytes() is the memory currently held by this event's factories, according to their own estimates.
+        size_t GetEstimatedBytes() const {return mFactorySet->GetEstimatedBytes();}
         friend class JEventPool;
 
 
@@ -132,14 +158,30 @@ class JEvent : public JResettable, public std::enable_shared_from_this<JEvent>
         JApplication* mApplication = nullptr;
         int32_t mRunNumber = 0;
         uint64_t mEventNumber = 0;
+        uint64_t mEventIndex = 0;
+        size_t mPoolLocation = 0;  // Which of JEventPool's locations this event belongs to
+        size_t mPoolSlot = -1;     // Where that location keeps it. -1 if the pool doesn't keep it at all
+        size_t mPoolBytesCharged = 0;  // What JEventPool counted towards jana:max_bytes_in_flight when it handed this out
         mutable JFactorySet* mFactorySet = nullptr;
         mutable JCallGraphRecorder mCallGraph;
         mutable JInspector mInspector;
+        mutable JAssociationTable mAssociations;
         bool mUseDefaultTags = false;
         std::map<std::string, std::string> mDefaultTags;
         JEventSource* mEventSource = nullptr;
         bool mIsBarrierEvent = false;
 
+        /// ResolveTag() substitutes the default tag for an empty one. It hands back a reference rather than a copy,
+        /// since it sits on the path of every Get().
+        template <typename T>
+        const std::string& ResolveTag(const std::string& tag) const {
+            if (mUseDefaultTags && tag.empty()) {
+                auto defaultTag = mDefaultTags.find(JTypeInfo::demangled_name<T>());
+                if (defaultTag != mDefaultTags.end()) return defaultTag->second;
+            }
+            return tag;
+        }
+
 #ifdef HAVE_PODIO
         std::map<std::string, JFactory*> mPodioFactories;
 #endif
@@ -152,12 +194,7 @@ class JEvent : public JResettable, public std::enable_shared_from_this<JEvent>
 template <class T>
 inline JFactoryT<T>* JEvent::Insert(T* item, const std::string& tag) const {
 
-    std::string resolved_tag = tag;
-    if (mUseDefaultTags && tag.empty()) {
-        auto defaultTag = mDefaultTags.find(JTypeInfo::demangle<T>());
-        if (defaultTag != mDefaultTags.end()) resolved_tag = defaultTag->second;
-    }
-    auto factory = mFactorySet->GetFactory<T>(resolved_tag);
+    auto factory = mFactorySet->GetFactory<T>(ResolveTag<T>(tag));
     if (factory == nullptr) {
         factory = new JFactoryT<T>;
         factory->SetTag(tag);
@@ -171,12 +208,7 @@ inline JFactoryT<T>* JEvent::Insert(T* item, const std::string& tag) const {
 template <class T>
 inline JFactoryT<T>* JEvent::Insert(const std::vector<T*>& items, const std::string& tag) const {
 
-    std::string resolved_tag = tag;
-    if (mUseDefaultTags && tag.empty()) {
-        auto defaultTag = mDefaultTags.find(JTypeInfo::demangle<T>());
-        if (defaultTag != mDefaultTags.end()) resolved_tag = defaultTag->second;
-    }
-    auto factory = mFactorySet->GetFactory<T>(resolved_tag);
+    auto factory = mFactorySet->GetFactory<T>(ResolveTag<T>(tag));
     if (factory == nullptr) {
         factory = new JFactoryT<T>;
         factory->SetTag(tag);
@@ -208,12 +240,7 @@ inline std::vector<JFactory*> JEvent::GetAllFactories() const {
 template<class T>
 inline JFactoryT<T>* JEvent::GetFactory(const std::string& tag, bool throw_on_missing) const
 {
-    std::string resolved_tag = tag;
-    if (mUseDefaultTags && tag.empty()) {
-        auto defaultTag = mDefaultTags.find(JTypeInfo::demangle<T>());
-        if (defaultTag != mDefaultTags.end()) resolved_tag = defaultTag->second;
-    }
-    auto factory = mFactorySet->GetFactory<T>(resolved_tag);
+    auto factory = mFactorySet->GetFactory<T>(ResolveTag<T>(tag));
     if (factory == nullptr) {
         if (throw_on_missing) {
             JException ex("Could not find JFactoryT<" + JTypeInfo::demangle<T>() + "> with tag=" + tag);
@@ -224,6 +251,23 @@ inline JFactoryT<T>* JEvent::GetFactory(const std::string& tag, bool throw_on_mi
     return factory;
 }
 
+/// This GetFactory() finds the factory behind a JFactoryHandle with a single index, no string comparisons.
+/// If default tags are in play, an untagged handle falls back to the string lookup, since the default tag
+/// isn't known until the event is.
+template<class T>
+inline JFactoryT<T>* JEvent::GetFactory(const JFactoryHandle<T>& handle, bool throw_on_missing) const
+{
+    if (mUseDefaultTags && handle.GetTag().empty()) {
+        return GetFactory<T>(handle.GetTag(), throw_on_missing);
+    }
+    auto factory = static_cast<JFactoryT<T>*>(mFactorySet->GetFactoryByKeyId(handle.GetKeyId()));
+    if (factory == nullptr) {
+        // Possibly registered under another typeid for the same type. This is rare, so let the string lookup sort it out
+        return GetFactory<T>(handle.GetTag(), throw_on_missing);
+    }
+    return factory;
+}
+
 
 /// GetMetadata() provides access to any metadata generated by the underlying JFactory during Process()
 template<class T>
@@ -267,9 +311,7 @@ JFactoryT<T>* JEvent::Get(std::vector<const T*>& destination, const std::string&
     auto factory = GetFactory<T>(tag, true);
     JCallGraphEntryMaker cg_entry(mCallGraph, factory); // times execution until this goes out of scope
     auto iterators = factory->GetOrCreate(this->shared_from_this());
-    for (auto it=iterators.first; it!=iterators.second; it++) {
-        destination.push_back(*it);
-    }
+    destination.insert(destination.end(), iterators.first, iterators.second);
     return factory;
 }
 
@@ -323,11 +365,69 @@ std::vector<const T*> JEvent::Get(const std::string& tag) const {
     auto factory = GetFactory<T>(tag, true);
     JCallGraphEntryMaker cg_entry(mCallGraph, factory); // times execution until this goes out of scope
     auto iters = factory->GetOrCreate(this->shared_from_this());
-    std::vector<const T*> vec;
-    for (auto it=iters.first; it!=iters.second; ++it) {
-        vec.push_back(*it);
+    return std::vector<const T*>(iters.first, iters.second); // One allocation, of exactly the right size
+}
+
+/// GetSpan returns the factory's objects without copying them: the span points straight into the factory.
+/// This is what hot paths which call Get() for every event should use. The span stays valid until the event is
+/// cleared, so it must not be kept beyond that.
+template<class T>
+JSpan<const T* const> JEvent::GetSpan(const std::string& tag) const {
+    auto factory = GetFactory<T>(tag, true);
+    JCallGraphEntryMaker cg_entry(mCallGraph, factory); // times execution until this goes out of scope
+    factory->GetOrCreate(this->shared_from_this());
+    return factory->GetSpan();
+}
+
+template<class T>
+JSpan<const T* const> JEvent::GetSpan(const JFactoryHandle<T>& handle) const {
+    auto factory = GetFactory(handle, true);
+    JCallGraphEntryMaker cg_entry(mCallGraph, factory); // times execution until this goes out of scope
+    factory->GetOrCreate(this->shared_from_this());
+    return factory->GetSpan();
+}
+
+/// Handle getters
+
+template<class T>
+std::vector<const T*> JEvent::Get(const JFactoryHandle<T>& handle) const {
+
+    auto factory = GetFactory(handle, true);
+    JCallGraphEntryMaker cg_entry(mCallGraph, factory); // times execution until this goes out of scope
+    auto iters = factory->GetOrCreate(this->shared_from_this());
+    return std::vector<const T*>(iters.first, iters.second);
+}
+
+template<class T>
+const T* JEvent::GetSingle(const JFactoryHandle<T>& handle) const {
+    auto factory = GetFactory(handle, true);
+    JCallGraphEntryMaker cg_entry(mCallGraph, factory); // times execution until this goes out of scope
+    auto iterators = factory->GetOrCreate(this->shared_from_this());
+    if (std::distance(iterators.first, iterators.second) == 0) {
+        return nullptr;
     }
-    return vec; // Assumes RVO
+    return *iterators.first;
+}
+
+template<class T>
+typename JFactoryT<T>::PairType JEvent::GetIterators(const JFactoryHandle<T>& handle) const {
+    auto factory = GetFactory(handle, true);
+    JCallGraphEntryMaker cg_entry(mCallGraph, factory); // times execution until this goes out of scope
+    return factory->GetOrCreate(this->shared_from_this());
+}
+
+/// GetColumns returns the columns which a JFactorySoA<Columns...> produced for this event, running it first if need be.
+/// The JSoA stays valid until the event is cleared.
+template<class... Columns>
+const JSoA<Columns...>& JEvent::GetColumns(const std::string& tag) const {
+    auto factory = GetFactory<JSoARow<Columns...>>(tag, true);
+    auto typed_factory = dynamic_cast<JFactorySoA<Columns...>*>(factory);
+    if (typed_factory == nullptr) {
+        throw JException("Factory must inherit from JFactorySoA in order to use JEvent::GetColumns()");
+    }
+    JCallGraphEntryMaker cg_entry(mCallGraph, typed_factory); // times execution until this goes out of scope
+    typed_factory->GetOrCreate(this->shared_from_this());
+    return typed_factory->GetColumns();
 }
 
 /// GetFactoryAll returns all JFactoryT's for type T (each corresponds to a different tag).
@@ -39,6 +39,9 @@ public:
 
     bool AreEventsOrdered() const { return m_receive_events_in_order; }
 
+    /// The (object name, tag) of every collection this processor declared with DeclarePrefetch()
+    const std::vector<std::pair<std::string, std::string>>& GetPrefetchedCollections() const { return m_prefetched_collections; }
+
 
     virtual void DoInitialize() {
         try {
@@ -176,12 +179,21 @@ protected:
     void SetResourceName(std::string resource_name) { m_resource_name = std::move(resource_name); }
 
     /// SetEventsOrdered allows the user to tell the parallelization engine that it needs to see
-    /// the event stream ordered by increasing event IDs. (Note that this requires all EventSources
-    /// emit event IDs which are consecutive.) Ordering by event ID makes for cleaner output, but comes
-    /// with a performance penalty, so it is best if this is enabled during debugging, and disabled otherwise.
+    /// the event stream in the order the EventSources emitted it, which for the default event numbering
+    /// means increasing event IDs. Ordered processors run sequentially behind a reorder buffer (see
+    /// jana:reorder_window) while unordered processors keep running in parallel. Ordering makes for cleaner
+    /// output, but comes with a performance penalty, so it is best if this is enabled during debugging, and disabled otherwise.
 
     void SetEventsOrdered(bool receive_events_in_order) { m_receive_events_in_order = receive_events_in_order; }
 
+    /// DeclarePrefetch tells the parallelization engine up front that Process() will Get() this collection.
+    /// With jana:parallel_factories enabled, the engine creates the declared collections, along with the factories
+    /// they depend on, concurrently on the worker pool before Process() is called, so that independent factories
+    /// of the same event no longer wait on each other. Process() still calls Get() as usual; the data is simply
+    /// already there. Declaring a collection which turns out not to be needed costs that factory's Process().
+    template <typename T>
+    void DeclarePrefetch(const std::string& tag = "") { m_prefetched_collections.emplace_back(JTypeInfo::demangle<T>(), tag); }
+
     // TODO: Stop getting mApplication this way, use GetApplication() instead, or pass directly to Init()
     JApplication* mApplication = nullptr;
 
@@ -196,6 +208,7 @@ private:
     int32_t m_last_run_number = -1;
     std::mutex m_mutex;
     bool m_receive_events_in_order = false;
+    std::vector<std::pair<std::string, std::string>> m_prefetched_collections;
 
     /// This is called by JApplication::Add(JEventProcessor*). There
     /// should be no need to call it from anywhere else.
@@ -89,17 +89,21 @@ public:
     class PrefetchT : public Prefetch {
     public:
         // This constructor gets called by the {this} initializer for the data member.
-        PrefetchT(JEventProcessorSequentialRoot *jeps, const std::string &tag = "") : mTag(
-                tag) { jeps->mPrefetch.push_back(this); }
+        PrefetchT(JEventProcessorSequentialRoot *jeps, const std::string &tag = "") : mHandle(
+                tag) { jeps->mPrefetch.push_back(this); jeps->DeclarePrefetch<T>(tag); }
 
         std::vector<const T*> &operator()() { return mObjs; }
-        void Get(const std::shared_ptr<const JEvent> &event) { event->Get<T>(mTag); }
-        void Fill(const std::shared_ptr<const JEvent> &event) { mObjs = event->Get<T>(mTag); }
+        void Get(const std::shared_ptr<const JEvent> &event) { event->GetIterators(mHandle); }
+        void Fill(const std::shared_ptr<const JEvent> &event) {
+            // assign() reuses mObjs' capacity, so once it has grown this doesn't allocate at all
+            auto objs = event->GetSpan(mHandle);
+            mObjs.assign(objs.begin(), objs.end());
+        }
 
     private:
         PrefetchT() = default; // user must pass "this" so member can be added to our mPrefetch
 
-        std::string mTag;
+        JFactoryHandle<T> mHandle;
         std::vector<const T *> mObjs;
     };
 
@@ -8,6 +8,9 @@
 
 void JFactory::Create(const std::shared_ptr<const JEvent>& event) {
 
+    // Another thread may be creating this factory for the same event; if so, wait for it and then find it Processed
+    std::lock_guard<std::mutex> lock(mMutex);
+
     // Make sure that we have a valid JApplication before attempting to call callbacks
     if (mApp == nullptr) mApp = event->GetJApplication();
     auto run_number = event->GetRunNumber();
@@ -31,6 +34,8 @@ void JFactory::Create(const std::shared_ptr<const JEvent>& event) {
         }
     }
     if (mStatus == Status::Unprocessed) {
+        auto start_time = (mLatencyHistogram != nullptr) ? std::chrono::steady_clock::now()
+                                                         : std::chrono::steady_clock::time_point();
         if (mPreviousRunNumber == -1) {
             // This is the very first run
             ChangeRun(event);
@@ -45,6 +50,10 @@ void JFactory::Create(const std::shared_ptr<const JEvent>& event) {
             mPreviousRunNumber = run_number;
         }
         Process(event);
+        AfterProcess();
+        if (mLatencyHistogram != nullptr) {
+            mLatencyHistogram->record(std::chrono::steady_clock::now() - start_time);
+        }
         mStatus = Status::Processed;
         mCreationStatus = CreationStatus::Created;
     }
@@ -6,8 +6,10 @@
 #define _JFactory_h_
 
 #include <JANA/JException.h>
-#include <JANA/Utils/JAny.h>
 #include <JANA/Utils/JCallGraphRecorder.h>
+#include <JANA/Utils/JLatencyHistogram.h>
+#include <JANA/Utils/JPoolStatistics.h>
+#include <JANA/Utils/JUpcastView.h>
 
 #include <string>
 #include <typeindex>
@@ -117,27 +119,53 @@ public:
         return 0;
     }
 
+    /// GetEstimatedBytes() reports roughly how much memory this factory's data for the current event occupies.
+    /// It only matters when jana:max_bytes_in_flight is set. JFactoryT<T> counts sizeof(T) per object, which
+    /// misses anything the objects own on the heap, so factories producing large payloads should override it.
+    virtual std::size_t GetEstimatedBytes() const {
+        return 0;
+    }
+
 
     /// Access the encapsulated data, performing an upcast if necessary. This is useful for extracting data from
     /// all JFactories<T> where T extends a parent class S, such as JObject or TObject, in contexts where T is not known
     /// or it would introduce an unwanted coupling. The main application is for building DSTs.
     ///
     /// Be aware of the following caveats:
-    /// - The factory's object type must not use virtual inheritance.
     /// - If JFactory::Process hasn't already been called, this will return an empty vector. This will NOT call JFactory::Process.
     /// - Someone must call JFactoryT<T>::EnableGetAs<S>, preferably the constructor. Otherwise, this will return an empty vector.
     /// - If S isn't a base class of T, this will return an empty vector.
     template<typename S>
     std::vector<S*> GetAs();
 
+    /// GetAsView is GetAs without the vector: the view upcasts each object as it is read, so nothing gets allocated
+    /// or copied. It has the same caveats as GetAs, and stays valid until the factory is cleared.
+    template<typename S>
+    JUpcastView<S> GetAsView() const;
+
     /// Create() calls JFactory::Init,BeginRun,Process in an invariant-preserving way without knowing the exact
     /// type of object contained. It returns the number of objects created. In order to access said objects,
     /// use JFactory::GetAs().
+    /// Create() may be called from several threads at once for the same event (see jana:parallel_factories):
+    /// exactly one of them runs Process(), and the others wait for it to finish.
     virtual void Create(const std::shared_ptr<const JEvent>& event);
 
     /// JApplication setter. This is meant to be used under the hood.
     void SetApplication(JApplication* app) { mApp = app; }
 
+    /// Histogram which Create() records each Process() call's latency into, including the factories it calls.
+    /// This is meant to be used under the hood: JComponentManager shares one histogram between every event's
+    /// instance of the same factory. nullptr means don't record.
+    void SetLatencyHistogram(JLatencyHistogram* histogram) { mLatencyHistogram = histogram; }
+
+    /// Whether this factory recycles its objects through an object pool, see JFactoryPooledT.
+    virtual bool RecyclesObjects() const { return false; }
+
+    /// Counters which a factory that RecyclesObjects() records its pool hits and misses into. Like the latency
+    /// histogram, JComponentManager shares one between every event's instance of the same factory. nullptr means
+    /// don't record.
+    void SetPoolStatistics(JPoolStatistics* statistics) { mPoolStatistics = statistics; }
+
     /// JApplication getter. This is meant to be called by user-defined JFactories which need to
     /// acquire parameter values or services from JFactory::Init()
     JApplication* GetApplication() { return mApp; }
@@ -155,38 +183,55 @@ protected:
     uint32_t mFlags = 0;
     int32_t mPreviousRunNumber = -1;
     JApplication* mApp = nullptr;
-    std::unordered_map<std::type_index, std::unique_ptr<JAny>> mUpcastVTable;
+    JLatencyHistogram* mLatencyHistogram = nullptr;
+    JPoolStatistics* mPoolStatistics = nullptr;
+
+    /// One entry per S which EnableGetAs<S>() allowed, holding JUpcastAt<T, S>
+    struct UpcastEntry {
+        std::type_index type;
+        JUpcastAccessor upcast_at;
+    };
+    std::vector<UpcastEntry> mUpcastTable;
+
+    /// The objects' T* array converted to void*, for the mUpcastTable accessors. JFactoryT<T> overrides this.
+    virtual const void* GetUpcastSource() const { return nullptr; }
+
+    /// Create() calls AfterProcess() right after Process(), still holding mMutex and before the status becomes
+    /// Processed. Factory base classes which derive part of their output from what Process() produced build it here,
+    /// so that no other thread can see the output half-built.
+    virtual void AfterProcess() {}
 
-    mutable Status mStatus = Status::Uninitialized;
+    mutable std::atomic<Status> mStatus {Status::Uninitialized};  // Create() checks it under mMutex, GetOrCreate() skips that once Processed
     mutable JCallGraphRecorder::JDataOrigin m_insert_origin = JCallGraphRecorder::ORIGIN_NOT_AVAILABLE; // (see note at top of JCallGraphRecorder.h)
 
-    CreationStatus mCreationStatus = CreationStatus::NotCreatedYet;
-    mutable std::mutex mMutex;
+    std::atomic<CreationStatus> mCreationStatus {CreationStatus::NotCreatedYet};
+    mutable std::mutex mMutex;   // Serializes Create()
 
     // Used to make sure Init is called only once
     std::once_flag mInitFlag;
 };
 
-// Because C++ doesn't support templated virtual functions, we implement our own dispatch table, mUpcastVTable.
+// Because C++ doesn't support templated virtual functions, we implement our own dispatch table, mUpcastTable.
 // This means that the JFactoryT is forced to manually populate this table by calling JFactoryT<T>::EnableGetAs.
-// We have the option to make the vtable be a static member of JFactoryT<T>, but we have chosen not to because:
-//
-//   1. It would be inconsistent with the fact that the user is supposed to call EnableGetAs in the ctor
-//   2. People in the future may want to generalize GetAs to support user-defined S* -> T* conversions (which I don't recommend)
-//   3. The size of the vtable is expected to be very small (<10 elements, most likely 2)
+// Each entry holds a plain function pointer rather than a std::function, so looking one up and calling it per object
+// costs no allocation. The table is expected to be very small (<10 elements, most likely 2), so a linear search
+// beats hashing.
 
 template<typename S>
-std::vector<S*> JFactory::GetAs() {
-    std::vector<S*> results;
-    auto ti = std::type_index(typeid(S));
-    auto search = mUpcastVTable.find(ti);
-    if (search != mUpcastVTable.end()) {
-        using upcast_fn_t = std::function<std::vector<S*>()>;
-        auto temp = static_cast<JAnyT<upcast_fn_t>*>(&(*search->second));
-        upcast_fn_t upcast_fn = temp->t;
-        results = upcast_fn();
+JUpcastView<S> JFactory::GetAsView() const {
+    std::type_index ti(typeid(S));
+    for (auto& entry : mUpcastTable) {
+        if (entry.type == ti) {
+            return JUpcastView<S>(GetUpcastSource(), GetNumObjects(), entry.upcast_at);
+        }
     }
-    return results;
+    return {};
+}
+
+template<typename S>
+std::vector<S*> JFactory::GetAs() {
+    auto view = GetAsView<S>();
+    return std::vector<S*>(view.begin(), view.end());
 }
 
 #endif // _JFactory_h_
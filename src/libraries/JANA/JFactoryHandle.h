@@ -0,0 +1,36 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JFACTORYHANDLE_H
+#define JANA2_JFACTORYHANDLE_H
+
+#include <JANA/JFactorySet.h>
+
+#include <string>
+
+/// JFactoryHandle<T> names the collection (T, tag) once, so that hot code can call event->Get(handle) instead of
+/// event->Get<T>(tag). Constructing the handle does the type and tag lookup; every Get(handle) afterwards is a single
+/// index into the event's JFactorySet. A handle works for every event, including every event in the JEventPool,
+/// because the index it carries is assigned per (type, tag) across the whole process rather than per JFactorySet.
+///
+/// Construct handles in a constructor or Init(), and keep them as members:
+///
+///     JFactoryHandle<Cluster> m_clusters {"calibrated"};
+///     void Process(const std::shared_ptr<const JEvent>& event) override {
+///         for (auto cluster : event->Get(m_clusters)) { ... }
+///     }
+template <typename T>
+class JFactoryHandle {
+    std::string m_tag;
+    size_t m_key_id;
+
+public:
+    explicit JFactoryHandle(const std::string& tag = "")
+        : m_tag(tag)
+        , m_key_id(JFactorySet::GetKeyId(JFactorySet::GetTypeId<T>(), tag)) {}
+
+    const std::string& GetTag() const { return m_tag; }
+    size_t GetKeyId() const { return m_key_id; }
+};
+
+#endif //JANA2_JFACTORYHANDLE_H
@@ -2,8 +2,11 @@
 // Copyright 2020, Jefferson Science Associates, LLC.
 // Subject to the terms in the LICENSE file found in the top-level directory.
 
+#include <algorithm>
 #include <iterator>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
 
 #include "JApplication.h"
 #include "JFactorySet.h"
@@ -94,6 +97,7 @@ bool JFactorySet::Add(JFactory* aFactory)
 
     mFactories[typed_key] = aFactory;
     mFactoriesFromString[untyped_key] = aFactory;
+    IndexFactory(aFactory);
     return true;
 }
 
@@ -115,6 +119,60 @@ bool JFactorySet::Add(JMultifactory *multifactory) {
     return true;
 }
 
+//---------------------------------
+// GetTypeId
+//---------------------------------
+size_t JFactorySet::GetTypeId(std::type_index type) {
+    static std::mutex mutex;
+    static std::unordered_map<std::type_index, size_t> type_ids;
+    std::lock_guard<std::mutex> lock(mutex);
+    return type_ids.emplace(type, type_ids.size()).first->second;
+}
+
+//---------------------------------
+// GetKeyId
+//---------------------------------
+size_t JFactorySet::GetKeyId(size_t type_id, const std::string& tag) {
+    static std::mutex mutex;
+    static std::map<std::pair<size_t, std::string>, size_t> key_ids;
+    std::lock_guard<std::mutex> lock(mutex);
+    return key_ids.emplace(std::make_pair(type_id, tag), key_ids.size()).first->second;
+}
+
+//---------------------------------
+// IndexFactory
+//---------------------------------
+void JFactorySet::IndexFactory(JFactory* factory) {
+    auto type_id = GetTypeId(factory->GetObjectType());
+    if (type_id >= mFactoriesByTypeId.size()) mFactoriesByTypeId.resize(type_id + 1);
+    auto& entries = mFactoriesByTypeId[type_id];
+    auto entry = std::make_pair(factory->GetTag(), factory);
+    entries.insert(std::upper_bound(entries.begin(), entries.end(), entry,
+                                    [](const std::pair<std::string, JFactory*>& a, const std::pair<std::string, JFactory*>& b) {
+                                        return a.first < b.first;
+                                    }),
+                   entry);
+
+    auto key_id = GetKeyId(type_id, factory->GetTag());
+    if (key_id >= mFactoriesByKeyId.size()) mFactoriesByKeyId.resize(key_id + 1, nullptr);
+    mFactoriesByKeyId[key_id] = factory;
+}
+
+//---------------------------------
+// ReindexFactories
+//---------------------------------
+void JFactorySet::ReindexFactories() {
+    /// Rebuilds the lookup tables from mFactories, after Merge() has swapped mFactories out from under them.
+    mFactoriesFromString.clear();
+    mFactoriesByTypeId.clear();
+    mFactoriesByKeyId.clear();
+    for (auto& pair : mFactories) {
+        auto factory = pair.second;
+        mFactoriesFromString[std::make_pair(factory->GetObjectName(), factory->GetTag())] = factory;
+        IndexFactory(factory);
+    }
+}
+
 //---------------------------------
 // GetFactory
 //---------------------------------
@@ -137,6 +195,21 @@ std::vector<JFactory*> JFactorySet::GetAllFactories() const {
 }
 
 
+//---------------------------------
+// GetEstimatedBytes
+//---------------------------------
+std::size_t JFactorySet::GetEstimatedBytes() const {
+    std::size_t bytes = 0;
+    for (auto p : mFactories) {
+        auto status = p.second->GetStatus();
+        if (status == JFactory::Status::Processed || status == JFactory::Status::Inserted) {
+            bytes += p.second->GetEstimatedBytes();
+        }
+    }
+    return bytes;
+}
+
+
 //---------------------------------
 // Merge
 //---------------------------------
@@ -168,12 +241,14 @@ void JFactorySet::Merge(JFactorySet &aFactorySet)
         else {
             mFactories[typed_key] = factory;
             mFactoriesFromString[untyped_key] = factory;
+            IndexFactory(factory);
         }
     }
 
     // Copy duplicates back to aFactorySet
     aFactorySet.mFactories.swap( tmpSet.mFactories );
     tmpSet.mFactories.clear(); // prevent ~JFactorySet from deleting any factories
+    aFactorySet.ReindexFactories();
 
     // Move ownership of multifactory pointers over.
     for (auto* mf : aFactorySet.mMultifactories) {
@@ -8,6 +8,7 @@
 #include <string>
 #include <typeindex>
 #include <map>
+#include <vector>
 
 #include <JANA/JFactoryT.h>
 #include <JANA/Utils/JResettable.h>
@@ -32,6 +33,20 @@ class JFactorySet : public JResettable
         void Print(void) const;
         void Release(void);
 
+        /// GetTypeId() hands out dense ids, 0,1,2,..., one per object type, shared by every JFactorySet in the process.
+        /// The templated version only takes the registry's lock the first time it is called for each T.
+        static size_t GetTypeId(std::type_index type);
+        template<typename T> static size_t GetTypeId();
+
+        /// GetKeyId() hands out dense ids, one per (type id, tag), shared by every JFactorySet in the process.
+        /// These are what JFactoryHandle carries around.
+        static size_t GetKeyId(size_t type_id, const std::string& tag);
+
+        /// GetFactoryByKeyId() is the lookup behind JEvent::Get(handle). Returns nullptr if this set has no such factory.
+        JFactory* GetFactoryByKeyId(size_t key_id) const {
+            return (key_id < mFactoriesByKeyId.size()) ? mFactoriesByKeyId[key_id] : nullptr;
+        }
+
         JFactory* GetFactory(const std::string& object_name, const std::string& tag="") const;
         template<typename T> JFactoryT<T>* GetFactory(const std::string& tag = "") const;
         std::vector<JFactory*> GetAllFactories() const;
@@ -39,24 +54,43 @@ class JFactorySet : public JResettable
 
         std::vector<JFactorySummary> Summarize() const;
 
+        /// GetEstimatedBytes() sums JFactory::GetEstimatedBytes() over every factory which has data for this event
+        std::size_t GetEstimatedBytes() const;
+
     protected:
         std::map<std::pair<std::type_index, std::string>, JFactory*> mFactories;        // {(typeid, tag) : factory}
         std::map<std::pair<std::string, std::string>, JFactory*> mFactoriesFromString;  // {(objname, tag) : factory}
+        std::vector<std::vector<std::pair<std::string, JFactory*>>> mFactoriesByTypeId; // [type id] -> [(tag, factory)], sorted by tag
+        std::vector<JFactory*> mFactoriesByKeyId;                                        // [key id] -> factory, or nullptr
         std::vector<JMultifactory*> mMultifactories;
         bool mIsFactoryOwner = true;
+
+    private:
+        void IndexFactory(JFactory* factory);
+        void ReindexFactories();
 };
 
 
+template<typename T>
+size_t JFactorySet::GetTypeId() {
+    static const size_t type_id = GetTypeId(std::type_index(typeid(T)));
+    return type_id;
+}
+
+
 template<typename T>
 JFactoryT<T>* JFactorySet::GetFactory(const std::string& tag) const {
 
-    auto typed_key = std::make_pair(std::type_index(typeid(T)), tag);
-    auto typed_iter = mFactories.find(typed_key);
-    if (typed_iter != std::end(mFactories)) {
-        return static_cast<JFactoryT<T>*>(typed_iter->second);
+    // Types usually have one factory, or a handful with different tags, so a scan beats any map here
+    auto type_id = GetTypeId<T>();
+    if (type_id < mFactoriesByTypeId.size()) {
+        for (auto& entry : mFactoriesByTypeId[type_id]) {
+            if (entry.first == tag) return static_cast<JFactoryT<T>*>(entry.second);
+        }
     }
 
-    auto untyped_key = std::make_pair(JTypeInfo::demangle<T>(), tag);
+    // The factory may have been registered under a different typeid for the same type, e.g. from another plugin
+    auto untyped_key = std::make_pair(JTypeInfo::demangled_name<T>(), tag);
     auto untyped_iter = mFactoriesFromString.find(untyped_key);
     if (untyped_iter != std::end(mFactoriesFromString)) {
         return static_cast<JFactoryT<T>*>(untyped_iter->second);
@@ -66,11 +100,11 @@ JFactoryT<T>* JFactorySet::GetFactory(const std::string& tag) const {
 
 template<typename T>
 std::vector<JFactoryT<T>*> JFactorySet::GetAllFactories() const {
-    auto sKey = std::type_index(typeid(T));
     std::vector<JFactoryT<T>*> data;
-    for (auto it=std::begin(mFactories);it!=std::end(mFactories);it++){
-        if (it->first.first==sKey){
-            data.push_back(static_cast<JFactoryT<T>*>(it->second));
+    auto type_id = GetTypeId<T>();
+    if (type_id < mFactoriesByTypeId.size()) {
+        for (auto& entry : mFactoriesByTypeId[type_id]) {
+            data.push_back(static_cast<JFactoryT<T>*>(entry.second));
         }
     }
     return data;
@@ -0,0 +1,189 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JFACTORYSOA_H
+#define JANA2_JFACTORYSOA_H
+
+#include <JANA/JFactoryT.h>
+#include <JANA/Utils/JSpan.h>
+
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// The JCOLUMN macro declares a column for JSoA and JFactorySoA: a tag type which knows its element type and its
+/// name. The name is what JSoARow::Summarize() reports, e.g. as a column header in JCsvWriter's output.
+///     JCOLUMN(HitEnergy, float);
+#define JCOLUMN(ColumnName, ElementType) \
+    struct ColumnName { \
+        using type = ElementType; \
+        static constexpr const char* name = #ColumnName; \
+    }
+
+
+/// JColumnIndex finds the position of column C among Columns, at compile time
+template <typename C, typename... Columns> struct JColumnIndex;
+
+template <typename C, typename... Columns>
+struct JColumnIndex<C, C, Columns...> : std::integral_constant<size_t, 0> {};
+
+template <typename C, typename D, typename... Columns>
+struct JColumnIndex<C, D, Columns...> : std::integral_constant<size_t, 1 + JColumnIndex<C, Columns...>::value> {};
+
+
+/// JSoA is a structure of arrays: one contiguous std::vector per column, all of the same length. Row i is the i-th
+/// element of every column. Kernels which only need a few fields stream through exactly those, without pointer
+/// chasing, which is what lets the compiler vectorize them.
+template <typename... Columns>
+class JSoA {
+    static_assert(sizeof...(Columns) > 0, "JSoA needs at least one column");
+    static_assert(!(std::is_same<typename Columns::type, bool>::value || ...),
+                  "std::vector<bool> isn't contiguous, so JSoA can't hand out spans of it. Use char or uint8_t instead");
+
+    std::tuple<std::vector<typename Columns::type>...> m_columns;
+
+public:
+    static constexpr size_t column_count = sizeof...(Columns);
+
+    size_t size() const { return std::get<0>(m_columns).size(); }
+    bool empty() const { return size() == 0; }
+
+    void reserve(size_t n) { std::apply([n](auto&... column) { (column.reserve(n), ...); }, m_columns); }
+    void resize(size_t n) { std::apply([n](auto&... column) { (column.resize(n), ...); }, m_columns); }
+    void clear() { std::apply([](auto&... column) { (column.clear(), ...); }, m_columns); }
+
+    /// push_back appends one row, given one value per column, in the order of Columns. It returns the row's index.
+    size_t push_back(const typename Columns::type&... values) {
+        push_back_impl(std::index_sequence_for<Columns...>(), values...);
+        return size() - 1;
+    }
+
+    /// Get returns column C as a read-only span
+    template <typename C>
+    JSpan<const typename C::type> Get() const {
+        return std::get<JColumnIndex<C, Columns...>::value>(m_columns);
+    }
+
+    /// GetMutable returns column C itself, for whoever produces the data. Keep all columns the same length.
+    template <typename C>
+    std::vector<typename C::type>& GetMutable() {
+        return std::get<JColumnIndex<C, Columns...>::value>(m_columns);
+    }
+
+    /// ForEachColumn calls f(name, span) for every column, in order
+    template <typename F>
+    void ForEachColumn(F&& f) const {
+        (f(Columns::name, Get<Columns>()), ...);
+    }
+
+    size_t GetEstimatedBytes() const { return size() * (sizeof(typename Columns::type) + ... + 0); }
+
+private:
+    template <size_t... Is>
+    void push_back_impl(std::index_sequence<Is...>, const typename Columns::type&... values) {
+        (std::get<Is>(m_columns).push_back(values), ...);
+    }
+};
+
+
+/// JSoARow is a JObject view of one row of a JSoA. It copies nothing: it only remembers the JSoA and the index.
+/// It exists so that everything which works with JObjects (JInspector, JCsvWriter, JEvent::GetAll, ...) can work
+/// with the output of a JFactorySoA too.
+template <typename... Columns>
+class JSoARow : public JObject {
+    const JSoA<Columns...>* m_soa = nullptr;
+    size_t m_index = 0;
+
+public:
+    JSoARow() = default;
+    JSoARow(const JSoA<Columns...>* soa, size_t index) : m_soa(soa), m_index(index) {}
+
+    size_t GetIndex() const { return m_index; }
+
+    template <typename C>
+    const typename C::type& Get() const { return m_soa->template Get<C>()[m_index]; }
+
+    const std::string className() const override { return JTypeInfo::demangle<JSoARow>(); }
+
+    void Summarize(JObjectSummary& summary) const override {
+        m_soa->ForEachColumn([&](const char* name, auto column) {
+            using ElementT = typename decltype(column)::value_type;
+            if constexpr (std::is_arithmetic<ElementT>::value) {
+                summary.add({name, JTypeInfo::builtin_typename<ElementT>(), std::to_string(column[m_index]), ""});
+            }
+            else {
+                summary.add({name, JTypeInfo::builtin_typename<ElementT>(), "?", ""});
+            }
+        });
+    }
+};
+
+
+/// JFactorySoA is a factory whose output is a JSoA instead of a vector of pointers to objects. Process() fills
+/// mColumns, e.g. with mColumns.push_back(...), and consumers read whole columns with JEvent::GetColumns():
+///
+///     JCOLUMN(HitEnergy, float);
+///     JCOLUMN(HitX, float);
+///     struct HitFactory : public JFactorySoA<HitEnergy, HitX> { ... };
+///
+///     auto hits = event->GetColumns<HitEnergy, HitX>();
+///     for (float e : hits.Get<HitEnergy>()) ...
+///
+/// To everything else, it looks like a JFactoryT<JSoARow<Columns...>>, so event->Get<JSoARow<HitEnergy, HitX>>(),
+/// GetAs<JObject>(), JCsvWriter and JInspector keep working. The row views live in one contiguous vector which is
+/// reused from event to event. Kernels which never need them may turn them off with SetRowViewsEnabled(false); Get()
+/// then returns nothing, though GetNumObjects() still counts the rows.
+template <typename... Columns>
+class JFactorySoA : public JFactoryT<JSoARow<Columns...>> {
+public:
+    using RowT = JSoARow<Columns...>;
+    using ColumnsT = JSoA<Columns...>;
+
+    JFactorySoA() {
+        // mData points into mRows, which we own
+        this->SetFactoryFlag(JFactory::NOT_OBJECT_OWNER);
+    }
+
+    const ColumnsT& GetColumns() const { return mColumns; }
+
+    /// Row views are on by default. Turning them off saves building one JSoARow per row per event.
+    void SetRowViewsEnabled(bool enabled) { mRowViewsEnabled = enabled; }
+
+    std::size_t GetNumObjects() const override { return mColumns.size(); }
+    std::size_t GetEstimatedBytes() const override { return mColumns.GetEstimatedBytes() + mRows.size() * sizeof(RowT); }
+
+    void ClearData() override {
+        if (this->mStatus == JFactory::Status::Uninitialized) return;
+        if (this->TestFactoryFlag(JFactory::JFactory_Flags_t::PERSISTENT)) return;
+        mColumns.clear();
+        mRows.clear();
+        JFactoryT<RowT>::ClearData();
+    }
+
+protected:
+    ColumnsT mColumns;
+
+    /// The row views are built before the factory is marked Processed, so that a thread which finds it Processed
+    /// (e.g. with jana:parallel_factories) never sees them half-built
+    void AfterProcess() override {
+        if (mRowViewsEnabled) BuildRowViews();
+    }
+
+private:
+    void BuildRowViews() {
+        size_t n = mColumns.size();
+        mRows.resize(n);  // Before taking any pointers: resizing moves the rows
+        this->mData.resize(n);
+        for (size_t i=0; i<n; ++i) {
+            mRows[i] = RowT(&mColumns, i);
+            this->mData[i] = &mRows[i];
+        }
+    }
+
+    std::vector<RowT> mRows;
+    bool mRowViewsEnabled = true;
+};
+
+#endif //JANA2_JFACTORYSOA_H
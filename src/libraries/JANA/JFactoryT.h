@@ -7,10 +7,13 @@
 
 #include <vector>
 #include <type_traits>
+#include <unordered_set>
 
 #include <JANA/JApplication.h>
 #include <JANA/JFactory.h>
 #include <JANA/JObject.h>
+#include <JANA/Utils/JArena.h>
+#include <JANA/Utils/JSpan.h>
 #include <JANA/Utils/JTypeInfo.h>
 
 #ifdef HAVE_ROOT
@@ -57,7 +60,12 @@ public:
 #endif
     }
 
-    ~JFactoryT() override = default;
+    ~JFactoryT() override {
+        // Emplaced objects which ClearData() never got to still need their destructors run
+        if (!std::is_trivially_destructible<T>::value) {
+            for (auto p : mArenaObjects) p->T::~T();  // Exactly a T, so skip the virtual call
+        }
+    }
 
     void Init() override {}
     void BeginRun(const std::shared_ptr<const JEvent>&) override {}
@@ -74,12 +82,18 @@ public:
         return mData.size();
     }
 
+    std::size_t GetEstimatedBytes() const override {
+        return mData.size() * sizeof(T);
+    }
+
     /// GetOrCreate handles all the preconditions and postconditions involved in calling the user-defined Open(),
     /// ChangeRun(), and Process() methods. These include making sure the JFactory JApplication is set, Init() is called
     /// exactly once, exceptions are tagged with the originating plugin and eventsource, ChangeRun() is
     /// called if and only if the run number changes, etc.
     PairType GetOrCreate(const std::shared_ptr<const JEvent>& event) {
-        if (mStatus == Status::Uninitialized || mStatus == Status::Unprocessed) {
+        // Only Processed is final: Inserted may mean that Process() is still inserting on another thread, so anything
+        // else goes through Create(), which waits on mMutex for that to finish.
+        if (mStatus != Status::Processed) {
             Create(event);
         }
         if (mStatus != Status::Processed && mStatus != Status::Inserted) {
@@ -89,6 +103,13 @@ public:
     }
 
 
+    /// GetSpan returns the objects this factory holds right now, as a view over mData. Unlike GetOrCreate(), it
+    /// doesn't create anything. The view stays valid until the next ClearData(), Set() or Insert().
+    JSpan<const T* const> GetSpan() const {
+        return {mData.data(), mData.size()};
+    }
+
+
     /// Please use the typed setters instead whenever possible
     // TODO: Deprecate this!
     void Set(const std::vector<JObject*>& aData) override {
@@ -139,6 +160,29 @@ public:
         mCreationStatus = CreationStatus::Inserted;
     }
 
+    /// Emplace constructs a T from the given arguments and inserts it, just like Insert(new T(args...)). The difference
+    /// is where the T lives: in this factory's arena, whose memory gets reused event after event. ClearData() runs the
+    /// destructors and rewinds the arena in one go, instead of a delete per object. Factories which produce many small
+    /// objects per event should prefer this. Emplaced objects die with the event, regardless of NOT_OBJECT_OWNER,
+    /// except in PERSISTENT factories, where Emplace falls back to new and the objects are handled like inserted ones.
+    template <typename... Args>
+    T* Emplace(Args&&... args) {
+        T* object;
+        if (TestFactoryFlag(JFactory_Flags_t::PERSISTENT)) {
+            // Persistent data outlives the event, so it can't live in the arena
+            if constexpr (std::is_aggregate_v<T>) object = new T{std::forward<Args>(args)...};
+            else object = new T(std::forward<Args>(args)...);
+        }
+        else {
+            void* memory = mArena.allocate(sizeof(T), alignof(T));
+            if constexpr (std::is_aggregate_v<T>) object = new (memory) T{std::forward<Args>(args)...};
+            else object = new (memory) T(std::forward<Args>(args)...);
+            mArenaObjects.push_back(object);
+        }
+        Insert(object);
+        return object;
+    }
+
 
     /// EnableGetAs generates a vtable entry so that users may extract the
     /// contents of this JFactoryT from the type-erased JFactory. The user has to manually specify which upcasts
@@ -163,9 +207,24 @@ public:
             return;
         }
 
-        // Assuming we _are_ the object owner, delete the underlying jobjects
+        // Assuming we _are_ the object owner, delete the underlying jobjects. Emplaced ones live in the arena instead.
         if (!TestFactoryFlag(JFactory_Flags_t::NOT_OBJECT_OWNER)) {
-            for (auto p : mData) delete p;
+            if (mArenaObjects.empty()) {
+                for (auto p : mData) delete p;
+            }
+            else if (mArenaObjects.size() != mData.size()) {
+                std::unordered_set<T*> emplaced(mArenaObjects.begin(), mArenaObjects.end());
+                for (auto p : mData) {
+                    if (emplaced.count(p) == 0) delete p;
+                }
+            }
+        }
+        if (!mArenaObjects.empty()) {
+            if (!std::is_trivially_destructible<T>::value) {
+                for (auto p : mArenaObjects) p->T::~T();  // Exactly a T, so skip the virtual call
+            }
+            mArenaObjects.clear();
+            mArena.reset();
         }
         mData.clear();
         mStatus = Status::Unprocessed;
@@ -182,26 +241,37 @@ public:
     JMetadata<T> GetMetadata() { return mMetadata; }
 
 
+    /// The arena behind Emplace(). Its capacity is how much memory this factory keeps around between events.
+    const JArena& GetArena() const { return mArena; }
+
+
 protected:
     std::vector<T*> mData;
     JMetadata<T> mMetadata;
+    std::vector<T*> mArenaObjects;  // What Emplace() put in mArena since the last ClearData()
+
+    /// GetUpcastSource hands mData to GetAs and GetAsView without its type. Only JUpcastAt<T, S> converts it back.
+    const void* GetUpcastSource() const override {
+        return mData.data();
+    }
+
+private:
+    JArena mArena;
 };
 
 template<typename T>
 template<typename S>
 void JFactoryT<T>::EnableGetAs() {
 
-    auto upcast_lambda = [this]() {
-        std::vector<S*> results;
-        for (auto t : mData) {
-            results.push_back(static_cast<S*>(t));
+    std::type_index key(typeid(S));
+    JUpcastAccessor upcast_at = &JUpcastAt<T, S>;
+    for (auto& entry : mUpcastTable) {
+        if (entry.type == key) {
+            entry.upcast_at = upcast_at;
+            return;
         }
-        return results;
-    };
-
-    auto key = std::type_index(typeid(S));
-    using upcast_fn_t = std::function<std::vector<S*>()>;
-    mUpcastVTable[key] = std::unique_ptr<JAny>(new JAnyT<upcast_fn_t>(std::move(upcast_lambda)));
+    }
+    mUpcastTable.push_back({key, upcast_at});
 }
 
 #endif // _JFactoryT_h_
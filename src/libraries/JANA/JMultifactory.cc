@@ -7,7 +7,13 @@
 #include <JANA/JEvent.h>
 
 
-void JMultifactory::Execute(const std::shared_ptr<const JEvent>& event) {
+void JMultifactory::Execute(const std::shared_ptr<const JEvent>& event, JFactory* helper) {
+
+    std::lock_guard<std::mutex> lock(m_execute_mutex);
+    if (helper != nullptr && helper->GetStatus() == JFactory::Status::Inserted) {
+        // Another helper's Execute() got here first and already SetData() on this one
+        return;
+    }
 
 #ifdef HAVE_PODIO
     if (mNeedPodio) {
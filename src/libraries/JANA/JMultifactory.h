@@ -63,6 +63,7 @@ class JMultifactory {
 
     std::once_flag m_is_initialized;
     std::once_flag m_is_finished;
+    std::mutex m_execute_mutex;  // Helpers of the same event may be created concurrently, see jana:parallel_factories
     int32_t m_last_run_number = -1;
     // Remember where we are in the stream so that the correct sequence of callbacks get called.
     // However, don't worry about a Status variable. Every time Execute() gets called, so does Process().
@@ -114,7 +115,8 @@ public:
 
     /// CALLED BY JANA
 
-    void Execute(const std::shared_ptr<const JEvent>&);
+    void Execute(const std::shared_ptr<const JEvent>&, JFactory* helper=nullptr);
+    // helper is the JMultifactoryHelper which wants its data. If a concurrent Execute() already filled it, we skip.
     // Should this be execute or create? Who is tracking that this is called at most once per event?
     // Do we need something like JFactory::Status? Also, how do we ensure that CreationStatus is correct as well?
 
@@ -213,13 +215,13 @@ void JMultifactory::SetCollection(std::string tag, std::unique_ptr<typename Podi
 
 template <typename T>
 void JMultifactoryHelper<T>::Process(const std::shared_ptr<const JEvent> &event) {
-    mMultiFactory->Execute(event);
+    mMultiFactory->Execute(event, this);
 }
 
 #ifdef HAVE_PODIO
 template <typename T>
 void JMultifactoryHelperPodio<T>::Process(const std::shared_ptr<const JEvent> &event) {
-    mMultiFactory->Execute(event);
+    mMultiFactory->Execute(event, this);
 }
 #endif // HAVE_PODIO
 
@@ -8,10 +8,13 @@
 #include <string>
 #include <sstream>
 #include <set>
+#include <unordered_set>
 #include <vector>
+#include <algorithm>
 #include <cassert>
 #include <typeinfo>
 
+#include <JANA/Utils/JSmallVector.h>
 #include <JANA/Utils/JTypeInfo.h>
 #include <JANA/JLogger.h>
 #include <JANA/JException.h>
@@ -79,7 +82,7 @@ class JObject{
         inline void AddAssociatedObjectAutoDelete(JObject *obj, bool auto_delete=true);
         inline void RemoveAssociatedObject(const JObject *obj);
         inline void ClearAssociatedObjects(void);
-        inline bool IsAssociated(const JObject* locObject) const {return (associated.find(locObject) != associated.end());}
+        inline bool IsAssociated(const JObject* locObject) const {return std::binary_search(associated.begin(), associated.end(), locObject);}
 
         template<class T> const T* GetSingle() const;
         template<class T> std::vector<const T*> Get() const;
@@ -106,8 +109,17 @@ class JObject{
         virtual void Summarize(JObjectSummary& summary) const;
 
     protected:
-        std::set<const JObject*> associated;
-        std::set<JObject*> auto_delete;
+        /// The associated objects are kept sorted by address, so that they come out in the same order as they did
+        /// when these were std::sets. Most objects have only a few, which then live inside the JObject itself.
+        JSmallVector<const JObject*, 3> associated;
+        JSmallVector<JObject*, 1> auto_delete;
+
+    private:
+        template<typename T>
+        void SearchAssociations(std::unordered_set<const JObject*> &already_checked,
+                                int &max_depth,
+                                std::vector<const T*> &objs_found,
+                                const std::string& classname) const;
 };
 
 
@@ -118,7 +130,8 @@ void JObject::AddAssociatedObject(const JObject *obj)
 {
     /// Add a JObject to the list of associated objects
     assert(obj!=NULL);
-    associated.insert(obj);
+    auto iter = std::lower_bound(associated.begin(), associated.end(), obj);
+    if(iter==associated.end() || *iter!=obj) associated.insert(iter, obj);
 }
 
 //--------------------------
@@ -137,7 +150,9 @@ void JObject::AddAssociatedObjectAutoDelete(JObject *obj, bool auto_delete)
     /// be deleted.
 
     AddAssociatedObject(obj);
-    if(auto_delete) this->auto_delete.insert(obj);
+    if(auto_delete && std::find(this->auto_delete.begin(), this->auto_delete.end(), obj)==this->auto_delete.end()){
+        this->auto_delete.push_back(obj);
+    }
 }
 
 //--------------------------
@@ -150,9 +165,9 @@ void JObject::RemoveAssociatedObject(const JObject *obj)
     /// object was added with the AddAssociatedObjectAutoDelete(...)
     /// method with the auto_delete flag set.
 
-    auto iter = associated.find(obj);
+    auto iter = std::lower_bound(associated.begin(), associated.end(), obj);
 
-    if(iter!=associated.end()){
+    if(iter!=associated.end() && *iter==obj){
         associated.erase(iter);
     }
 }
@@ -335,22 +350,21 @@ void JObject::Get(std::vector<const T*> &ptrs, std::string classname, int max_de
 
     if(classname=="")classname=T::static_className();
 
-    // Use the GetAssociatedAncestors method which may call itself
+    // Use the SearchAssociations method which may call itself
     // recursively to search all levels of association (at or
     // below this object. Objects for which this is an associated
-    // object are not checked for).
-    std::set<const JObject*> already_checked;
-    std::set<const T*> objs_found;
+    // object are not checked for). It does the same search as
+    // GetAssociatedAncestors, but collects into a vector instead of a
+    // set, and looks visited objects up in a hash set, so each object
+    // found costs amortized constant time.
+    std::unordered_set<const JObject*> already_checked;
     int my_max_depth = max_depth;
-    GetAssociatedAncestors(already_checked, my_max_depth, objs_found, classname);
-
-    // Copy results into caller's container
     ptrs.clear();
-    ptrs.insert(ptrs.end(), objs_found.begin(), objs_found.end());
-//	set<const T*>::iterator it;
-//	for(it=objs_found.begin(); it!=objs_found.end(); it++){
-//		ptrs.push_back(*it);
-//	}
+    SearchAssociations(already_checked, my_max_depth, ptrs, classname);
+
+    // Sort and remove duplicates, which is what collecting them in a set used to do
+    std::sort(ptrs.begin(), ptrs.end());
+    ptrs.erase(std::unique(ptrs.begin(), ptrs.end()), ptrs.end());
 }
 
 template<typename T>
@@ -397,6 +411,32 @@ void JObject::GetAssociatedAncestors(std::set<const JObject*> &already_checked,
     max_depth++;
 }
 
+template<typename T>
+void JObject::SearchAssociations(std::unordered_set<const JObject*> &already_checked, int &max_depth, std::vector<const T*> &objs_found, const std::string& classname) const
+{
+    /// The same search as GetAssociatedAncestors. objs_found may collect
+    /// duplicates, which the caller removes.
+
+    already_checked.insert(this);
+
+    max_depth--;
+
+    for( auto obj : associated ){
+
+        // Add to list if appropriate
+        if( classname == obj->className() ){
+            objs_found.push_back( dynamic_cast<const T*>(obj) );
+        }
+
+        // Check this object's associated objects if appropriate
+        if(max_depth<=0) continue;
+        if(!already_checked.insert(obj).second) continue;
+        obj->SearchAssociations(already_checked, max_depth, objs_found, classname);
+    }
+
+    max_depth++;
+}
+
 
 #endif // _JObject_h_
 
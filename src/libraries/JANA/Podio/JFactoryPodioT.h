@@ -153,7 +153,10 @@ podio::Frame* GetOrCreateFrame(const std::shared_ptr<const JEvent>& event);
 
 template <typename T>
 void JFactoryPodioT<T>::Create(const std::shared_ptr<const JEvent>& event) {
-    mFrame = GetOrCreateFrame(event);
+    // Inserted collections already have their frame, and another thread may still be filling it
+    if (this->mStatus == JFactory::Status::Uninitialized || this->mStatus == JFactory::Status::Unprocessed) {
+        mFrame = GetOrCreateFrame(event);
+    }
     JFactory::Create(event);
 }
 
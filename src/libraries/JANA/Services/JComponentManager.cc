@@ -69,6 +69,40 @@ void JComponentManager::configure_event(JEvent& event) {
     event.SetFactorySet(factory_set);
     event.SetDefaultTags(m_default_tags);
     event.GetJCallGraphRecorder()->SetEnabled(m_enable_call_graph_recording);
+
+    std::lock_guard<std::mutex> lock(m_factory_metrics_mutex);
+    for (auto factory : factory_set->GetAllFactories()) {
+        auto name = factory->GetObjectName();
+        if (!factory->GetTag().empty()) name += ":" + factory->GetTag();
+        if (m_record_factory_latency) {
+            auto& histogram = m_factory_latencies[name];
+            if (histogram == nullptr) histogram = std::make_unique<JLatencyHistogram>();
+            factory->SetLatencyHistogram(histogram.get());
+        }
+        if (factory->RecyclesObjects()) {
+            auto& statistics = m_factory_pool_statistics[name];
+            if (statistics == nullptr) statistics = std::make_unique<JPoolStatistics>();
+            factory->SetPoolStatistics(statistics.get());
+        }
+    }
+}
+
+std::vector<std::pair<std::string, const JLatencyHistogram*>> JComponentManager::get_factory_latencies() {
+    std::lock_guard<std::mutex> lock(m_factory_metrics_mutex);
+    std::vector<std::pair<std::string, const JLatencyHistogram*>> results;
+    for (auto& pair : m_factory_latencies) {
+        results.emplace_back(pair.first, pair.second.get());
+    }
+    return results;
+}
+
+std::vector<std::pair<std::string, const JPoolStatistics*>> JComponentManager::get_factory_pool_statistics() {
+    std::lock_guard<std::mutex> lock(m_factory_metrics_mutex);
+    std::vector<std::pair<std::string, const JPoolStatistics*>> results;
+    for (auto& pair : m_factory_pool_statistics) {
+        results.emplace_back(pair.first, pair.second.get());
+    }
+    return results;
 }
 
 void JComponentManager::initialize() {
@@ -78,6 +112,8 @@ void JComponentManager::initialize() {
     // JApplication is even constructed.
     auto parms = m_app->GetJParameterManager();
     parms->SetDefaultParameter("record_call_stack", m_enable_call_graph_recording, "Records a trace of who called each factory. Reduces performance but necessary for plugins such as janadot.");
+    parms->SetDefaultParameter("jana:record_factory_latency", m_record_factory_latency, "Records a latency histogram for each factory, so that the final report can show p50/p99/p99.9 per factory.")
+        ->SetIsAdvanced(true);
     parms->FilterParameters(m_default_tags, "DEFTAG:");
 }
 
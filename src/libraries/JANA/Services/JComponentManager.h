@@ -9,7 +9,12 @@
 #include <JANA/Services/JParameterManager.h>
 #include <JANA/Status/JComponentSummary.h>
 #include <JANA/Services/JServiceLocator.h>
+#include <JANA/Utils/JLatencyHistogram.h>
+#include <JANA/Utils/JPoolStatistics.h>
 
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 class JEventProcessor;
@@ -43,6 +48,13 @@ public:
 
     void configure_event(JEvent& event);
 
+    /// Latency histograms of every factory which has been configured so far, keyed by 'ObjectName' or
+    /// 'ObjectName:tag'. Each one covers that factory in every event.
+    std::vector<std::pair<std::string, const JLatencyHistogram*>> get_factory_latencies();
+
+    /// Pool hits and misses of every factory which recycles its objects (see JFactoryPooledT), keyed like the latencies.
+    std::vector<std::pair<std::string, const JPoolStatistics*>> get_factory_pool_statistics();
+
 private:
     // Sources need:    { typename, pluginname, srcname, status, evtcnt }
     // Processors need: { typename, pluginname, mutexgroup, status, evtcnt }
@@ -59,6 +71,11 @@ private:
 
     std::map<std::string, std::string> m_default_tags;
     bool m_enable_call_graph_recording = false;
+    bool m_record_factory_latency = true;
+
+    std::map<std::string, std::unique_ptr<JLatencyHistogram>> m_factory_latencies;
+    std::map<std::string, std::unique_ptr<JPoolStatistics>> m_factory_pool_statistics;
+    std::mutex m_factory_metrics_mutex;  // Events may be configured concurrently, see JEventPool
 
     uint64_t m_nskip=0;
     uint64_t m_nevents=0;
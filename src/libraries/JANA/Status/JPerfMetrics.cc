@@ -127,5 +127,29 @@ void JPerfMetrics::summarize(JPerfSummary& summary) {
     summary.thread_count = thread_count_;
 }
 
+/// Peek summarizes as if split(current_event_count) had just been called, without recording the split.
+/// This lets a second observer (e.g. the autoscaler) sample the stopwatch without shortening the
+/// interval which the next split() reports to the ticker.
+void JPerfMetrics::peek(size_t current_event_count, JPerfSummary& summary) {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto prev_time = prev_time_;
+    auto last_time = last_time_;
+    auto prev_event_count = prev_event_count_;
+    if (mode_ == Mode::Ticking) {
+        prev_time = last_time_;
+        last_time = Clock::now();
+        prev_event_count = last_event_count_;
+    }
+    summary.monotonic_events_completed = current_event_count;
+    summary.total_events_completed = current_event_count - start_event_count_;
+    summary.latest_events_completed = current_event_count - prev_event_count;
+    summary.total_uptime_s  = secs(last_time - start_time_).count();
+    summary.latest_uptime_s = secs(last_time - prev_time).count();
+    summary.avg_throughput_hz = summary.total_events_completed / summary.total_uptime_s;
+    summary.latest_throughput_hz = summary.latest_events_completed / summary.latest_uptime_s;
+    summary.thread_count = thread_count_;
+}
+
 
 
@@ -37,6 +37,8 @@ public:
 
     void summarize(JPerfSummary& summary);
 
+    void peek(size_t current_event_count, JPerfSummary& summary);
+
 private:
 
     using Clock = std::chrono::steady_clock;
@@ -10,6 +10,26 @@
 #include <cstddef>
 #include <ostream>
 #include <iomanip>
+#include <string>
+#include <vector>
+
+/// LatencySummary holds the latency percentiles of one stage, e.g. an arrow or a factory, per event
+struct LatencySummary {
+    std::string name;
+    size_t count = 0;
+    double p50_ms = 0;
+    double p99_ms = 0;
+    double p999_ms = 0;
+    double max_ms = 0;
+};
+
+/// PoolSummary holds how often one factory's object pool could hand out a recycled object
+struct PoolSummary {
+    std::string name;
+    size_t hits = 0;
+    size_t misses = 0;
+    double hit_rate = 0;
+};
 
 /// JPerfSummary is a plain-old-data container for performance metrics.
 /// JProcessingControllers expose a JPerfSummary object, which they may
@@ -24,6 +44,9 @@ struct JPerfSummary {
     double latest_uptime_s = 0;
     double avg_throughput_hz = 0;
     double latest_throughput_hz = 0;
+    std::vector<LatencySummary> arrow_latencies;
+    std::vector<LatencySummary> factory_latencies;   // Includes the factories each one calls. Slowest p99 first
+    std::vector<PoolSummary> factory_pools;          // Only factories which recycle their objects. Lowest hit rate first
 
     JPerfSummary() = default;
     JPerfSummary(const JPerfSummary&) = default;
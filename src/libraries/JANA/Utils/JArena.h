@@ -0,0 +1,92 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JARENA_H
+#define JANA2_JARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/// JArena is a bump allocator for objects which all die at the same time, such as everything one factory produces
+/// for one event. allocate() hands out the next aligned chunk of the current block, and reset() forgets everything at
+/// once while keeping the memory, so that the next event reuses it without touching malloc at all.
+///
+/// Blocks double in size as needed. When reset() finds that it needed several blocks, it swaps them for a single
+/// block big enough for all of them, so that after the first few events each event is served from one block.
+///
+/// JArena neither constructs nor destroys anything: callers placement-new into allocate(), and must run destructors
+/// themselves before reset(). It is not thread safe.
+class JArena {
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+    std::vector<Block> m_blocks;
+    size_t m_current_block = 0;
+    size_t m_offset = 0;            // Into m_blocks[m_current_block]
+    size_t m_initial_block_size;
+    size_t m_bytes_in_use = 0;
+
+    void add_block(size_t min_size) {
+        size_t size = m_blocks.empty() ? m_initial_block_size : m_blocks.back().size * 2;
+        while (size < min_size) size *= 2;
+        m_blocks.push_back({std::unique_ptr<char[]>(new char[size]), size});
+    }
+
+public:
+    explicit JArena(size_t initial_block_size = 4096) : m_initial_block_size(initial_block_size) {}
+
+    JArena(const JArena&) = delete;
+    JArena& operator=(const JArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        while (true) {
+            if (m_current_block < m_blocks.size()) {
+                auto& block = m_blocks[m_current_block];
+                auto base = reinterpret_cast<std::uintptr_t>(block.data.get());
+                auto aligned = (base + m_offset + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+                size_t end = (aligned - base) + bytes;
+                if (end <= block.size) {
+                    m_offset = end;
+                    m_bytes_in_use += bytes;
+                    return reinterpret_cast<void*>(aligned);
+                }
+                if (m_current_block + 1 < m_blocks.size()) {
+                    m_current_block++;
+                    m_offset = 0;
+                    continue;
+                }
+            }
+            add_block(bytes + alignment);
+            m_current_block = m_blocks.size() - 1;
+            m_offset = 0;
+        }
+    }
+
+    /// reset() makes all memory available again. Anything allocated before is gone.
+    void reset() {
+        if (m_blocks.size() > 1 && m_current_block > 0) {
+            size_t total = 0;
+            for (auto& block : m_blocks) total += block.size;
+            m_blocks.clear();
+            add_block(total);
+        }
+        m_current_block = 0;
+        m_offset = 0;
+        m_bytes_in_use = 0;
+    }
+
+    size_t get_bytes_in_use() const { return m_bytes_in_use; }
+
+    size_t get_capacity() const {
+        size_t total = 0;
+        for (auto& block : m_blocks) total += block.size;
+        return total;
+    }
+
+    size_t get_block_count() const { return m_blocks.size(); }
+};
+
+#endif //JANA2_JARENA_H
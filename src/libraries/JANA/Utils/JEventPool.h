@@ -9,13 +9,77 @@
 #include <JANA/JEvent.h>
 #include <JANA/JFactoryGenerator.h>
 #include <JANA/Services/JComponentManager.h>
+#include <JANA/Utils/JCpuInfo.h>
+#include <JANA/Utils/JProcessorMapping.h>
 
+#include <exception>
+#include <thread>
+
+/// JEventPool recycles JEvents, keeping a separate pool for each location in the JProcessorMapping.
+/// The pool_size events are split between the locations as evenly as possible. Each event belongs to the
+/// location whose pool created it, and always returns there, no matter which worker finishes it. get() prefers
+/// the caller's own location's events, but takes another location's rather than come back empty-handed, so that
+/// the sequential source arrow can keep the whole pool in flight from whichever worker runs it. When a JProcessorMapping with several locations is provided, each location's events
+/// are created on a thread pinned to one of that location's cpus, so that their memory is first touched
+/// (and therefore allocated) on the right socket or NUMA domain rather than wherever the main thread runs.
+///
+/// get() and put() never take a lock: each location's free events form a lock-free stack of slot indices.
+/// Being a stack, the event handed out next is the one returned most recently, whose memory is likeliest to
+/// still be in cache. Events are reset by put(), i.e. by whichever (parallel) worker finished them, rather than
+/// by get(), which is usually called from the sequential source arrow.
+///
+/// With a byte budget (see set_max_bytes_in_flight()), get() also refuses to hand out an event while the events
+/// already in flight are estimated to fill the budget. Since an event's size is only known once it has been
+/// processed, each event is charged the running average of the sizes (JEvent::GetEstimatedBytes()) of the events
+/// which came back before it, and credited the same amount when it comes back. Until the first event comes back
+/// with a size, there is no average to charge, so each event is charged the whole budget instead: the startup burst
+/// is admitted one event at a time.
 class JEventPool {
+public:
+    struct LocationStats {
+        size_t cpu_id = 0;             // Cpu which created this location's events
+        size_t numa_domain_id = 0;
+        bool is_pinned = false;        // Whether the events were actually created on cpu_id
+        size_t capacity = 0;
+        size_t available = 0;          // Events sitting in the pool, i.e. not in flight
+        size_t foreign_returns = 0;    // Events which a worker from some other location finished
+    };
+
 private:
+    using Event = std::shared_ptr<JEvent>;
+    static constexpr size_t NO_SLOT = static_cast<size_t>(-1);
 
     struct alignas(64) LocalPool {
-        std::mutex mutex;
-        std::vector<std::shared_ptr<JEvent>> events;
+        std::vector<Event> slots;                          // Every event this location owns. Fixed once populated
+        std::unique_ptr<std::atomic<uint32_t>[]> next;     // Free stack links: slot+1 of the next free slot, 0=none
+        alignas(64) std::atomic<uint64_t> head {0};        // ABA tag in the upper half, slot+1 of the top in the lower
+        std::atomic<size_t> available {0};
+        std::atomic<size_t> foreign_returns {0};
+        LocationStats stats;                               // Fixed once populated
+
+        void push(size_t slot) {
+            uint64_t old_head = head.load(std::memory_order_relaxed);
+            uint64_t new_head;
+            do {
+                next[slot].store(static_cast<uint32_t>(old_head), std::memory_order_relaxed);
+                new_head = (((old_head >> 32) + 1) << 32) | (slot + 1);
+            } while (!head.compare_exchange_weak(old_head, new_head, std::memory_order_release, std::memory_order_relaxed));
+            available.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        size_t pop() {
+            uint64_t old_head = head.load(std::memory_order_acquire);
+            uint64_t new_head;
+            do {
+                auto top = static_cast<uint32_t>(old_head);
+                if (top == 0) return NO_SLOT;
+                // If somebody else pops this slot first, this read may be stale, but then the tag has changed
+                // and the exchange fails
+                new_head = (((old_head >> 32) + 1) << 32) | next[top - 1].load(std::memory_order_relaxed);
+            } while (!head.compare_exchange_weak(old_head, new_head, std::memory_order_acquire, std::memory_order_acquire));
+            available.fetch_sub(1, std::memory_order_relaxed);
+            return static_cast<uint32_t>(old_head) - 1;
+        }
     };
 
     std::shared_ptr<JComponentManager> m_component_manager;
@@ -24,11 +88,141 @@ private:
     bool m_limit_total_events_in_flight;
     std::unique_ptr<LocalPool[]> m_pools;
 
+    size_t m_max_bytes_in_flight = 0;            // 0 means no byte budget
+    std::atomic<int64_t> m_bytes_in_flight {0};
+    std::atomic<size_t> m_avg_event_bytes {0};   // Exponentially weighted, over returned events
+    std::atomic<bool> m_avg_known {false};       // Whether m_avg_event_bytes may be charged yet
+    std::atomic<size_t> m_sizeless_returns {0};  // Events which came back reporting 0 bytes before the average was known
+    std::atomic<size_t> m_max_event_bytes {0};
+    std::atomic<size_t> m_byte_budget_rejections {0};
+
+    /// Charges count events against the byte budget, all or nothing. Always admits events when nothing is in
+    /// flight, so that a single event larger than the budget can't stall the topology.
+    inline bool try_charge(size_t count, size_t& charge_per_event) {
+        charge_per_event = 0;
+        if (m_max_bytes_in_flight == 0) return true;
+        charge_per_event = m_avg_known.load(std::memory_order_relaxed) ? m_avg_event_bytes.load(std::memory_order_relaxed)
+                                                                       : m_max_bytes_in_flight;
+        auto charge = static_cast<int64_t>(count * charge_per_event);
+        auto in_flight = m_bytes_in_flight.fetch_add(charge, std::memory_order_relaxed);
+        if (in_flight > 0 && in_flight + charge > static_cast<int64_t>(m_max_bytes_in_flight)) {
+            m_bytes_in_flight.fetch_sub(charge, std::memory_order_relaxed);
+            m_byte_budget_rejections.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    inline void refund(size_t charge) {
+        m_bytes_in_flight.fetch_sub(static_cast<int64_t>(charge), std::memory_order_relaxed);
+    }
+
+    /// Credits the event's charge and folds its actual size into the running average
+    inline void settle(JEvent& event) {
+        refund(event.mPoolBytesCharged);
+        event.mPoolBytesCharged = 0;
+        size_t bytes = event.GetEstimatedBytes();
+        if (bytes == 0) {
+            // e.g. the source gave the event back without emitting it. But once a whole pool's worth came back like
+            // this, the factories evidently don't estimate their sizes, and admitting one event at a time is pointless.
+            if (!m_avg_known.load(std::memory_order_relaxed) &&
+                m_sizeless_returns.fetch_add(1, std::memory_order_relaxed) + 1 >= m_pool_size) {
+                m_avg_known.store(true, std::memory_order_relaxed);
+            }
+            return;
+        }
+        size_t avg = m_avg_event_bytes.load(std::memory_order_relaxed);
+        size_t new_avg = (avg == 0) ? bytes : avg - avg/8 + bytes/8;
+        // Losing an update to a concurrent put() doesn't matter for an estimate
+        m_avg_event_bytes.compare_exchange_strong(avg, new_avg, std::memory_order_relaxed);
+        m_avg_known.store(true, std::memory_order_relaxed);
+        size_t max = m_max_event_bytes.load(std::memory_order_relaxed);
+        while (bytes > max && !m_max_event_bytes.compare_exchange_weak(max, bytes, std::memory_order_relaxed));
+    }
+
+    inline Event create_event(size_t location) {
+        auto event = std::make_shared<JEvent>();
+        m_component_manager->configure_event(*event);
+        event->mPoolLocation = location;
+        return event;
+    }
+
+    inline void populate(size_t location) {
+        LocalPool& pool = m_pools[location];
+        size_t capacity = pool.stats.capacity;
+        pool.slots.reserve(capacity);
+        pool.next = std::unique_ptr<std::atomic<uint32_t>[]>(new std::atomic<uint32_t>[capacity]);
+        for (size_t slot=0; slot<capacity; ++slot) {
+            pool.slots.push_back(create_event(location));
+            pool.slots.back()->mPoolSlot = slot;
+        }
+        for (size_t slot=capacity; slot-- > 0;) {
+            pool.push(slot);
+        }
+    }
+
+    /// Populates one location from a thread pinned to that location's cpu. Locations are populated one at a time,
+    /// so that factory generators don't have to be any more thread-safe than they already are.
+    inline void populate_pinned(size_t location, size_t cpu_id) {
+        std::mutex start_mutex;
+        std::unique_lock<std::mutex> start_lock(start_mutex);
+        std::exception_ptr error;
+
+        std::thread thread([&] {
+            // Don't allocate anything until we've been moved to the right cpu
+            std::lock_guard<std::mutex> started(start_mutex);
+            try {
+                populate(location);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+        });
+        m_pools[location].stats.is_pinned = JCpuInfo::PinThreadToCpu(&thread, cpu_id);
+        start_lock.unlock();
+        thread.join();
+        if (error) std::rethrow_exception(error);
+    }
+
+    /// Pops a free event, trying the given location first and then the others in turn. Returns nullptr if none has any.
+    inline Event pop_any(size_t location) {
+        for (size_t i=0; i<m_location_count; ++i) {
+            LocalPool& pool = m_pools[(location + i) % m_location_count];
+            size_t slot = pool.pop();
+            if (slot != NO_SLOT) return pool.slots[slot];
+        }
+        return nullptr;
+    }
+
+    /// Resets the event and pushes its slot back onto its home location's free stack. Events which the pool
+    /// created beyond pool_size (when jana:limit_total_events_in_flight=false) have no slot and are simply dropped.
+    inline void recycle(Event& event, size_t location) {
+        LocalPool& pool = m_pools[event->mPoolLocation];
+        if (event->mPoolLocation != location) {
+            pool.foreign_returns.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (m_max_bytes_in_flight != 0) {
+            settle(*event);
+        }
+        size_t slot = event->mPoolSlot;
+        if (slot != NO_SLOT) {
+            event->mFactorySet->Release();
+            event->mAssociations.Clear();
+            event->mInspector.Reset();
+            event->GetJCallGraphRecorder()->Reset();
+        }
+        event = nullptr;  // The pool's own reference in pool.slots keeps it alive
+        if (slot != NO_SLOT) {
+            pool.push(slot);
+        }
+    }
+
 public:
     inline JEventPool(std::shared_ptr<JComponentManager> component_manager,
                       size_t pool_size,
                       size_t location_count,
-                      bool limit_total_events_in_flight)
+                      bool limit_total_events_in_flight,
+                      const JProcessorMapping* mapping = nullptr)
         : m_component_manager(component_manager)
         , m_pool_size(pool_size)
         , m_location_count(location_count)
@@ -38,97 +232,120 @@ public:
         assert(m_pool_size > 0 || !m_limit_total_events_in_flight);
         m_pools = std::unique_ptr<LocalPool[]>(new LocalPool[location_count]());
 
+        bool pin = (mapping != nullptr && m_location_count > 1);
         for (size_t j=0; j<m_location_count; ++j) {
-            for (size_t i=0; i<m_pool_size; ++i) {
-                auto event = std::make_shared<JEvent>();
-                m_component_manager->configure_event(*event);
-                put(event, j);
+            LocationStats& stats = m_pools[j].stats;
+            // The first pool_size % location_count locations get one event more than the rest
+            stats.capacity = m_pool_size / m_location_count + (j < m_pool_size % m_location_count ? 1 : 0);
+            if (pin) {
+                stats.cpu_id = mapping->get_loc_cpu_id(j);
+                stats.numa_domain_id = mapping->get_loc_numa_domain_id(j);
+                populate_pinned(j, stats.cpu_id);
+            }
+            else {
+                populate(j);
             }
         }
     }
 
-    inline std::shared_ptr<JEvent> get(size_t location=0) {
+    inline Event get(size_t location=0) {
 
-        LocalPool& pool = m_pools[location % m_location_count];
-        std::lock_guard<std::mutex> lock(pool.mutex);
-
-        if (pool.events.empty()) {
+        location = location % m_location_count;
+        size_t charge;
+        if (!try_charge(1, charge)) {
+            return nullptr;
+        }
+        Event event = pop_any(location);
+        if (event == nullptr) {
             if (m_limit_total_events_in_flight) {
+                refund(charge);
                 return nullptr;
             }
-            else {
-                auto event = std::make_shared<JEvent>();
-                m_component_manager->configure_event(*event);
-                return event;
-            }
-        }
-        else {
-            auto event = std::move(pool.events.back());
-            pool.events.pop_back();
-            event->mFactorySet->Release();
-            event->mInspector.Reset();
-            event->GetJCallGraphRecorder()->Reset();
-            return event;
+            event = create_event(location);
         }
+        event->mPoolBytesCharged = charge;
+        return event;
     }
 
 
-    inline void put(std::shared_ptr<JEvent>& event, size_t location=0) {
-
-        LocalPool& pool = m_pools[location % m_location_count];
-        std::lock_guard<std::mutex> lock(pool.mutex);
-
-        if (pool.events.size() < m_pool_size) {
-            pool.events.push_back(std::move(event));
-        }
+    /// put() returns the event to the pool of the location which created it. The location of the caller
+    /// is only used to count how often events migrate.
+    inline void put(Event& event, size_t location=0) {
+        recycle(event, location % m_location_count);
     }
 
+    /// size() is the total number of events which the pool keeps, over all locations
     inline size_t size() { return m_pool_size; }
 
+    inline size_t get_location_count() const { return m_location_count; }
 
-    inline bool get_many(std::vector<std::shared_ptr<JEvent>>& dest, size_t count, size_t location=0) {
-        std::vector<std::shared_ptr<JEvent>> results;
+    /// set_max_bytes_in_flight() sets the byte budget described above. 0 turns it off. Call this before any
+    /// events have been handed out.
+    inline void set_max_bytes_in_flight(size_t max_bytes) { m_max_bytes_in_flight = max_bytes; }
+    inline size_t get_max_bytes_in_flight() const { return m_max_bytes_in_flight; }
 
+    /// get_bytes_in_flight() is what the events currently in flight have been charged, not their actual size
+    inline size_t get_bytes_in_flight() const {
+        auto bytes = m_bytes_in_flight.load(std::memory_order_relaxed);
+        return (bytes > 0) ? bytes : 0;
+    }
+    inline size_t get_avg_event_bytes() const { return m_avg_event_bytes.load(std::memory_order_relaxed); }
+    inline size_t get_max_event_bytes() const { return m_max_event_bytes.load(std::memory_order_relaxed); }
+    inline size_t get_byte_budget_rejections() const { return m_byte_budget_rejections.load(std::memory_order_relaxed); }
+
+    /// get_stats() is only a snapshot, because other threads may be getting and putting concurrently.
+    inline LocationStats get_stats(size_t location) {
         LocalPool& pool = m_pools[location % m_location_count];
-        std::lock_guard<std::mutex> lock(pool.mutex);
-        // TODO: We probably want to steal from other event pools if jana:enable_stealing=true
+        LocationStats stats = pool.stats;
+        stats.available = pool.available.load(std::memory_order_relaxed);
+        stats.foreign_returns = pool.foreign_returns.load(std::memory_order_relaxed);
+        return stats;
+    }
+
 
-        if (m_limit_total_events_in_flight && pool.events.size() < count) {
+    inline bool get_many(std::vector<Event>& dest, size_t count, size_t location=0) {
+
+        location = location % m_location_count;
+
+        size_t charge;
+        if (!try_charge(count, charge)) {
             return false;
         }
-        else {
-            while (count > 0 && !pool.events.empty()) {
-                auto event = std::move(pool.events.back());
-                pool.events.pop_back();
-                event->mFactorySet->Release();
-                event->mInspector.Reset();
-                event->GetJCallGraphRecorder()->Reset();
-                dest.push_back(event);
-                count -= 1;
+        size_t first = dest.size();
+        while (dest.size() - first < count) {
+            auto event = pop_any(location);
+            if (event == nullptr) break;
+            dest.push_back(std::move(event));
+        }
+
+        if (dest.size() - first < count) {
+            if (m_limit_total_events_in_flight) {
+                // All or nothing. The events we did get go straight back; they haven't been used, so need no reset.
+                for (size_t i=first; i<dest.size(); ++i) {
+                    m_pools[dest[i]->mPoolLocation].push(dest[i]->mPoolSlot);
+                }
+                dest.resize(first);
+                refund(count * charge);
+                return false;
             }
-            while (count > 0) {
-                auto event = std::make_shared<JEvent>();
-                m_component_manager->configure_event(*event);
-                dest.push_back(event);
-                count -= 1;
+            while (dest.size() - first < count) {
+                dest.push_back(create_event(location));
             }
-            return true;
         }
+        for (size_t i=first; i<dest.size(); ++i) {
+            dest[i]->mPoolBytesCharged = charge;
+        }
+        return true;
     }
 
-    inline void put_many(std::vector<std::shared_ptr<JEvent>>& finished_events, size_t location=0) {
+    inline void put_many(std::vector<Event>& finished_events, size_t location=0) {
 
-        LocalPool& pool = m_pools[location % m_location_count];
-        std::lock_guard<std::mutex> lock(pool.mutex);
         // TODO: We may want to distribute to other event pools if jana:enable_stealing=true
-
-        size_t count = finished_events.size();
-        while (count-- > 0 && pool.events.size() < m_pool_size) {
-            pool.events.push_back(std::move(finished_events.back()));
-            finished_events.pop_back();
+        location = location % m_location_count;
+        for (auto& event : finished_events) {
+            recycle(event, location);
         }
-        // Items that are added back to the pool get removed from finished_events.
-        // Remaining items go out of scope on their own
+        finished_events.clear();
     }
 };
 
@@ -60,7 +60,7 @@ std::tuple<JFactory*, size_t, size_t> JInspector::LocateObject(const JEvent& eve
     for (auto fac : event.GetAllFactories()) {
         if (fac->GetObjectName() == objName) {
             size_t obj_idx = 0;
-            for (auto o : fac->GetAs<JObject>()) { // Won't trigger factory creation if it hasn't already happened
+            for (auto o : fac->GetAsView<JObject>()) { // Won't trigger factory creation if it hasn't already happened
                 if (obj == o) {
                     return std::make_tuple(fac, fac_idx, obj_idx);
                 }
@@ -111,7 +111,7 @@ void JInspector::PrintObject(std::string fac_key, int object_idx) {
         return;
     }
     JFactory* fac = const_cast<JFactory*>(result->second.second);
-    auto objs = fac->GetAs<JObject>();
+    auto objs = fac->GetAsView<JObject>();
     if ((size_t) object_idx >= objs.size()) {
         m_out << "(Error: Object index out of range)" << std::endl;
         return;
@@ -456,7 +456,7 @@ void JInspector::PrintObjectParents(std::string factory_key, int object_idx) {
         return;
     }
     auto fac = const_cast<JFactory*>(result->second.second);
-    auto objs = fac->GetAs<JObject>();
+    auto objs = fac->GetAsView<JObject>();
     if ((size_t) object_idx >= objs.size()) {
         m_out << "(Error: Object index out of range)" << std::endl;
         return;
@@ -548,7 +548,7 @@ void JInspector::PrintObjectAncestors(std::string factory_idx, int object_idx) {
         return;
     }
     auto fac = const_cast<JFactory*>(result->second.second);
-    auto objs = fac->GetAs<JObject>();
+    auto objs = fac->GetAsView<JObject>();
     if ((size_t) object_idx >= objs.size()) {
         m_out << "(Error: Object index out of range)" << std::endl;
         return;
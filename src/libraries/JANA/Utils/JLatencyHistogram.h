@@ -0,0 +1,137 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JLATENCYHISTOGRAM_H
+#define JANA2_JLATENCYHISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+/// JLatencyHistogram counts durations in logarithmic buckets, in the spirit of HdrHistogram: each power of two
+/// (in nanoseconds) is split into SUB_BUCKETS linear buckets, so every recorded value is known to within 1/SUB_BUCKETS
+/// of itself, while a few hundred counters cover everything from 1 ns to several minutes. This makes tail latencies
+/// (p99, p99.9) cheap to track, which averages can't show.
+///
+/// Recording is a single relaxed increment. So that threads recording the same stage don't fight over cache lines,
+/// the counters are spread over SHARD_COUNT shards, one per thread (modulo SHARD_COUNT), which get_snapshot() adds up.
+/// Histograms and snapshots merge by adding counts, e.g. to combine stages or processes.
+class JLatencyHistogram {
+public:
+    using duration_t = std::chrono::steady_clock::duration;
+    static constexpr size_t SUB_BUCKET_BITS = 3;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t MAX_EXPONENT = 40;  // Values of 2^41 ns (about 37 minutes) and up share the last bucket
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+    static constexpr size_t SHARD_COUNT = 8;
+
+    class Snapshot {
+        friend class JLatencyHistogram;
+        std::array<uint64_t, BUCKET_COUNT> m_counts {};
+        uint64_t m_count = 0;
+        uint64_t m_max_ns = 0;
+
+    public:
+        void merge(const Snapshot& other) {
+            for (size_t i=0; i<BUCKET_COUNT; ++i) m_counts[i] += other.m_counts[i];
+            m_count += other.m_count;
+            if (other.m_max_ns > m_max_ns) m_max_ns = other.m_max_ns;
+        }
+
+        uint64_t get_count() const { return m_count; }
+
+        duration_t get_max() const { return std::chrono::nanoseconds(m_max_ns); }
+
+        /// get_percentile(0.99) is the smallest latency which at least 99% of the recorded latencies don't exceed,
+        /// rounded up to the end of its bucket (but never past the largest latency actually recorded)
+        duration_t get_percentile(double fraction) const {
+            if (m_count == 0) return duration_t::zero();
+            auto rank = static_cast<uint64_t>(fraction * m_count + 0.5);
+            if (rank < 1) rank = 1;
+            if (rank > m_count) rank = m_count;
+            uint64_t seen = 0;
+            for (size_t i=0; i<BUCKET_COUNT; ++i) {
+                seen += m_counts[i];
+                if (seen >= rank) {
+                    auto ns = std::min(get_bucket_max_ns(i), m_max_ns);
+                    return std::chrono::nanoseconds(ns);
+                }
+            }
+            return get_max();
+        }
+    };
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, BUCKET_COUNT> counts {};
+        std::atomic<uint64_t> max_ns {0};
+    };
+    std::unique_ptr<Shard[]> m_shards = std::make_unique<Shard[]>(SHARD_COUNT);
+
+    static size_t get_shard_index() {
+        static std::atomic_size_t next_index {0};
+        thread_local size_t index = next_index.fetch_add(1, std::memory_order_relaxed) % SHARD_COUNT;
+        return index;
+    }
+
+public:
+    static size_t get_bucket_index(uint64_t ns) {
+        if (ns < SUB_BUCKETS) return ns;  // Small values are exact
+        size_t exponent = 63 - __builtin_clzll(ns);
+        if (exponent > MAX_EXPONENT) return BUCKET_COUNT - 1;
+        size_t sub_bucket = (ns >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+        return SUB_BUCKETS + (exponent - SUB_BUCKET_BITS) * SUB_BUCKETS + sub_bucket;
+    }
+
+    /// get_bucket_max_ns() is the largest value which lands in the given bucket
+    static uint64_t get_bucket_max_ns(size_t index) {
+        if (index < SUB_BUCKETS) return index;
+        if (index == BUCKET_COUNT - 1) return UINT64_MAX;
+        size_t exponent = (index - SUB_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS;
+        size_t sub_bucket = (index - SUB_BUCKETS) % SUB_BUCKETS;
+        uint64_t width = uint64_t(1) << (exponent - SUB_BUCKET_BITS);
+        return (SUB_BUCKETS + sub_bucket) * width + width - 1;
+    }
+
+    void record(duration_t latency) {
+        auto count = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+        uint64_t ns = (count > 0) ? static_cast<uint64_t>(count) : 0;
+        Shard& shard = m_shards[get_shard_index()];
+        shard.counts[get_bucket_index(ns)].fetch_add(1, std::memory_order_relaxed);
+        uint64_t max_ns = shard.max_ns.load(std::memory_order_relaxed);
+        while (ns > max_ns && !shard.max_ns.compare_exchange_weak(max_ns, ns, std::memory_order_relaxed));
+    }
+
+    /// merge() adds everything other has recorded so far to this histogram
+    void merge(const JLatencyHistogram& other) {
+        auto snapshot = other.get_snapshot();
+        Shard& shard = m_shards[get_shard_index()];
+        for (size_t i=0; i<BUCKET_COUNT; ++i) {
+            if (snapshot.m_counts[i] != 0) shard.counts[i].fetch_add(snapshot.m_counts[i], std::memory_order_relaxed);
+        }
+        uint64_t max_ns = shard.max_ns.load(std::memory_order_relaxed);
+        while (snapshot.m_max_ns > max_ns &&
+               !shard.max_ns.compare_exchange_weak(max_ns, snapshot.m_max_ns, std::memory_order_relaxed));
+    }
+
+    /// get_snapshot() adds up the shards. It doesn't stop anybody from recording meanwhile.
+    Snapshot get_snapshot() const {
+        Snapshot snapshot;
+        for (size_t s=0; s<SHARD_COUNT; ++s) {
+            const Shard& shard = m_shards[s];
+            for (size_t i=0; i<BUCKET_COUNT; ++i) {
+                auto count = shard.counts[i].load(std::memory_order_relaxed);
+                snapshot.m_counts[i] += count;
+                snapshot.m_count += count;
+            }
+            auto max_ns = shard.max_ns.load(std::memory_order_relaxed);
+            if (max_ns > snapshot.m_max_ns) snapshot.m_max_ns = max_ns;
+        }
+        return snapshot;
+    }
+};
+
+#endif //JANA2_JLATENCYHISTOGRAM_H
@@ -0,0 +1,32 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JPOOLSTATISTICS_H
+#define JANA2_JPOOLSTATISTICS_H
+
+#include <atomic>
+#include <cstdint>
+
+/// JPoolStatistics counts how often an object pool could hand out a recycled object (a hit) and how often it had to
+/// allocate a new one instead (a miss). Counters are relaxed atomics, so that every event's instance of the same
+/// factory can share one JPoolStatistics.
+class JPoolStatistics {
+    std::atomic<uint64_t> m_hits {0};
+    std::atomic<uint64_t> m_misses {0};
+
+public:
+    void record_hit() { m_hits.fetch_add(1, std::memory_order_relaxed); }
+    void record_miss() { m_misses.fetch_add(1, std::memory_order_relaxed); }
+
+    uint64_t get_hits() const { return m_hits.load(std::memory_order_relaxed); }
+    uint64_t get_misses() const { return m_misses.load(std::memory_order_relaxed); }
+
+    /// Fraction of requests which got a recycled object, or 0 if there were none at all
+    double get_hit_rate() const {
+        auto hits = get_hits();
+        auto total = hits + get_misses();
+        return (total == 0) ? 0.0 : double(hits) / double(total);
+    }
+};
+
+#endif //JANA2_JPOOLSTATISTICS_H
@@ -141,6 +141,47 @@ void JProcessorMapping::initialize(AffinityStrategy affinity, LocalityStrategy l
     m_initialized = true;
 }
 
+size_t JProcessorMapping::get_loc_distance(size_t from_loc_id, size_t to_loc_id) const {
+    if (from_loc_id == to_loc_id) return 0;
+
+    // Each location is represented by the first cpu we find which belongs to it
+    const Row* from = nullptr;
+    const Row* to = nullptr;
+    for (const Row& row : m_mapping) {
+        if (from == nullptr && row.location_id == from_loc_id) from = &row;
+        if (to == nullptr && row.location_id == to_loc_id) to = &row;
+    }
+    if (from == nullptr || to == nullptr) return 3; // Without topology info, assume the worst
+    if (from->numa_domain_id == to->numa_domain_id) return 1;
+    if (from->socket_id == to->socket_id) return 2;
+    return 3;
+}
+
+size_t JProcessorMapping::get_loc_cpu_id(size_t loc_id) const {
+    for (const Row& row : m_mapping) {
+        if (row.location_id == loc_id) return row.cpu_id;
+    }
+    return 0;
+}
+
+size_t JProcessorMapping::get_loc_numa_domain_id(size_t loc_id) const {
+    for (const Row& row : m_mapping) {
+        if (row.location_id == loc_id) return row.numa_domain_id;
+    }
+    return 0;
+}
+
+std::vector<size_t> JProcessorMapping::get_steal_order(size_t loc_id) const {
+    std::vector<size_t> victims;
+    for (size_t offset=1; offset<m_loc_count; ++offset) {
+        victims.push_back((loc_id + offset) % m_loc_count);
+    }
+    std::stable_sort(victims.begin(), victims.end(), [&](size_t lhs, size_t rhs) {
+        return get_loc_distance(loc_id, lhs) < get_loc_distance(loc_id, rhs);
+    });
+    return victims;
+}
+
 std::ostream& operator<<(std::ostream& os, const JProcessorMapping::AffinityStrategy& s) {
     switch (s) {
         case JProcessorMapping::AffinityStrategy::ComputeBound: os << "compute-bound (favor fewer hyperthreads)"; break;
@@ -38,6 +38,19 @@ public:
         return m_locality_strategy;
     }
 
+    /// get_loc_distance() estimates how expensive it is for a worker in one location to touch memory
+    /// belonging to another: 0=same location, 1=same NUMA domain, 2=same socket, 3=different socket.
+    size_t get_loc_distance(size_t from_loc_id, size_t to_loc_id) const;
+
+    /// get_loc_cpu_id() returns the first cpu belonging to the given location, e.g. for pinning a thread which
+    /// should allocate that location's memory. get_loc_numa_domain_id() returns that cpu's NUMA domain.
+    size_t get_loc_cpu_id(size_t loc_id) const;
+    size_t get_loc_numa_domain_id(size_t loc_id) const;
+
+    /// get_steal_order() lists every other location, nearest first, for work stealing.
+    /// Ties are broken round-robin starting after loc_id, so that equidistant thieves don't all pick the same victim.
+    std::vector<size_t> get_steal_order(size_t loc_id) const;
+
     friend std::ostream& operator<<(std::ostream& os, const JProcessorMapping& m);
     friend std::ostream& operator<<(std::ostream& os, const AffinityStrategy& s);
     friend std::ostream& operator<<(std::ostream& os, const LocalityStrategy& s);
@@ -40,11 +40,6 @@
  *
  **********************************************************************************************************************/
 
-// Apple compiler does not currently support alignas. Make this an empty definition if it is not already defined.
-#ifndef alignas
-#define alignas(A)
-#endif
-
 template <typename DType> class JResourcePool
 {
     //TYPE TRAIT REQUIREMENTS
@@ -90,6 +85,13 @@ template <typename DType> class JResourcePool
         void Recycle(DType* sResource);
         void Recycle(std::vector<DType*>& sResources); //move-clears the input vector
 
+        //FOR CALLERS WHICH KEEP THEIR OWN CACHE IN FRONT OF THE SHARED POOL (e.g. JFactoryPooledT)
+        //Get_PooledResources() never allocates: it returns how many it could take from the shared pool
+        //Recycle_Released() skips Release(), because the caller already called it when the objects entered its cache
+        template <typename ContainerType>
+        std::size_t Get_PooledResources(std::size_t aNumResources, std::back_insert_iterator<ContainerType> aInsertIterator){return Get_Resources_StaticPool(aNumResources, aInsertIterator);}
+        void Recycle_Released(std::vector<DType*>& sResources){Recycle_Resources_StaticPool(sResources);} //move-clears the input vector
+
         std::size_t Get_PoolSize(void) const;
         std::size_t Get_NumObjectsAllThreads(void) const{return dObjectCounter;}
 
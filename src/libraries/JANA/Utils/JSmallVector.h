@@ -0,0 +1,134 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JSMALLVECTOR_H
+#define JANA2_JSMALLVECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/// JSmallVector is a vector which keeps its first N elements inside itself and only goes to the heap once it grows
+/// beyond that. Most JObjects have only a handful of associations, so this saves an allocation per association
+/// (which is what the std::set it replaced cost) as well as the pointer chasing when iterating. It only holds
+/// trivially copyable types such as pointers, which lets it move elements around with memcpy/memmove.
+template <typename T, size_t N>
+class JSmallVector {
+    static_assert(std::is_trivially_copyable<T>::value, "JSmallVector only holds trivially copyable types, e.g. pointers");
+    static_assert(N > 0, "JSmallVector needs room for at least one element inline");
+
+    union {
+        T m_inline[N];
+        T* m_heap;
+    };
+    uint32_t m_size = 0;
+    uint32_t m_capacity = N;  // Equal to N exactly when the elements are inline
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    JSmallVector() {}
+    JSmallVector(const JSmallVector& other) { assign(other.begin(), other.end()); }
+    JSmallVector(JSmallVector&& other) noexcept { take(other); }
+    ~JSmallVector() { release(); }
+
+    JSmallVector& operator=(const JSmallVector& other) {
+        if (this != &other) assign(other.begin(), other.end());
+        return *this;
+    }
+
+    JSmallVector& operator=(JSmallVector&& other) noexcept {
+        if (this != &other) {
+            release();
+            take(other);
+        }
+        return *this;
+    }
+
+    bool is_inline() const { return m_capacity == N; }
+    size_t size() const { return m_size; }
+    size_t capacity() const { return m_capacity; }
+    bool empty() const { return m_size == 0; }
+
+    T* data() { return is_inline() ? m_inline : m_heap; }
+    const T* data() const { return is_inline() ? m_inline : m_heap; }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + m_size; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + m_size; }
+
+    T& operator[](size_t i) { return data()[i]; }
+    const T& operator[](size_t i) const { return data()[i]; }
+
+    void reserve(size_t n) {
+        if (n > m_capacity) grow(n);
+    }
+
+    void push_back(const T& value) {
+        if (m_size == m_capacity) grow(2 * m_capacity);
+        data()[m_size++] = value;
+    }
+
+    iterator insert(const_iterator pos, const T& value) {
+        size_t i = pos - begin();
+        if (m_size == m_capacity) grow(2 * m_capacity);  // Invalidates pos, hence the index
+        T* d = data();
+        std::memmove(d + i + 1, d + i, (m_size - i) * sizeof(T));
+        d[i] = value;
+        m_size++;
+        return d + i;
+    }
+
+    iterator erase(const_iterator pos) {
+        size_t i = pos - begin();
+        T* d = data();
+        std::memmove(d + i, d + i + 1, (m_size - i - 1) * sizeof(T));
+        m_size--;
+        return d + i;
+    }
+
+    /// clear() keeps whatever capacity it has, so that a reused object doesn't allocate again
+    void clear() { m_size = 0; }
+
+    void assign(const_iterator first, const_iterator last) {
+        size_t n = last - first;
+        m_size = 0;
+        reserve(n);
+        if (n != 0) std::memcpy(data(), first, n * sizeof(T));
+        m_size = n;
+    }
+
+private:
+    void grow(size_t new_capacity) {
+        T* heap = new T[new_capacity];
+        if (m_size != 0) std::memcpy(heap, data(), m_size * sizeof(T));
+        release();
+        m_heap = heap;
+        m_capacity = new_capacity;
+    }
+
+    void release() {
+        if (!is_inline()) delete[] m_heap;
+        m_capacity = N;
+    }
+
+    /// take() moves other's elements into this, which must not own a heap buffer, and leaves other empty
+    void take(JSmallVector& other) {
+        if (other.is_inline()) {
+            if (other.m_size != 0) std::memcpy(m_inline, other.m_inline, other.m_size * sizeof(T));
+        }
+        else {
+            m_heap = other.m_heap;
+            m_capacity = other.m_capacity;
+            other.m_capacity = N;
+        }
+        m_size = other.m_size;
+        other.m_size = 0;
+    }
+};
+
+#endif //JANA2_JSMALLVECTOR_H
@@ -0,0 +1,50 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JSPAN_H
+#define JANA2_JSPAN_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/// JSpan is a non-owning view over contiguous elements, i.e. a pointer plus a size, in the spirit of C++20's
+/// std::span. It never allocates or copies, so it is cheap to pass and return by value. It stays valid only as long
+/// as the memory it points to, which for factory output means until the event is cleared.
+template <typename T>
+class JSpan {
+    T* m_data = nullptr;
+    size_t m_size = 0;
+
+public:
+    using element_type = T;
+    using value_type = typename std::remove_cv<T>::type;
+    using iterator = T*;
+
+    JSpan() = default;
+    JSpan(T* data, size_t size) : m_data(data), m_size(size) {}
+
+    template <typename U, typename = typename std::enable_if<std::is_same<const U, T>::value || std::is_same<U, T>::value>::type>
+    JSpan(const std::vector<U>& vec) : m_data(vec.data()), m_size(vec.size()) {}
+
+    template <typename U, typename = typename std::enable_if<std::is_same<const U, T>::value || std::is_same<U, T>::value>::type>
+    JSpan(std::vector<U>& vec) : m_data(vec.data()), m_size(vec.size()) {}
+
+    T* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    T* begin() const { return m_data; }
+    T* end() const { return m_data + m_size; }
+
+    T& operator[](size_t i) const { return m_data[i]; }
+    T& at(size_t i) const {
+        if (i >= m_size) throw std::out_of_range("JSpan::at");
+        return m_data[i];
+    }
+    T& front() const { return m_data[0]; }
+    T& back() const { return m_data[m_size - 1]; }
+};
+
+#endif //JANA2_JSPAN_H
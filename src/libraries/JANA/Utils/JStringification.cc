@@ -40,7 +40,7 @@ void JStringification::GetObjectSummaries(std::map<std::string, JObjectSummary>
     if(jevent.get() == nullptr ) return;
     auto fac = jevent->GetFactory(object_name, factory_tag);
     if( fac ){
-        for( auto jobj : fac->GetAs<JObject>()){
+        for( auto jobj : fac->GetAsView<JObject>()){
             JObjectSummary summary;
             jobj->Summarize(summary);
             std::stringstream ss;
@@ -51,7 +51,7 @@ void JStringification::GetObjectSummaries(std::map<std::string, JObjectSummary>
         // For objects inheriting from TObject, we try and convert members automatically
         // into JObjectSummary form. This relies on dictionaries being compiled in.
         // (see ROOT_GENERATE_DICTIONARY for cmake files).
-        for( auto tobj : fac->GetAs<TObject>()){
+        for( auto tobj : fac->GetAsView<TObject>()){
             JObjectSummary summary;
             auto tclass = TClass::GetClass(tobj->ClassName());
             if(tclass){
@@ -27,6 +27,15 @@ std::string demangle(void) {
 }
 
 
+/// demangled_name<T>() is demangle<T>() for hot paths: the name is demangled the first time, and every later call
+/// returns a reference to the same string without allocating.
+template<typename T>
+const std::string& demangled_name() {
+    static const std::string name = demangle<T>();
+    return name;
+}
+
+
 /// Macro for conveniently turning a variable name into a string. This is used by JObject::Summarize
 /// in order to play nicely with refactoring tools. Because the symbol is picked up by the
 /// preprocessor and not the compiler, no demangling is necessary.
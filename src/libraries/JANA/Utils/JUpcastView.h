@@ -0,0 +1,65 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#ifndef JANA2_JUPCASTVIEW_H
+#define JANA2_JUPCASTVIEW_H
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+/// JUpcastAccessor reads the index'th object out of a type-erased array of object pointers and upcasts it.
+/// The result is an S* converted to void*, so the caller converts it straight back to the S* it was.
+using JUpcastAccessor = void* (*)(const void* objects, size_t index);
+
+/// JUpcastAt is the JUpcastAccessor for (T, S): objects must be a T* const* which was converted to void*, so
+/// both conversions are round trips to the original type. Because it upcasts a real T, virtual bases work too.
+template <typename T, typename S>
+void* JUpcastAt(const void* objects, size_t index) {
+    static_assert(std::is_base_of<S, T>::value || std::is_same<S, T>::value, "S must be T or a base class of T");
+    T* t = static_cast<T* const*>(objects)[index];
+    return (t == nullptr) ? nullptr : static_cast<void*>(static_cast<S*>(t));
+}
+
+
+/// JUpcastView presents a factory's T* objects as S*, where S is T or one of its bases, without building a vector:
+/// it walks the factory's own pointers and upcasts each one through the factory's JUpcastAccessor as it goes. It is
+/// what JFactory::GetAsView<S>() returns. Like JSpan, it stays valid until the factory is cleared.
+template <typename S>
+class JUpcastView {
+    const void* m_objects = nullptr;
+    size_t m_size = 0;
+    JUpcastAccessor m_upcast_at = nullptr;
+
+public:
+    class iterator {
+        const JUpcastView* m_view;
+        size_t m_index;
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = S*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = S**;
+        using reference = S*;
+
+        iterator(const JUpcastView* view, size_t index) : m_view(view), m_index(index) {}
+        S* operator*() const { return (*m_view)[m_index]; }
+        iterator& operator++() { ++m_index; return *this; }
+        iterator operator++(int) { auto old = *this; ++m_index; return old; }
+        bool operator==(const iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const iterator& other) const { return m_index != other.m_index; }
+    };
+
+    JUpcastView() = default;
+    JUpcastView(const void* objects, size_t size, JUpcastAccessor upcast_at)
+        : m_objects(objects), m_size(size), m_upcast_at(upcast_at) {}
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    S* operator[](size_t i) const { return static_cast<S*>(m_upcast_at(m_objects, i)); }
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, m_size); }
+};
+
+#endif //JANA2_JUPCASTVIEW_H
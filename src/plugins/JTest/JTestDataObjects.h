@@ -7,6 +7,7 @@
 #define JANA2_JTESTEVENTCONTEXTS_H
 
 #include <JANA/JObject.h>
+#include <JANA/Utils/JResettable.h>
 #include <memory>
 
 struct JTestEntangledEventData : public JObject {
@@ -15,11 +16,15 @@ struct JTestEntangledEventData : public JObject {
     JOBJECT_PUBLIC(JTestEntangledEventData)
 };
 
-struct JTestEventData : public JObject {
+struct JTestEventData : public JObject, public JResettable {
     std::vector<char> buffer;
 
     JOBJECT_PUBLIC(JTestEventData)
 
+    // JTestDisentangler recycles these. Keeping the buffer's capacity is the point.
+    void Release() override { ClearAssociatedObjects(); }
+    void Reset() override { buffer.clear(); }
+
     void Summarize(JObjectSummary& summary) const override {
         summary.add(buffer.size(), "buffer_size", "%d");
     }
@@ -5,7 +5,7 @@
 #ifndef JANA2_JTESTDISENTANGLER_H
 #define JANA2_JTESTDISENTANGLER_H
 
-#include <JANA/JFactoryT.h>
+#include <JANA/JFactoryPooledT.h>
 #include <JANA/JEvent.h>
 #include <JANA/Utils/JPerfUtils.h>
 
@@ -13,7 +13,7 @@
 #include "JTestCalibrationService.h"
 
 
-class JTestDisentangler : public JFactoryT<JTestEventData> {
+class JTestDisentangler : public JFactoryPooledT<JTestEventData> {
 
     size_t m_cputime_ms = 20;
     size_t m_write_bytes = 500000;
@@ -49,9 +49,8 @@ public:
         consume_cpu_ms(m_cputime_ms, m_cputime_spread);
 
         // Write (large) event data
-        auto ed = new JTestEventData;
+        auto ed = InsertRecycled();
         write_memory(ed->buffer, m_write_bytes, m_write_spread);
-        Insert(ed);
     }
 };
 
@@ -45,9 +45,8 @@ public:
         consume_cpu_ms(m_cputime_ms, m_cputime_spread);
 
         // Write (small) track data
-        auto td = new JTestTrackData;
+        auto td = Emplace();
         write_memory(td->buffer, m_write_bytes, m_write_spread);
-        Insert(td);
 
         // Insert some additional objects
         std::vector<JTestTrackAuxilliaryData*> auxObjs;
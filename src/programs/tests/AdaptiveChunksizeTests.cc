@@ -0,0 +1,112 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "catch.hpp"
+
+#include <JANA/JApplication.h>
+#include <JANA/Engine/JArrow.h>
+#include <JANA/Engine/JArrowProcessingController.h>
+
+#include "ScaleTests.h"
+
+namespace adaptivechunksizetests {
+
+struct NullArrow : public JArrow {
+    NullArrow() : JArrow("null", true, NodeType::Stage, 4) {}
+    void execute(JArrowMetrics&, size_t) override {}
+};
+
+/// Pretends that the workers ran the arrow for `count` events, spending `latency_us` on each event and
+/// `queue_latency_us` on each chunk's queue visit.
+void record(JArrow& arrow, size_t count, int latency_us, int queue_latency_us) {
+    size_t chunksize = arrow.get_chunksize();
+    size_t visits = (count + chunksize - 1) / chunksize;
+    JArrowMetrics metrics;
+    metrics.update(JArrowMetrics::Status::KeepGoing, count, visits,
+                   std::chrono::microseconds(latency_us * count),
+                   std::chrono::microseconds(queue_latency_us * visits));
+    arrow.tune_chunksize(metrics);
+}
+
+} // namespace adaptivechunksizetests
+
+
+TEST_CASE("Adaptive chunksize: Tuning follows queue overhead and chunk latency") {
+
+    using namespace adaptivechunksizetests;
+    NullArrow arrow;
+
+    // Nothing happens unless the arrow is adaptive
+    record(arrow, 100, 1, 50);
+    REQUIRE(arrow.get_chunksize() == 4);
+
+    arrow.set_adaptive_chunksize(true, 2, 16);
+    REQUIRE(arrow.is_chunksize_adaptive());
+
+    SECTION("Expensive queue visits grow the chunks up to the maximum") {
+        record(arrow, 100, 10, 20);
+        REQUIRE(arrow.get_chunksize() == 8);
+        record(arrow, 100, 10, 20);
+        REQUIRE(arrow.get_chunksize() == 16);
+        record(arrow, 100, 10, 20);
+        REQUIRE(arrow.get_chunksize() == 16);
+        REQUIRE(arrow.get_chunksize_changes() == 2);
+    }
+
+    SECTION("Negligible queue visits shrink the chunks down to the minimum") {
+        record(arrow, 100, 1000, 1);
+        REQUIRE(arrow.get_chunksize() == 2);
+        record(arrow, 100, 1000, 1);
+        REQUIRE(arrow.get_chunksize() == 2);
+    }
+
+    SECTION("Chunks which take too long shrink, even with expensive queue visits") {
+        arrow.set_chunksize(16);
+        record(arrow, 100, 5000, 10000);
+        REQUIRE(arrow.get_chunksize() == 8);
+    }
+
+    SECTION("Overhead within the band leaves the chunks alone") {
+        record(arrow, 100, 100, 20);
+        REQUIRE(arrow.get_chunksize() == 4);
+        REQUIRE(arrow.get_chunksize_changes() == 0);
+    }
+
+    SECTION("Too few events to judge") {
+        record(arrow, 10, 10, 20);
+        REQUIRE(arrow.get_chunksize() == 4);
+    }
+}
+
+TEST_CASE("Adaptive chunksize: Bounds are validated and clamp the chunksize") {
+
+    using namespace adaptivechunksizetests;
+    NullArrow arrow;
+    REQUIRE_THROWS_AS(arrow.set_adaptive_chunksize(true, 0, 8), JException);
+    REQUIRE_THROWS_AS(arrow.set_adaptive_chunksize(true, 8, 2), JException);
+    arrow.set_adaptive_chunksize(true, 8, 32);
+    REQUIRE(arrow.get_chunksize() == 8);
+}
+
+TEST_CASE("Adaptive chunksize: Topology reports the tuned chunksizes") {
+
+    JApplication app;
+    app.SetTicker(false);
+    app.Add(new scaletest::DummySource("DummySource", &app));
+    app.Add(new scaletest::DummyProcessor);
+    app.SetParameterValue("nthreads", 2);
+    app.SetParameterValue("jana:adaptive_chunksize", true);
+    app.SetParameterValue("jana:adaptive_chunksize_max", 200);
+    app.SetParameterValue("jana:event_queue_threshold", 20);
+    app.Run(false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    auto perf = app.GetService<JArrowProcessingController>()->measure_internal_performance();
+    app.Stop(true);
+    REQUIRE(!perf->arrows.empty());
+    for (auto& arrow : perf->arrows) {
+        REQUIRE(arrow.is_chunksize_adaptive);
+        REQUIRE(arrow.chunksize >= 1);
+        REQUIRE(arrow.chunksize <= 20);  // Never past the queue threshold
+    }
+}
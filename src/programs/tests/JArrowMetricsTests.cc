@@ -0,0 +1,122 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "catch.hpp"
+
+#include <JANA/Engine/JArrow.h>
+
+#include <iomanip>
+#include <thread>
+
+namespace jarrowmetricstests {
+
+struct NullArrow : public JArrow {
+    NullArrow() : JArrow("null", true, NodeType::Stage, 1) {}
+    void execute(JArrowMetrics& result, size_t) override {
+        result.update(JArrowMetrics::Status::KeepGoing, 1, 1, std::chrono::nanoseconds(10), std::chrono::nanoseconds(1));
+    }
+};
+
+} // namespace jarrowmetricstests
+
+
+TEST_CASE("JArrowMetrics: Per-worker metrics add up") {
+
+    using namespace jarrowmetricstests;
+    using std::chrono::microseconds;
+    NullArrow arrow;
+
+    JArrowMetrics first, second;
+    first.update(JArrowMetrics::Status::KeepGoing, 3, 1, microseconds(30), microseconds(1));
+    second.update(JArrowMetrics::Status::ComeBackLater, 2, 2, microseconds(200), microseconds(4));
+    second.update_steal_count(1);
+
+    // Worker 70 lives in a different block than worker 0
+    arrow.get_metrics(0).take(first);
+    arrow.get_metrics(70).take(second);
+    REQUIRE(first.get_total_message_count() == 0);
+    REQUIRE(&arrow.get_metrics(70) != &arrow.get_metrics(0));
+
+    auto sum = arrow.get_metrics();
+    REQUIRE(sum.get_total_message_count() == 5);
+    REQUIRE(sum.get_total_latency() == microseconds(230));
+    REQUIRE(sum.get_total_queue_latency() == microseconds(5));
+    REQUIRE(sum.get_total_steal_count() == 1);
+    // 'Last' comes from whichever worker recorded it most recently
+    REQUIRE(sum.get_last_latency_per_message() == microseconds(100));
+
+    // Workers which never ran this arrow don't count
+    REQUIRE(arrow.get_metrics(5).get_total_message_count() == 0);
+    REQUIRE(arrow.get_metrics().get_total_message_count() == 5);
+}
+
+TEST_CASE("JArrowMetrics: Readers don't disturb the workers") {
+
+    using namespace jarrowmetricstests;
+    NullArrow arrow;
+    const size_t nthreads = 4;
+    const size_t iterations = 20000;
+
+    std::atomic_bool done {false};
+    std::vector<std::thread> workers;
+    for (size_t worker_id=0; worker_id<nthreads; ++worker_id) {
+        workers.emplace_back([&, worker_id] {
+            JArrowMetrics local;
+            for (size_t i=0; i<iterations; ++i) {
+                arrow.execute(local, 0);
+                if (i % 16 == 0) arrow.get_metrics(worker_id).take(local);
+            }
+            arrow.get_metrics(worker_id).take(local);
+        });
+    }
+    size_t previous = 0;
+    bool monotonic = true;
+    std::thread reader([&] {
+        while (!done) {
+            size_t current = arrow.get_metrics().get_total_message_count();
+            if (current < previous) monotonic = false;
+            previous = current;
+        }
+    });
+    for (auto& worker : workers) worker.join();
+    done = true;
+    reader.join();
+
+    REQUIRE(monotonic);
+    REQUIRE(arrow.get_metrics().get_total_message_count() == nthreads * iterations);
+    REQUIRE(arrow.get_metrics().get_total_latency() == std::chrono::nanoseconds(10 * nthreads * iterations));
+}
+
+TEST_CASE("JArrowMetrics: Accounting overhead benchmark", "[.][performance]") {
+
+    // Each thread does what JWorker::loop does around every execute(): read the arrow's knobs, record the result,
+    // and hand it in. The cost per iteration should stay flat as threads are added. Run with `janatests "[performance]"`.
+    using namespace jarrowmetricstests;
+    using clock_t = std::chrono::steady_clock;
+    const size_t iterations = 1000000;
+
+    std::cout << std::setw(10) << "Threads" << std::setw(25) << "ns per iteration" << std::endl;
+    for (size_t nthreads : {1, 2, 4, 8, 16}) {
+        NullArrow arrow;
+        std::vector<std::thread> threads;
+        auto start = clock_t::now();
+        for (size_t worker_id=0; worker_id<nthreads; ++worker_id) {
+            threads.emplace_back([&, worker_id] {
+                JArrowMetrics local;
+                size_t knobs = 0;
+                for (size_t i=0; i<iterations; ++i) {
+                    knobs += arrow.get_chunksize() + arrow.get_backoff_tries();
+                    arrow.execute(local, 0);
+                    arrow.get_metrics(worker_id).take(local);
+                }
+                REQUIRE(knobs == 5 * iterations);
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        auto elapsed = clock_t::now() - start;
+        REQUIRE(arrow.get_metrics().get_total_message_count() == nthreads * iterations);
+
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+        std::cout << std::setw(10) << nthreads << std::setw(25) << std::fixed << std::setprecision(1) << ns << std::endl;
+    }
+}
@@ -0,0 +1,197 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "catch.hpp"
+
+#include <JANA/JApplication.h>
+#include <JANA/Engine/JAutoscaler.h>
+#include <JANA/Engine/JArrowProcessingController.h>
+#include <JANA/Status/JPerfMetrics.h>
+
+#include "ScaleTests.h"
+
+
+namespace jautoscalertests {
+
+/// Builds the cumulative totals that measure_internal_performance() would report after each worker
+/// spent useful_ms doing useful work and idle_ms idling, on top of whatever it reported before.
+struct SampleBuilder {
+    size_t events = 0;
+    std::vector<WorkerSummary> workers;
+
+    JArrowPerfSummary next(size_t nthreads, size_t new_events, double useful_ms, double idle_ms) {
+        // Retired workers keep their totals, just like JWorker does
+        if (workers.size() < nthreads) workers.resize(nthreads);
+        for (size_t i=0; i<nthreads; ++i) {
+            workers[i].worker_id = i;
+            workers[i].total_useful_time_ms += useful_ms;
+            workers[i].total_idle_time_ms += idle_ms;
+        }
+        events += new_events;
+        JArrowPerfSummary sample;
+        sample.monotonic_events_completed = events;
+        sample.workers.assign(workers.begin(), workers.begin() + nthreads);
+        return sample;
+    }
+};
+
+} // namespace jautoscalertests
+
+
+TEST_CASE("JAutoscaler: Throughput target") {
+
+    using namespace jautoscalertests;
+    JAutoscaler::Config config;
+    config.target = JAutoscaler::Target::Throughput;
+    config.min_threads = 1;
+    config.max_threads = 4;
+    config.cooldown_intervals = 2;
+    JAutoscaler autoscaler(config);
+    SampleBuilder samples;
+
+    // First sample only establishes the baseline
+    auto d = autoscaler.decide(samples.next(2, 0, 0, 0), 2, 1.0);
+    REQUIRE(d.new_thread_count == 2);
+
+    // Busy workers, so probe with a third
+    d = autoscaler.decide(samples.next(2, 100, 950, 50), 2, 1.0);
+    REQUIRE(d.throughput_hz == Approx(100));
+    REQUIRE(d.busy_cores == Approx(1.9));
+    REQUIRE(d.idle_frac == Approx(0.05));
+    REQUIRE(d.new_thread_count == 3);
+
+    SECTION("A worker which pays for itself is kept") {
+        d = autoscaler.decide(samples.next(3, 150, 950, 50), 3, 1.0);
+        REQUIRE(d.new_thread_count == 3);
+        // ... and the next interval probes again
+        d = autoscaler.decide(samples.next(3, 150, 950, 50), 3, 1.0);
+        REQUIRE(d.new_thread_count == 4);
+        d = autoscaler.decide(samples.next(4, 200, 950, 50), 4, 1.0);
+        REQUIRE(d.new_thread_count == 4);
+        // Never above max_threads
+        d = autoscaler.decide(samples.next(4, 200, 950, 50), 4, 1.0);
+        REQUIRE(d.new_thread_count == 4);
+    }
+
+    SECTION("A worker which doesn't pay for itself is retired, followed by a cooldown") {
+        d = autoscaler.decide(samples.next(3, 105, 950, 50), 3, 1.0);
+        REQUIRE(d.new_thread_count == 2);
+        d = autoscaler.decide(samples.next(2, 100, 950, 50), 2, 1.0);
+        REQUIRE(d.new_thread_count == 2);
+        d = autoscaler.decide(samples.next(2, 100, 950, 50), 2, 1.0);
+        REQUIRE(d.new_thread_count == 2);
+        d = autoscaler.decide(samples.next(2, 100, 950, 50), 2, 1.0);
+        REQUIRE(d.new_thread_count == 3);
+    }
+
+    SECTION("Mostly idle workers are retired") {
+        d = autoscaler.decide(samples.next(3, 100, 200, 800), 3, 1.0);
+        REQUIRE(d.new_thread_count == 2);
+        d = autoscaler.decide(samples.next(2, 100, 200, 800), 2, 1.0);
+        REQUIRE(d.new_thread_count == 1);
+        // Never below min_threads
+        d = autoscaler.decide(samples.next(1, 100, 200, 800), 1, 1.0);
+        REQUIRE(d.new_thread_count != 0);
+    }
+
+    auto history = autoscaler.get_history();
+    REQUIRE(!history.empty());
+    REQUIRE(history.back().new_thread_count == d.new_thread_count);
+    REQUIRE(!history.back().reason.empty());
+}
+
+TEST_CASE("JAutoscaler: CpuBudget target") {
+
+    using namespace jautoscalertests;
+    JAutoscaler::Config config;
+    config.target = JAutoscaler::Target::CpuBudget;
+    config.min_threads = 1;
+    config.max_threads = 8;
+    config.cpu_budget = 2;
+    JAutoscaler autoscaler(config);
+    SampleBuilder samples;
+
+    autoscaler.decide(samples.next(4, 0, 0, 0), 4, 1.0);
+
+    // 4 workers, all busy: 4 cores against a budget of 2
+    auto d = autoscaler.decide(samples.next(4, 100, 1000, 0), 4, 1.0);
+    REQUIRE(d.busy_cores == Approx(4));
+    REQUIRE(d.new_thread_count == 3);
+
+    // 3 workers, each mostly blocked on something other than the CPU: room for more
+    d = autoscaler.decide(samples.next(3, 100, 200, 0), 3, 1.0);
+    REQUIRE(d.busy_cores == Approx(0.6));
+    REQUIRE(d.new_thread_count == 4);
+
+    // Right at the budget
+    d = autoscaler.decide(samples.next(4, 100, 500, 0), 4, 1.0);
+    REQUIRE(d.new_thread_count == 4);
+}
+
+TEST_CASE("JAutoscaler: Thread count is clamped and targets are parsed") {
+
+    using namespace jautoscalertests;
+    JAutoscaler::Config config;
+    config.target = JAutoscaler::Target::Throughput;
+    config.min_threads = 2;
+    config.max_threads = 4;
+    JAutoscaler autoscaler(config);
+    SampleBuilder samples;
+
+    autoscaler.decide(samples.next(8, 0, 0, 0), 8, 1.0);
+    auto d = autoscaler.decide(samples.next(8, 100, 1000, 0), 8, 1.0);
+    REQUIRE(d.new_thread_count == 4);
+    d = autoscaler.decide(samples.next(1, 100, 1000, 0), 1, 1.0);
+    REQUIRE(d.new_thread_count == 2);
+
+    REQUIRE(JAutoscaler::parse_target("off") == JAutoscaler::Target::Off);
+    REQUIRE(JAutoscaler::parse_target("throughput") == JAutoscaler::Target::Throughput);
+    REQUIRE(JAutoscaler::parse_target("cpu_budget") == JAutoscaler::Target::CpuBudget);
+    REQUIRE_THROWS_AS(JAutoscaler::parse_target("fastest"), JException);
+}
+
+TEST_CASE("JAutoscaler: Controller applies and reports decisions") {
+
+    JApplication app;
+    app.SetTicker(false);
+    app.Add(new scaletest::DummySource("DummySource", &app));
+    app.Add(new scaletest::DummyProcessor);
+    app.SetParameterValue("nthreads", 2);
+    app.SetParameterValue("jana:autoscale", "throughput");
+    app.SetParameterValue("jana:autoscale_interval_ms", 100);
+    app.SetParameterValue("jana:autoscale_min_threads", 1);
+    app.SetParameterValue("jana:autoscale_max_threads", 3);
+    app.Run(false);
+    auto japc = app.GetService<JArrowProcessingController>();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(700));
+    auto perf = japc->measure_internal_performance();
+    REQUIRE(!perf->autoscale_decisions.empty());
+    REQUIRE(perf->thread_count >= 1);
+    REQUIRE(perf->thread_count <= 3);
+    REQUIRE(perf->workers.size() == perf->thread_count);
+    REQUIRE(!japc->is_stopped());
+}
+
+TEST_CASE("JAutoscaler: Sampling doesn't split the ticker's interval") {
+
+    // The autoscaler samples through JPerfMetrics::peek(), so that the ticker's next split() still covers everything
+    // since its own previous split()
+    JPerfMetrics metrics;
+    metrics.start(0, 1);
+    metrics.split(10);
+
+    JPerfSummary sample;
+    metrics.peek(25, sample);
+    REQUIRE(sample.monotonic_events_completed == 25);
+    REQUIRE(sample.total_events_completed == 25);
+    REQUIRE(sample.latest_events_completed == 15);
+    metrics.peek(28, sample);
+    REQUIRE(sample.latest_events_completed == 18);
+
+    metrics.split(30);
+    JPerfSummary ticker;
+    metrics.summarize(ticker);
+    REQUIRE(ticker.latest_events_completed == 20);
+    REQUIRE(ticker.total_events_completed == 30);
+}
@@ -6,6 +6,9 @@
 #include "catch.hpp"
 #include <JANA/JEvent.h>
 
+#include <chrono>
+#include <iostream>
+
 struct Base {
     double base;
     Base(double base) : base(base) {};
@@ -57,6 +60,28 @@ public:
     }
 };
 
+struct Left : public virtual Base {
+    double left;
+    Left(double left) : Base(0), left(left) {};
+};
+
+struct Right : public virtual Base {
+    double right;
+    Right(double right) : Base(0), right(right) {};
+};
+
+struct Diamond : public Left, Right {
+    Diamond(double base, double left, double right) : Base(base), Left(left), Right(right) {};
+};
+
+class DiamondFactory : public JFactoryT<Diamond> {
+public:
+    DiamondFactory() {
+        EnableGetAs<Base>();
+        EnableGetAs<Right>();
+    }
+};
+
 class MultipleFactoryMissing : public JFactoryT<Multiple> {
 public:
     MultipleFactoryMissing() {
@@ -156,6 +181,80 @@ TEST_CASE("JFactoryGetAs") {
     }
 }
 
+TEST_CASE("JFactoryGetAsView") {
+
+    SECTION("Views upcast lazily, with the same results as GetAs") {
+        MultipleFactory f;
+        f.Insert(new Multiple(22, 27, 42, 49));
+        f.Insert(new Multiple(23, 28, 43, 50));
+
+        auto unrelateds = f.GetAsView<Unrelated>();  // Not the first base, so the pointer moves
+        REQUIRE(unrelateds.size() == 2);
+        REQUIRE(unrelateds[1]->unrelated == 43);
+        REQUIRE(unrelateds[0] == f.GetAs<Unrelated>()[0]);
+        REQUIRE(unrelateds[0] == static_cast<const Unrelated*>(f.GetSpan()[0]));
+
+        double sum = 0;
+        for (auto base : f.GetAsView<Base>()) sum += base->base;
+        REQUIRE(sum == 45);
+    }
+
+    SECTION("Views of types which weren't enabled are empty") {
+        MultipleFactoryMissing f;
+        f.Insert(new Multiple(22, 27, 42, 49));
+        REQUIRE(f.GetAsView<Base>().empty());
+        REQUIRE(f.GetAsView<Derived>().size() == 1);
+    }
+
+    SECTION("Null pointers stay null") {
+        MultipleFactory f;
+        f.Insert(static_cast<Multiple*>(nullptr));
+        REQUIRE(f.GetAsView<Unrelated>()[0] == nullptr);
+        REQUIRE(f.GetAs<Unrelated>()[0] == nullptr);
+        f.ClearData();
+    }
+
+    SECTION("Virtual bases are found through each object") {
+        DiamondFactory f;
+        f.Insert(new Diamond(22, 27, 42));
+        f.Insert(new Diamond(23, 28, 43));
+
+        auto bases = f.GetAsView<Base>();
+        REQUIRE(bases.size() == 2);
+        REQUIRE(bases[0]->base == 22);
+        REQUIRE(bases[1]->base == 23);
+        REQUIRE(bases[1] == static_cast<const Base*>(f.GetSpan()[1]));
+        REQUIRE(f.GetAs<Right>()[1]->right == 43);
+    }
+}
+
+TEST_CASE("JFactoryGetAs: Upcast benchmark", "[.][performance]") {
+
+    MultipleFactory f;
+    for (int i=0; i<100; ++i) f.Insert(new Multiple(i, 0, 1, 2));
+
+    const size_t iterations = 200000;
+    double total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i=0; i<iterations; ++i) {
+        for (auto u : f.GetAs<Unrelated>()) total += u->unrelated;
+    }
+    auto get_as_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i=0; i<iterations; ++i) {
+        for (auto u : f.GetAsView<Unrelated>()) total += u->unrelated;
+    }
+    auto view_time = std::chrono::steady_clock::now() - start;
+    REQUIRE(total == 2 * 100 * iterations);
+
+    auto per_call = [&](std::chrono::steady_clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / double(iterations);
+    };
+    std::cout << "GetAs<S>:     " << per_call(get_as_time) << " ns per call over 100 objects" << std::endl;
+    std::cout << "GetAsView<S>: " << per_call(view_time) << " ns per call over 100 objects" << std::endl;
+}
+
 TEST_CASE("JEventGetAllChildren") {
 
     auto event = std::make_shared<JEvent>();
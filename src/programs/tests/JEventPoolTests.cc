@@ -0,0 +1,311 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "catch.hpp"
+
+#include <JANA/JApplication.h>
+#include <JANA/Engine/JTopologyBuilder.h>
+#include <JANA/Utils/JEventPool.h>
+#include <JANA/Utils/JProcessorMapping.h>
+#include <JANA/JEventProcessor.h>
+#include <JANA/JEventSource.h>
+
+#include <iomanip>
+#include <thread>
+
+namespace jeventpooltests {
+struct Hit : public JObject {
+    int value;
+    explicit Hit(int value) : value(value) {}
+};
+struct Blob : public JObject {
+    char payload[1000];
+};
+struct BlobSource : public JEventSource {
+    std::atomic_size_t max_bytes_in_flight {0};
+    JEventPool* pool = nullptr;
+    BlobSource() : JEventSource("BlobSource") {}
+    void GetEvent(std::shared_ptr<JEvent> event) override {
+        event->Insert(new Blob);
+        if (pool != nullptr && pool->get_bytes_in_flight() > max_bytes_in_flight) {
+            max_bytes_in_flight = pool->get_bytes_in_flight();
+        }
+    }
+};
+struct BlobProcessor : public JEventProcessor {
+    std::atomic_size_t count {0};
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        count += event->Get<Blob>().size();
+    }
+};
+} // namespace jeventpooltests
+
+TEST_CASE("JEventPool: Events return to the location which created them") {
+
+    JApplication app;
+    app.Initialize();
+    JEventPool pool(app.GetService<JComponentManager>(), 6, 2, true);
+    REQUIRE(pool.get_location_count() == 2);
+
+    auto event = pool.get(0);
+    REQUIRE(event != nullptr);
+    REQUIRE(pool.get_stats(0).available == 2);
+
+    // A worker from location 1 finishes it, but it belongs to location 0
+    pool.put(event, 1);
+    REQUIRE(pool.get_stats(0).available == 3);
+    REQUIRE(pool.get_stats(0).foreign_returns == 1);
+    REQUIRE(pool.get_stats(1).available == 3);
+    REQUIRE(pool.get_stats(1).foreign_returns == 0);
+
+    // Mixed batches get split up by home location
+    std::vector<std::shared_ptr<JEvent>> events;
+    REQUIRE(pool.get_many(events, 2, 1));
+    REQUIRE(pool.get_many(events, 3, 0));
+    REQUIRE(pool.get_stats(0).available == 0);
+    REQUIRE(pool.get_stats(1).available == 1);
+
+    // Once its own location runs dry, get() borrows from the others. Borrowed events still go home afterwards.
+    events.push_back(pool.get(0));
+    REQUIRE(events.back() != nullptr);
+    REQUIRE(pool.get_stats(1).available == 0);
+    REQUIRE(pool.get(0) == nullptr);
+    REQUIRE(!pool.get_many(events, 1, 1));
+    REQUIRE(events.size() == 6);
+
+    pool.put_many(events, 1);
+    REQUIRE(events.empty());
+    REQUIRE(pool.get_stats(0).available == 3);
+    REQUIRE(pool.get_stats(0).foreign_returns == 4);
+    REQUIRE(pool.get_stats(1).available == 3);
+    REQUIRE(pool.get_stats(1).foreign_returns == 0);
+}
+
+TEST_CASE("JEventPool: Each location is allocated on one of its own cpus") {
+
+    JApplication app;
+    app.Initialize();
+    JProcessorMapping mapping;
+    mapping.initialize(JProcessorMapping::AffinityStrategy::None, JProcessorMapping::LocalityStrategy::CpuLocal);
+
+    JEventPool pool(app.GetService<JComponentManager>(), 2*mapping.get_loc_count(), mapping.get_loc_count(), true, &mapping);
+    REQUIRE(pool.get_location_count() == mapping.get_loc_count());
+
+    for (size_t loc=0; loc<pool.get_location_count(); ++loc) {
+        auto stats = pool.get_stats(loc);
+        REQUIRE(stats.capacity == 2);
+        REQUIRE(stats.available == 2);
+        if (pool.get_location_count() > 1) {
+            // With only one location there is nothing to keep local, so nothing gets pinned
+            REQUIRE(stats.is_pinned);
+            REQUIRE(stats.cpu_id == mapping.get_loc_cpu_id(loc));
+            REQUIRE(stats.numa_domain_id == mapping.get_loc_numa_domain_id(loc));
+        }
+        auto event = pool.get(loc);
+        REQUIRE(event != nullptr);
+        pool.put(event, loc);
+        REQUIRE(pool.get_stats(loc).available == 2);
+        REQUIRE(pool.get_stats(loc).foreign_returns == 0);
+    }
+}
+
+TEST_CASE("JEventPool: The pool is split between locations, and each may use all of it") {
+
+    JApplication app;
+    app.Initialize();
+    JEventPool pool(app.GetService<JComponentManager>(), 10, 4, true);
+
+    // 10 events over 4 locations is 3+3+2+2, not 3 each
+    size_t total = 0;
+    for (size_t loc=0; loc<4; ++loc) {
+        total += pool.get_stats(loc).capacity;
+        REQUIRE(pool.get_stats(loc).capacity == (loc < 2 ? 3 : 2));
+    }
+    REQUIRE(total == 10);
+
+    // A single caller, like the sequential source arrow, can have the whole pool in flight
+    std::vector<std::shared_ptr<JEvent>> events;
+    REQUIRE(pool.get_many(events, 4, 3));
+    for (size_t i=0; i<6; ++i) {
+        events.push_back(pool.get(3));
+        REQUIRE(events.back() != nullptr);
+    }
+    REQUIRE(pool.get(3) == nullptr);
+
+    // All or nothing: a batch which can't be filled hands back what it took, to the right locations
+    pool.put(events.back(), 3);
+    events.pop_back();
+    REQUIRE(!pool.get_many(events, 2, 0));
+    REQUIRE(events.size() == 9);
+
+    pool.put_many(events, 3);
+    for (size_t loc=0; loc<4; ++loc) {
+        REQUIRE(pool.get_stats(loc).available == pool.get_stats(loc).capacity);
+    }
+}
+
+TEST_CASE("JEventPool: Events are reset when they are put back") {
+
+    JApplication app;
+    app.Initialize();
+    JEventPool pool(app.GetService<JComponentManager>(), 1, 1, true);
+    using jeventpooltests::Hit;
+
+    auto event = pool.get();
+    event->Insert(new Hit(22));
+    REQUIRE(event->Get<Hit>().size() == 1);
+    auto raw = event.get();
+    pool.put(event);
+    REQUIRE(event == nullptr);
+
+    event = pool.get();
+    REQUIRE(event.get() == raw);
+    REQUIRE(event->Get<Hit>().empty());
+}
+
+TEST_CASE("JEventPool: Byte budget limits the events in flight") {
+
+    JApplication app;
+    app.Initialize();
+    JEventPool pool(app.GetService<JComponentManager>(), 4, 1, true);
+    using jeventpooltests::Blob;
+    const size_t blob_bytes = sizeof(Blob);
+    pool.set_max_bytes_in_flight(2*blob_bytes + blob_bytes/2);
+
+    // Nothing is known about event sizes yet, so the first event is charged the whole budget
+    auto event = pool.get();
+    REQUIRE(event != nullptr);
+    REQUIRE(pool.get_bytes_in_flight() == 2*blob_bytes + blob_bytes/2);
+    REQUIRE(pool.get() == nullptr);
+    REQUIRE(pool.get_byte_budget_rejections() == 1);
+    event->Insert(new Blob);
+    REQUIRE(event->GetEstimatedBytes() == blob_bytes);
+    pool.put(event);
+    REQUIRE(pool.get_avg_event_bytes() == blob_bytes);
+    REQUIRE(pool.get_max_event_bytes() == blob_bytes);
+
+    // From now on each event is charged one Blob, so only two fit
+    auto first = pool.get();
+    auto second = pool.get();
+    REQUIRE(first != nullptr);
+    REQUIRE(second != nullptr);
+    REQUIRE(pool.get_bytes_in_flight() == 2*blob_bytes);
+    REQUIRE(pool.get() == nullptr);
+    REQUIRE(pool.get_byte_budget_rejections() == 2);
+    std::vector<std::shared_ptr<JEvent>> events;
+    REQUIRE(!pool.get_many(events, 1));
+    REQUIRE(events.empty());
+    REQUIRE(pool.get_byte_budget_rejections() == 3);
+
+    pool.put(first);
+    REQUIRE(pool.get_bytes_in_flight() == blob_bytes);
+    REQUIRE(pool.get_many(events, 1));
+    pool.put_many(events);
+    pool.put(second);
+    REQUIRE(pool.get_bytes_in_flight() == 0);
+
+    SECTION("An event larger than the whole budget is still admitted when nothing is in flight") {
+        pool.set_max_bytes_in_flight(blob_bytes / 2);
+        event = pool.get();
+        REQUIRE(event != nullptr);
+        REQUIRE(pool.get() == nullptr);
+        pool.put(event);
+        REQUIRE(pool.get_bytes_in_flight() == 0);
+    }
+}
+
+TEST_CASE("JEventPool: Byte budget admits one event at a time until the average is known") {
+
+    JApplication app;
+    app.Initialize();
+    JEventPool pool(app.GetService<JComponentManager>(), 4, 1, true);
+    pool.set_max_bytes_in_flight(1000000);
+
+    // A source which hands its event back without emitting it teaches the pool nothing
+    auto event = pool.get();
+    REQUIRE(event != nullptr);
+    REQUIRE(pool.get() == nullptr);
+    pool.put(event);
+    REQUIRE(pool.get_avg_event_bytes() == 0);
+    event = pool.get();
+    REQUIRE(event != nullptr);
+    std::vector<std::shared_ptr<JEvent>> events;
+    REQUIRE(!pool.get_many(events, 2));
+    REQUIRE(pool.get() == nullptr);
+
+    SECTION("The first event with a size settles the charge") {
+        event->Insert(new jeventpooltests::Blob);
+        pool.put(event);
+        REQUIRE(pool.get_bytes_in_flight() == 0);
+        REQUIRE(pool.get_many(events, 4));
+        REQUIRE(pool.get_bytes_in_flight() == 4*sizeof(jeventpooltests::Blob));
+        pool.put_many(events);
+    }
+
+    SECTION("A whole pool of events without sizes turns the budget off") {
+        for (int i=0; i<3; ++i) {
+            pool.put(event);
+            event = pool.get();
+            REQUIRE(event != nullptr);
+        }
+        pool.put(event);
+        REQUIRE(pool.get_many(events, 4));
+        REQUIRE(pool.get_bytes_in_flight() == 0);
+        pool.put_many(events);
+    }
+}
+
+TEST_CASE("JEventPool: Byte budget still lets every event through the topology") {
+
+    using namespace jeventpooltests;
+    JApplication app;
+    app.SetTicker(false);
+    auto source = new BlobSource;
+    auto processor = new BlobProcessor;
+    app.Add(source);
+    app.Add(processor);
+    app.SetParameterValue("nthreads", 4);
+    app.SetParameterValue("jana:nevents", 200);
+    app.SetParameterValue("jana:max_bytes_in_flight", 3*sizeof(Blob));
+    app.Initialize();
+    source->pool = app.GetService<JTopologyBuilder>()->get()->event_pool.get();
+    app.Run(true);
+
+    REQUIRE(processor->count == 200);
+    REQUIRE(source->max_bytes_in_flight <= 3*sizeof(Blob));
+}
+
+TEST_CASE("JEventPool: Contended get/put benchmark", "[.][performance]") {
+
+    // Each thread repeatedly takes an event and puts it straight back, so that the cost is dominated by
+    // the pool itself. Run with `janatests "[performance]"`.
+    using clock_t = std::chrono::steady_clock;
+    const size_t iterations = 200000;
+
+    JApplication app;
+    app.Initialize();
+
+    std::cout << std::setw(10) << "Threads" << std::setw(20) << "ns per get+put" << std::endl;
+    for (size_t nthreads : {1, 2, 4, 8}) {
+        JEventPool pool(app.GetService<JComponentManager>(), 2*nthreads, 1, true);
+        std::atomic_size_t failures {0};
+        std::vector<std::thread> threads;
+        auto start = clock_t::now();
+        for (size_t t=0; t<nthreads; ++t) {
+            threads.emplace_back([&] {
+                for (size_t i=0; i<iterations; ++i) {
+                    auto event = pool.get();
+                    if (event == nullptr) { failures++; continue; }
+                    pool.put(event);
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        auto elapsed = clock_t::now() - start;
+        REQUIRE(failures == 0);
+        REQUIRE(pool.get_stats(0).available == 2*nthreads);
+
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count() / (iterations * nthreads);
+        std::cout << std::setw(10) << nthreads << std::setw(20) << std::fixed << std::setprecision(1) << ns << std::endl;
+    }
+}
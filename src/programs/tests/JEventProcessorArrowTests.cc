@@ -0,0 +1,131 @@
+
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "catch.hpp"
+
+#include <JANA/JApplication.h>
+#include <JANA/JEventSource.h>
+#include <JANA/JEventProcessor.h>
+#include <JANA/Engine/JEventProcessorArrow.h>
+#include <JANA/Utils/JEventPool.h>
+
+#include <iomanip>
+
+
+namespace jeventprocessorarrowtests {
+
+struct BoundedSource : public JEventSource {
+
+    std::atomic_int emit_count {0};
+    std::atomic_int finish_count {0};
+    int event_bound = 100;
+
+    BoundedSource(JApplication* app) : JEventSource("BoundedSource", app) {
+        EnableFinishEvent();
+    }
+
+    void GetEvent(std::shared_ptr<JEvent> event) override {
+        if (emit_count >= event_bound) {
+            throw JEventSource::RETURN_STATUS::kNO_MORE_EVENTS;
+        }
+        event->SetEventNumber(++emit_count);
+    }
+
+    void FinishEvent(JEvent&) override {
+        finish_count++;
+    }
+};
+
+struct CountingProcessor : public JEventProcessor {
+
+    std::atomic_int process_count {0};
+    std::atomic_long event_number_sum {0};
+
+    CountingProcessor(JApplication* app) : JEventProcessor(app) {}
+
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        process_count++;
+        event_number_sum += event->GetEventNumber();
+    }
+};
+
+} // namespace jeventprocessorarrowtests
+
+
+TEST_CASE("JEventProcessorArrow: Chunked dequeue processes and finishes every event exactly once") {
+
+    using namespace jeventprocessorarrowtests;
+    auto chunksize = GENERATE(1, 7, 32);
+
+    JApplication app;
+    auto source = new BoundedSource(&app);
+    auto processor = new CountingProcessor(&app);
+    app.Add(source);
+    app.Add(processor);
+    app.SetParameterValue("nthreads", 4);
+    app.SetParameterValue("jana:event_pool_size", 16);
+    app.SetParameterValue("jana:event_processor_chunksize", chunksize);
+    app.SetTicker(false);
+    app.Run(true);
+
+    REQUIRE(source->emit_count == 100);
+    REQUIRE(processor->process_count == 100);
+    REQUIRE(processor->event_number_sum == 100 * 101 / 2);
+    REQUIRE(source->finish_count == 100);
+    REQUIRE(app.GetNEventsProcessed() == 100);
+}
+
+
+TEST_CASE("JEventProcessorArrow: Chunked dequeue benchmark", "[.][performance]") {
+
+    // With almost no work per event, the cost of each event is dominated by the round-trips to the input queue
+    // and the event pool, which chunking amortizes. We drive the arrow directly so that the (sequential) event
+    // source doesn't hide the difference. Run with `janatests "[performance]"`.
+    using namespace jeventprocessorarrowtests;
+    using clock_t = std::chrono::steady_clock;
+    using Event = std::shared_ptr<JEvent>;
+    const size_t event_count = 1000;
+    const size_t repetitions = 200;
+
+    JApplication app;
+    auto processor = new CountingProcessor(&app);
+    app.Add(processor);
+    app.Initialize();
+    auto pool = std::make_shared<JEventPool>(app.GetService<JComponentManager>(), event_count, 1, true);
+
+    std::cout << std::setw(10) << "Chunksize" << std::setw(20) << "Events/s" << std::setw(20) << "Overhead [ns/event]" << std::endl;
+    for (size_t chunksize : {1, 2, 4, 8, 16, 32, 64}) {
+        JMailbox<Event> queue(event_count);
+        JEventProcessorArrow arrow("processors", &queue, nullptr, pool);
+        arrow.add_processor(processor);
+        arrow.set_chunksize(chunksize);
+
+        JArrowMetrics metrics;
+        metrics.clear();
+        clock_t::duration elapsed = clock_t::duration::zero();
+        for (size_t rep=0; rep<repetitions; ++rep) {
+            std::vector<Event> events;
+            pool->get_many(events, event_count);
+            queue.push(events);
+
+            auto start = clock_t::now();
+            while (queue.size(0) > 0) {
+                arrow.execute(metrics, 0);
+            }
+            elapsed += clock_t::now() - start;
+        }
+
+        JArrowMetrics::Status last_status;
+        size_t total_message_count, last_message_count, total_queue_visits, last_queue_visits;
+        JArrowMetrics::duration_t total_latency, last_latency, total_queue_latency, last_queue_latency;
+        metrics.get(last_status, total_message_count, last_message_count, total_queue_visits, last_queue_visits,
+                    total_latency, last_latency, total_queue_latency, last_queue_latency);
+        REQUIRE(total_message_count == event_count * repetitions);
+
+        double elapsed_s = std::chrono::duration<double>(elapsed).count();
+        double overhead_ns = std::chrono::duration<double, std::nano>(total_queue_latency).count() / total_message_count;
+        std::cout << std::setw(10) << chunksize << std::setw(20) << std::fixed << std::setprecision(0)
+                  << total_message_count / elapsed_s << std::setw(20) << std::setprecision(1) << overhead_ns << std::endl;
+    }
+}
@@ -0,0 +1,165 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "catch.hpp"
+
+#include <JANA/JApplication.h>
+#include <JANA/JEventSource.h>
+#include <JANA/JEventProcessor.h>
+#include <JANA/Engine/JArrowProcessingController.h>
+#include <JANA/Engine/JArrowPerfSummary.h>
+
+#include <random>
+#include <thread>
+
+
+namespace jeventreorderarrowtests {
+
+struct BoundedSource : public JEventSource {
+
+    std::atomic_int emit_count {0};
+    std::atomic_int finish_count {0};
+    int event_bound = 200;
+
+    BoundedSource(JApplication* app) : JEventSource("BoundedSource", app) {
+        EnableFinishEvent();
+    }
+
+    void GetEvent(std::shared_ptr<JEvent> event) override {
+        if (emit_count >= event_bound) {
+            throw JEventSource::RETURN_STATUS::kNO_MORE_EVENTS;
+        }
+        event->SetEventNumber(++emit_count);
+    }
+
+    void FinishEvent(JEvent&) override {
+        finish_count++;
+    }
+};
+
+/// Takes a random amount of time per event, so that the parallel stage finishes events out of order
+struct JitteryProcessor : public JEventProcessor {
+
+    std::atomic_int process_count {0};
+
+    JitteryProcessor(JApplication* app) : JEventProcessor(app) {}
+
+    void Process(const std::shared_ptr<const JEvent>&) override {
+        thread_local std::mt19937 rng(std::hash<std::thread::id>()(std::this_thread::get_id()));
+        std::this_thread::sleep_for(std::chrono::microseconds(rng() % 200));
+        process_count++;
+    }
+};
+
+struct OrderedProcessor : public JEventProcessor {
+
+    std::vector<uint64_t> event_numbers;  // No lock needed, because ordered processors run sequentially
+    std::vector<uint64_t> event_indices;
+
+    OrderedProcessor(JApplication* app) : JEventProcessor(app) {
+        SetEventsOrdered(true);
+    }
+
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        event_numbers.push_back(event->GetEventNumber());
+        event_indices.push_back(event->GetEventIndex());
+    }
+};
+
+} // namespace jeventreorderarrowtests
+
+
+TEST_CASE("JEventReorderArrow: Ordered processors see every event in order") {
+
+    using namespace jeventreorderarrowtests;
+    auto window = GENERATE(1, 5, 32);
+
+    JApplication app;
+    auto source = new BoundedSource(&app);
+    auto jittery = new JitteryProcessor(&app);
+    auto ordered = new OrderedProcessor(&app);
+    app.Add(source);
+    app.Add(jittery);
+    app.Add(ordered);
+    app.SetParameterValue("nthreads", 4);
+    app.SetParameterValue("jana:event_pool_size", 32);
+    app.SetParameterValue("jana:reorder_window", window);
+    app.SetTicker(false);
+    app.Run(true);
+
+    REQUIRE(jittery->process_count == 200);
+    REQUIRE(ordered->event_numbers.size() == 200);
+    for (size_t i=0; i<ordered->event_numbers.size(); ++i) {
+        REQUIRE(ordered->event_numbers[i] == i + 1);
+    }
+    REQUIRE(source->finish_count == 200);
+    REQUIRE(app.GetNEventsProcessed() == 200);
+
+    auto perf = app.GetService<JArrowProcessingController>()->measure_internal_performance();
+    bool found_reorder_arrow = false;
+    for (auto& arrow : perf->arrows) {
+        if (arrow.reorder_window == 0) continue;
+        found_reorder_arrow = true;
+        REQUIRE(arrow.reorder_window == (size_t) window);
+        REQUIRE(arrow.reorder_max_depth <= (size_t) window);
+        REQUIRE(arrow.reorder_depth == 0);
+        REQUIRE(arrow.reorder_stall_ms >= 0);
+    }
+    REQUIRE(found_reorder_arrow);
+}
+
+TEST_CASE("JEventReorderArrow: Concurrent sources share one consecutive event index") {
+
+    using namespace jeventreorderarrowtests;
+
+    JApplication app;
+    std::vector<BoundedSource*> sources;
+    for (int i=0; i<3; ++i) {
+        auto source = new BoundedSource(&app);
+        source->event_bound = 50 + 10*i;
+        sources.push_back(source);
+        app.Add(source);
+    }
+    auto jittery = new JitteryProcessor(&app);
+    auto ordered = new OrderedProcessor(&app);
+    app.Add(jittery);
+    app.Add(ordered);
+    app.SetParameterValue("nthreads", 4);
+    app.SetParameterValue("jana:event_pool_size", 16);
+    app.SetParameterValue("jana:reorder_window", 8);
+    app.SetParameterValue("jana:concurrent_sources", true);
+    app.SetTicker(false);
+    app.Run(true);
+
+    REQUIRE(jittery->process_count == 50+60+70);
+    REQUIRE(ordered->event_indices.size() == 50+60+70);
+    for (size_t i=0; i<ordered->event_indices.size(); ++i) {
+        REQUIRE(ordered->event_indices[i] == i);
+    }
+    for (auto source : sources) {
+        REQUIRE(source->finish_count == source->event_bound);
+    }
+}
+
+TEST_CASE("JEventReorderArrow: No reorder buffer without ordered processors") {
+
+    using namespace jeventreorderarrowtests;
+
+    JApplication app;
+    auto source = new BoundedSource(&app);
+    auto jittery = new JitteryProcessor(&app);
+    app.Add(source);
+    app.Add(jittery);
+    app.SetParameterValue("nthreads", 2);
+    app.SetTicker(false);
+    app.Run(true);
+
+    REQUIRE(jittery->process_count == 200);
+    REQUIRE(source->finish_count == 200);
+
+    auto perf = app.GetService<JArrowProcessingController>()->measure_internal_performance();
+    REQUIRE(perf->arrows.size() == 2);
+    for (auto& arrow : perf->arrows) {
+        REQUIRE(arrow.reorder_window == 0);
+    }
+}
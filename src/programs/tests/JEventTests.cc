@@ -8,6 +8,9 @@
 #include <JANA/JEvent.h>
 #include "JEventTests.h"
 
+#include <chrono>
+#include <iostream>
+
 
 TEST_CASE("JEventInsertTests") {
 
@@ -221,5 +224,47 @@ TEST_CASE("JEventInsertTests") {
         REQUIRE_THROWS(event->GetSingleStrict<FakeJObject>());
     }
 
+    SECTION("JEvent::GetSpan views the factory's objects without copying them") {
+        event->Insert(new FakeJObject(22));
+        event->Insert(new FakeJObject(99));
+        auto span = event->GetSpan<FakeJObject>();
+        auto vec = event->Get<FakeJObject>();
+        REQUIRE(span.size() == 2);
+        REQUIRE(span[0] == vec[0]);
+        REQUIRE(span[1]->datum == 99);
+        REQUIRE(span.data() == event->GetFactory<FakeJObject>()->GetSpan().data());
+
+        JFactoryHandle<FakeJObject> handle;
+        REQUIRE(event->GetSpan(handle).data() == span.data());
+        REQUIRE_THROWS(event->GetSpan<DifferentFakeJObject>());
+
+        int sum = 0;
+        for (auto obj : span) sum += obj->datum;
+        REQUIRE(sum == 121);
+    }
+
 }
 
+TEST_CASE("JEvent: Get vs GetSpan benchmark", "[.][performance]") {
+
+    auto event = std::make_shared<JEvent>();
+    event->SetFactorySet(new JFactorySet);
+    for (int i=0; i<100; ++i) event->Insert(new FakeJObject(i));
+
+    const size_t iterations = 1000000;
+    size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i=0; i<iterations; ++i) total += event->Get<FakeJObject>().size();
+    auto get_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i=0; i<iterations; ++i) total += event->GetSpan<FakeJObject>().size();
+    auto span_time = std::chrono::steady_clock::now() - start;
+    REQUIRE(total == 200 * iterations);
+
+    auto per_call = [&](std::chrono::steady_clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / double(iterations);
+    };
+    std::cout << "JEvent::Get<T>:     " << per_call(get_time) << " ns per call" << std::endl;
+    std::cout << "JEvent::GetSpan<T>: " << per_call(span_time) << " ns per call" << std::endl;
+}
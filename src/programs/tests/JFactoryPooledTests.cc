@@ -0,0 +1,213 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "catch.hpp"
+
+#include <JANA/JApplication.h>
+#include <JANA/JEventProcessor.h>
+#include <JANA/JEventSource.h>
+#include <JANA/JFactoryGenerator.h>
+#include <JANA/JFactoryPooledT.h>
+#include <JANA/Engine/JArrowProcessingController.h>
+
+#include <chrono>
+#include <iostream>
+#include <set>
+
+namespace jfactorypooledtests {
+
+struct Hit : public JObject {
+    int value = 0;
+    std::vector<double> samples;
+};
+
+struct SpecialHit : public Hit {};
+
+struct Waveform : public JResettable {
+    static int release_count;
+    static int reset_count;
+    std::vector<double> samples;
+    void Release() override { release_count++; }
+    void Reset() override { reset_count++; samples.clear(); }
+};
+int Waveform::release_count = 0;
+int Waveform::reset_count = 0;
+
+struct HitFactory : public JFactoryPooledT<Hit> {
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        for (int i=0; i<3; ++i) {
+            auto hit = InsertRecycled();
+            hit->value = event->GetEventNumber();
+            hit->samples.push_back(i);
+        }
+    }
+};
+
+struct Source : public JEventSource {
+    Source() : JEventSource("Source") {}
+    void GetEvent(std::shared_ptr<JEvent>) override {}
+};
+
+struct Processor : public JEventProcessor {
+    std::atomic_size_t wrong {0};
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        for (auto hit : event->Get<Hit>()) {
+            if (hit->value != (int) event->GetEventNumber() || hit->samples.size() != 1) wrong++;
+        }
+    }
+};
+
+} // namespace jfactorypooledtests
+
+
+TEST_CASE("JFactoryPooledT: ClearData recycles objects into the next event") {
+
+    using namespace jfactorypooledtests;
+    JPoolStatistics statistics;
+    HitFactory factory;
+    factory.SetPoolStatistics(&statistics);
+    auto event = std::make_shared<JEvent>();
+    event->SetEventNumber(22);
+
+    auto first = factory.GetOrCreate(event);
+    std::set<Hit*> first_hits(first.first, first.second);
+    REQUIRE(first_hits.size() == 3);
+    factory.ClearData();
+    for (auto hit : first_hits) {
+        // Reassigned from Hit() as soon as they were recycled, so the pool doesn't keep their samples alive
+        REQUIRE(hit->samples.capacity() == 0);
+    }
+
+    event->SetEventNumber(23);
+    auto second = factory.GetOrCreate(event);
+    std::set<Hit*> second_hits(second.first, second.second);
+    REQUIRE(second_hits == first_hits);
+    for (auto hit : second_hits) {
+        // Nothing is left over from the previous event
+        REQUIRE(hit->value == 23);
+        REQUIRE(hit->samples.size() == 1);
+    }
+    REQUIRE(statistics.get_misses() == 3);
+    REQUIRE(statistics.get_hits() == 3);
+    REQUIRE(statistics.get_hit_rate() == 0.5);
+    factory.ClearData();
+}
+
+TEST_CASE("JFactoryPooledT: Ownership flags") {
+
+    using namespace jfactorypooledtests;
+    JPoolStatistics statistics;
+    JFactoryPooledT<Hit> factory;
+    factory.SetPoolStatistics(&statistics);
+
+    SECTION("NOT_OBJECT_OWNER factories don't recycle what they don't own") {
+        factory.SetFactoryFlag(JFactory::NOT_OBJECT_OWNER);
+        Hit owned_elsewhere;
+        factory.Insert(&owned_elsewhere);
+        factory.ClearData();
+        factory.ClearFactoryFlag(JFactory::NOT_OBJECT_OWNER);
+        auto hit = factory.InsertRecycled();
+        REQUIRE(hit != &owned_elsewhere);
+        factory.ClearData();
+    }
+
+    SECTION("PERSISTENT factories keep their objects") {
+        factory.SetFactoryFlag(JFactory::PERSISTENT);
+        auto hit = factory.InsertRecycled();
+        hit->value = 5;
+        factory.ClearData();
+        REQUIRE(factory.GetNumObjects() == 1);
+        REQUIRE(hit->value == 5);
+        factory.ClearFactoryFlag(JFactory::PERSISTENT);
+        factory.ClearData();
+        REQUIRE(factory.GetNumObjects() == 0);
+    }
+
+    SECTION("Subclasses get deleted instead of recycled") {
+        // Drain whatever earlier tests left in this thread's cache
+        std::vector<Hit*> drained;
+        for (size_t i=0; i<JFactoryPooledT<Hit>::THREAD_CACHE_SIZE; ++i) drained.push_back(factory.InsertRecycled());
+        JFactoryPooledT<Hit> other;
+        auto special = new SpecialHit;
+        other.Insert(special);
+        other.ClearData();
+        auto before = statistics.get_misses();
+        factory.InsertRecycled();
+        REQUIRE(statistics.get_misses() == before + 1);  // The allocator may well hand out the same address though
+        factory.ClearData();
+    }
+}
+
+TEST_CASE("JFactoryPooledT: JResettable objects are released and reset") {
+
+    using namespace jfactorypooledtests;
+    JFactoryPooledT<Waveform> factory;
+    auto waveform = factory.InsertRecycled();
+    waveform->samples.assign(100, 1.0);
+    auto capacity = waveform->samples.capacity();
+    factory.ClearData();
+    REQUIRE(Waveform::release_count == 1);
+
+    auto recycled = factory.InsertRecycled();
+    REQUIRE(recycled == waveform);
+    REQUIRE(Waveform::reset_count == 1);
+    REQUIRE(recycled->samples.empty());
+    REQUIRE(recycled->samples.capacity() == capacity);  // Reset() only cleared it
+    factory.ClearData();
+}
+
+TEST_CASE("JFactoryPooledT: Hit rate shows up in the performance summary") {
+
+    using namespace jfactorypooledtests;
+    JApplication app;
+    auto processor = new Processor;
+    app.Add(new Source);
+    app.Add(processor);
+    app.Add(new JFactoryGeneratorT<HitFactory>);
+    app.SetParameterValue("nthreads", 2);
+    app.SetParameterValue("jana:nevents", 100);
+    app.SetTicker(false);
+    app.Run(true);
+    REQUIRE(processor->wrong == 0);
+
+    auto perf = app.GetService<JArrowProcessingController>()->measure_internal_performance();
+    REQUIRE(perf->factory_pools.size() == 1);
+    auto& pool = perf->factory_pools[0];
+    REQUIRE(pool.name == "jfactorypooledtests::Hit");
+    REQUIRE(pool.hits + pool.misses == 300);
+    REQUIRE(pool.hits > 0);
+    REQUIRE(pool.hit_rate == Approx(pool.hits / 300.0));
+}
+
+TEST_CASE("JFactoryPooledT: Recycled vs new benchmark", "[.][performance]") {
+
+    using namespace jfactorypooledtests;
+    const size_t events = 2000;
+    const size_t objects_per_event = 1000;
+
+    JFactoryT<Hit> with_new;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t e=0; e<events; ++e) {
+        for (size_t i=0; i<objects_per_event; ++i) {
+            auto hit = new Hit;
+            hit->samples.push_back(i);
+            with_new.Insert(hit);
+        }
+        with_new.ClearData();
+    }
+    auto new_time = std::chrono::steady_clock::now() - start;
+
+    JFactoryPooledT<Hit> with_pool;
+    start = std::chrono::steady_clock::now();
+    for (size_t e=0; e<events; ++e) {
+        for (size_t i=0; i<objects_per_event; ++i) with_pool.InsertRecycled()->samples.push_back(i);
+        with_pool.ClearData();
+    }
+    auto pool_time = std::chrono::steady_clock::now() - start;
+
+    auto per_object = [&](std::chrono::steady_clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / double(events * objects_per_event);
+    };
+    std::cout << "new/delete:     " << per_object(new_time) << " ns per object" << std::endl;
+    std::cout << "InsertRecycled: " << per_object(pool_time) << " ns per object" << std::endl;
+}
@@ -0,0 +1,204 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "catch.hpp"
+
+#include <JANA/JEvent.h>
+#include <JANA/JFactoryHandle.h>
+#include <JANA/JFactorySet.h>
+#include <JANA/JFactoryT.h>
+
+#include <chrono>
+#include <iostream>
+
+namespace jfactorysettests {
+
+struct Hit { int value = 0; };
+struct Cluster { int value = 0; };
+
+template <typename T>
+JFactoryT<T>* make_factory(const std::string& tag) {
+    auto factory = new JFactoryT<T>;
+    factory->SetTag(tag);
+    return factory;
+}
+
+struct CalibratedHitFactory : public JFactoryT<Hit> {
+    CalibratedHitFactory() { SetTag("calibrated"); }
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        auto hit = new Hit;
+        hit->value = event->GetEventNumber();
+        Insert(hit);
+    }
+};
+
+} // namespace jfactorysettests
+
+
+TEST_CASE("JFactorySet: Type ids are dense and stable") {
+
+    using namespace jfactorysettests;
+    auto hit_id = JFactorySet::GetTypeId<Hit>();
+    auto cluster_id = JFactorySet::GetTypeId<Cluster>();
+    REQUIRE(hit_id != cluster_id);
+    REQUIRE(JFactorySet::GetTypeId<Hit>() == hit_id);
+    REQUIRE(JFactorySet::GetTypeId(std::type_index(typeid(Hit))) == hit_id);
+
+    // Ids are handed out in order, so a new type gets the next one
+    struct Unseen {};
+    auto unseen_id = JFactorySet::GetTypeId<Unseen>();
+    REQUIRE(unseen_id > hit_id);
+    REQUIRE(unseen_id > cluster_id);
+
+    REQUIRE(&JTypeInfo::demangled_name<Hit>() == &JTypeInfo::demangled_name<Hit>());
+    REQUIRE(JTypeInfo::demangled_name<Hit>() == "jfactorysettests::Hit");
+}
+
+TEST_CASE("JFactorySet: Lookup by type and tag") {
+
+    using namespace jfactorysettests;
+    JFactorySet factories;
+    auto untagged = make_factory<Hit>("");
+    auto zebra = make_factory<Hit>("zebra");
+    auto alpha = make_factory<Hit>("alpha");
+    factories.Add(untagged);
+    factories.Add(zebra);
+    factories.Add(alpha);
+
+    REQUIRE(factories.GetFactory<Hit>() == untagged);
+    REQUIRE(factories.GetFactory<Hit>("zebra") == zebra);
+    REQUIRE(factories.GetFactory<Hit>("alpha") == alpha);
+    REQUIRE(factories.GetFactory<Hit>("missing") == nullptr);
+    REQUIRE(factories.GetFactory<Cluster>() == nullptr);
+    REQUIRE(factories.GetFactory("jfactorysettests::Hit", "zebra") == zebra);
+    REQUIRE_THROWS(factories.Add(make_factory<Hit>("alpha")));
+
+    // Same order as before: sorted by tag
+    auto all = factories.GetAllFactories<Hit>();
+    REQUIRE(all.size() == 3);
+    REQUIRE(all[0] == untagged);
+    REQUIRE(all[1] == alpha);
+    REQUIRE(all[2] == zebra);
+}
+
+TEST_CASE("JFactorySet: Merge keeps both sets searchable") {
+
+    using namespace jfactorysettests;
+    JFactorySet destination;
+    auto first_hits = make_factory<Hit>("");
+    destination.Add(first_hits);
+
+    JFactorySet source;
+    auto duplicate_hits = make_factory<Hit>("");
+    auto clusters = make_factory<Cluster>("");
+    source.Add(duplicate_hits);
+    source.Add(clusters);
+
+    destination.Merge(source);
+    REQUIRE(destination.GetFactory<Hit>() == first_hits);
+    REQUIRE(destination.GetFactory<Cluster>() == clusters);
+
+    // Only the duplicate stays behind, and the source finds nothing else
+    REQUIRE(source.GetFactory<Hit>() == duplicate_hits);
+    REQUIRE(source.GetFactory<Cluster>() == nullptr);
+    REQUIRE(source.GetFactory("jfactorysettests::Cluster") == nullptr);
+    REQUIRE(source.GetAllFactories().size() == 1);
+}
+
+TEST_CASE("JFactoryHandle: Same factories as the string lookup, for every event") {
+
+    using namespace jfactorysettests;
+    JApplication app;
+    JFactoryHandle<Hit> calibrated_hits {"calibrated"};
+    JFactoryHandle<Cluster> clusters;
+    JFactoryHandle<Hit> missing_hits {"missing"};
+    REQUIRE(calibrated_hits.GetKeyId() == JFactoryHandle<Hit>("calibrated").GetKeyId());
+    REQUIRE(calibrated_hits.GetKeyId() != missing_hits.GetKeyId());
+
+    // The two events add their factories in different orders; the handles don't care
+    std::vector<std::shared_ptr<JEvent>> events;
+    for (int i=0; i<2; ++i) {
+        auto factories = new JFactorySet;
+        if (i == 0) {
+            factories->Add(new CalibratedHitFactory);
+            factories->Add(make_factory<Cluster>(""));
+        }
+        else {
+            factories->Add(make_factory<Cluster>(""));
+            factories->Add(make_factory<Hit>(""));
+            factories->Add(new CalibratedHitFactory);
+        }
+        auto event = std::make_shared<JEvent>(&app);
+        event->SetFactorySet(factories);
+        event->SetEventNumber(10 + i);
+        events.push_back(event);
+    }
+    for (auto& event : events) {
+        REQUIRE(event->GetFactory(calibrated_hits) == event->GetFactory<Hit>("calibrated"));
+        REQUIRE(event->GetFactory(clusters) == event->GetFactory<Cluster>());
+        REQUIRE(event->GetFactory(missing_hits) == nullptr);
+        REQUIRE_THROWS(event->Get(missing_hits));
+
+        auto hits = event->Get(calibrated_hits);
+        REQUIRE(hits.size() == 1);
+        REQUIRE(hits[0]->value == (int) event->GetEventNumber());
+        REQUIRE(event->GetSingle(calibrated_hits) == hits[0]);
+        auto iterators = event->GetIterators(calibrated_hits);
+        REQUIRE(*iterators.first == hits[0]);
+    }
+}
+
+TEST_CASE("JFactoryHandle: Inserted collections and default tags") {
+
+    using namespace jfactorysettests;
+    JApplication app;
+    auto event = std::make_shared<JEvent>(&app);
+    event->SetFactorySet(new JFactorySet);
+
+    JFactoryHandle<Cluster> inserted {"inserted"};
+    event->Insert(new Cluster, "inserted");
+    REQUIRE(event->Get(inserted).size() == 1);
+
+    auto factories = new JFactorySet;
+    factories->Add(new CalibratedHitFactory);
+    event->SetFactorySet(factories);
+    event->SetDefaultTags({{"jfactorysettests::Hit", "calibrated"}});
+    JFactoryHandle<Hit> hits;
+    REQUIRE(event->GetFactory(hits) == event->GetFactory<Hit>("calibrated"));
+    REQUIRE(event->Get(hits).size() == 1);
+}
+
+TEST_CASE("JFactorySet: Lookup benchmark", "[.][performance]") {
+
+    using namespace jfactorysettests;
+    JApplication app;
+    auto factories = new JFactorySet;
+    factories->Add(make_factory<Hit>(""));
+    factories->Add(make_factory<Hit>("calibrated"));
+    factories->Add(make_factory<Cluster>(""));
+    auto event = std::make_shared<JEvent>(&app);
+    event->SetFactorySet(factories);
+
+    const size_t iterations = 10000000;
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i=0; i<iterations; ++i) {
+        found += (event->GetFactory<Hit>("calibrated") != nullptr);
+        found += (event->GetFactory<Cluster>() != nullptr);
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    REQUIRE(found == 2 * iterations);
+    std::cout << "JEvent::GetFactory<T>: " << elapsed.count() / (2.0 * iterations) << " ns per lookup" << std::endl;
+
+    JFactoryHandle<Hit> calibrated_hits {"calibrated"};
+    JFactoryHandle<Cluster> clusters;
+    found = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i=0; i<iterations; ++i) {
+        found += (event->GetFactory(calibrated_hits) != nullptr);
+        found += (event->GetFactory(clusters) != nullptr);
+    }
+    elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    REQUIRE(found == 2 * iterations);
+    std::cout << "JEvent::GetFactory(handle): " << elapsed.count() / (2.0 * iterations) << " ns per lookup" << std::endl;
+}
@@ -0,0 +1,218 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "catch.hpp"
+
+#include <JANA/JEvent.h>
+#include <JANA/JFactorySoA.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace jfactorysoatests {
+
+JCOLUMN(HitEnergy, float);
+JCOLUMN(HitX, float);
+JCOLUMN(HitY, float);
+JCOLUMN(HitCell, int);
+
+using HitRow = JSoARow<HitEnergy, HitX, HitY, HitCell>;
+
+struct HitFactory : public JFactorySoA<HitEnergy, HitX, HitY, HitCell> {
+    int process_count = 0;
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        process_count++;
+        for (int i=0; i<4; ++i) {
+            mColumns.push_back(0.5f * i, float(event->GetEventNumber()), -1.0f * i, i);
+        }
+    }
+};
+
+struct HitAoS : public JObject {
+    float energy, x, y;
+    int cell;
+};
+
+/// The kernel which the benchmark runs both ways: energy-weighted centroid of the hits above threshold
+struct Centroid {
+    double energy = 0, x = 0, y = 0;
+};
+
+Centroid cluster(const std::vector<const HitAoS*>& hits, float threshold) {
+    Centroid c;
+    for (auto hit : hits) {
+        float e = (hit->energy > threshold) ? hit->energy : 0.0f;
+        c.energy += e;
+        c.x += e * hit->x;
+        c.y += e * hit->y;
+    }
+    return c;
+}
+
+Centroid cluster(JSpan<const float> energies, JSpan<const float> xs, JSpan<const float> ys, float threshold) {
+    Centroid c;
+    for (size_t i=0; i<energies.size(); ++i) {
+        float e = (energies[i] > threshold) ? energies[i] : 0.0f;
+        c.energy += e;
+        c.x += e * xs[i];
+        c.y += e * ys[i];
+    }
+    return c;
+}
+
+} // namespace jfactorysoatests
+
+
+TEST_CASE("JFactorySoA: Columns and row views") {
+
+    using namespace jfactorysoatests;
+    JApplication app;
+    auto factory = new HitFactory;
+    auto factories = new JFactorySet;
+    factories->Add(factory);
+    auto event = std::make_shared<JEvent>(&app);
+    event->SetFactorySet(factories);
+    event->SetEventNumber(7);
+
+    auto& hits = event->GetColumns<HitEnergy, HitX, HitY, HitCell>();
+    REQUIRE(hits.size() == 4);
+    REQUIRE(hits.Get<HitEnergy>()[2] == 1.0f);
+    REQUIRE(hits.Get<HitX>()[3] == 7.0f);
+    REQUIRE(hits.Get<HitCell>().back() == 3);
+    REQUIRE(factory->GetNumObjects() == 4);
+
+    // The JObject side sees the same rows, without running Process again
+    auto rows = event->Get<HitRow>();
+    REQUIRE(factory->process_count == 1);
+    REQUIRE(rows.size() == 4);
+    REQUIRE(rows[1]->GetIndex() == 1);
+    REQUIRE(rows[1]->Get<HitY>() == -1.0f);
+    REQUIRE(factory->GetAs<JObject>().size() == 4);
+
+    JObjectSummary summary;
+    rows[3]->Summarize(summary);
+    auto fields = summary.get_fields();
+    REQUIRE(fields.size() == 4);
+    REQUIRE(fields[0].name == "HitEnergy");
+    REQUIRE(fields[0].type == "float");
+    REQUIRE(fields[3].name == "HitCell");
+    REQUIRE(fields[3].value == "3");
+
+    // The next event reuses the same factory
+    event->GetFactorySet()->Release();
+    event->SetEventNumber(8);
+    auto& next_hits = event->GetColumns<HitEnergy, HitX, HitY, HitCell>();
+    REQUIRE(next_hits.size() == 4);
+    REQUIRE(next_hits.Get<HitX>()[0] == 8.0f);
+    REQUIRE(event->Get<HitRow>()[0]->Get<HitX>() == 8.0f);
+    REQUIRE(factory->process_count == 2);
+}
+
+TEST_CASE("JFactorySoA: Without row views") {
+
+    using namespace jfactorysoatests;
+    JApplication app;
+    auto factory = new HitFactory;
+    factory->SetRowViewsEnabled(false);
+    auto factories = new JFactorySet;
+    factories->Add(factory);
+    auto event = std::make_shared<JEvent>(&app);
+    event->SetFactorySet(factories);
+
+    REQUIRE(event->GetColumns<HitEnergy, HitX, HitY, HitCell>().size() == 4);
+    REQUIRE(event->Get<HitRow>().empty());
+    REQUIRE(factory->GetNumObjects() == 4);
+}
+
+TEST_CASE("JFactorySoA: Row views are complete as soon as the factory is Processed") {
+
+    using namespace jfactorysoatests;
+    struct ManyHitsFactory : public JFactorySoA<HitEnergy, HitX, HitY, HitCell> {
+        void Process(const std::shared_ptr<const JEvent>&) override {
+            for (int i=0; i<20000; ++i) mColumns.push_back(1.0f, 2.0f, 3.0f, i);
+        }
+    };
+    JApplication app;
+    auto factory = new ManyHitsFactory;
+    auto factories = new JFactorySet;
+    factories->Add(factory);
+    auto event = std::make_shared<JEvent>(&app);
+    event->SetFactorySet(factories);
+
+    // As with jana:parallel_factories, several threads ask for the same factory at once. Whoever doesn't run
+    // Process() must still find every row view in place.
+    for (int repetition=0; repetition<20; ++repetition) {
+        std::atomic_int incomplete {0};
+        std::vector<std::thread> threads;
+        for (int t=0; t<4; ++t) {
+            threads.emplace_back([&] {
+                auto rows = event->GetSpan<HitRow>();
+                if (rows.size() != 20000 || rows.back() == nullptr || rows.back()->Get<HitCell>() != 19999) incomplete++;
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        REQUIRE(incomplete == 0);
+        event->GetFactorySet()->Release();
+    }
+}
+
+TEST_CASE("JFactorySoA: GetColumns needs a JFactorySoA") {
+
+    using namespace jfactorysoatests;
+    JApplication app;
+    auto event = std::make_shared<JEvent>(&app);
+    REQUIRE_THROWS(event->GetColumns<HitEnergy>());
+
+    event->Insert(new JSoARow<HitEnergy>);
+    REQUIRE_THROWS(event->GetColumns<HitEnergy>());
+}
+
+TEST_CASE("JFactorySoA: Clustering kernel on AoS pointers vs SoA columns", "[.][performance]") {
+
+    using namespace jfactorysoatests;
+    const size_t hit_count = 50000;
+    const size_t repetitions = 200;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+    // Allocate the AoS hits interleaved with other allocations, like a real event would
+    std::vector<const HitAoS*> aos;
+    std::vector<std::unique_ptr<std::vector<char>>> clutter;
+    JSoA<HitEnergy, HitX, HitY, HitCell> soa;
+    for (size_t i=0; i<hit_count; ++i) {
+        auto hit = new HitAoS;
+        hit->energy = uniform(rng);
+        hit->x = uniform(rng);
+        hit->y = uniform(rng);
+        hit->cell = i;
+        aos.push_back(hit);
+        clutter.emplace_back(new std::vector<char>(64 + (i % 7) * 16));
+        soa.push_back(hit->energy, hit->x, hit->y, hit->cell);
+    }
+    std::shuffle(aos.begin(), aos.end(), rng);  // Factories rarely produce objects in allocation order
+
+    Centroid aos_result, soa_result;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r=0; r<repetitions; ++r) aos_result = cluster(aos, 0.2f);
+    auto aos_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t r=0; r<repetitions; ++r) {
+        soa_result = cluster(soa.Get<HitEnergy>(), soa.Get<HitX>(), soa.Get<HitY>(), 0.2f);
+    }
+    auto soa_time = std::chrono::steady_clock::now() - start;
+
+    REQUIRE(aos_result.energy == Approx(soa_result.energy));
+    REQUIRE(aos_result.x == Approx(soa_result.x));
+    for (auto hit : aos) delete hit;
+
+    auto per_hit = [&](std::chrono::steady_clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / double(hit_count * repetitions);
+    };
+    std::cout << "AoS pointers: " << per_hit(aos_time) << " ns per hit" << std::endl;
+    std::cout << "SoA columns:  " << per_hit(soa_time) << " ns per hit" << std::endl;
+}
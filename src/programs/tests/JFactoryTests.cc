@@ -9,6 +9,9 @@
 #include <JANA/JEvent.h>
 #include <JANA/JFactoryT.h>
 
+#include <chrono>
+#include <iostream>
+
 TEST_CASE("JFactoryTests") {
 
 
@@ -142,6 +145,69 @@ TEST_CASE("JFactoryTests") {
         REQUIRE(deleted_flag == false);
     }
 
+    SECTION("Emplaced JObjects are destroyed on ClearData and their memory is reused") {
+        JFactoryT<JFactoryTestDummyObject> sut;
+        bool deleted_flags[2] = {false, false};
+        auto first = sut.Emplace(42, &deleted_flags[0]);
+        sut.Emplace(43, &deleted_flags[1]);
+        REQUIRE(sut.GetNumObjects() == 2);
+        REQUIRE(first->data == 42);
+        REQUIRE(sut.GetArena().get_bytes_in_use() >= 2 * sizeof(JFactoryTestDummyObject));
+        auto capacity = sut.GetArena().get_capacity();
+
+        sut.ClearData();
+        REQUIRE(sut.GetNumObjects() == 0);
+        REQUIRE(deleted_flags[0] == true);
+        REQUIRE(deleted_flags[1] == true);
+        REQUIRE(sut.GetArena().get_bytes_in_use() == 0);
+
+        // Next event, same memory
+        REQUIRE(sut.Emplace(44) == first);
+        REQUIRE(sut.GetArena().get_capacity() == capacity);
+    }
+
+    SECTION("NOT_OBJECT_OWNER => Emplaced JObjects are destroyed, Inserted ones are not") {
+        JFactoryT<JFactoryTestDummyObject> sut;
+        bool emplaced_flag = false;
+        bool inserted_flag = false;
+        sut.SetFactoryFlag(JFactory::NOT_OBJECT_OWNER);
+        sut.Emplace(1, &emplaced_flag);
+        auto inserted = new JFactoryTestDummyObject(2, &inserted_flag);
+        sut.Insert(inserted);
+        sut.ClearData();
+        REQUIRE(emplaced_flag == true);
+        REQUIRE(inserted_flag == false);
+        delete inserted;
+    }
+
+    SECTION("Emplaced and Inserted JObjects may be mixed") {
+        JFactoryT<JFactoryTestDummyObject> sut;
+        bool deleted_flags[3] = {false, false, false};
+        sut.Insert(new JFactoryTestDummyObject(1, &deleted_flags[0]));
+        sut.Emplace(2, &deleted_flags[1]);
+        sut.Insert(new JFactoryTestDummyObject(3, &deleted_flags[2]));
+        sut.ClearData();
+        REQUIRE(deleted_flags[0] == true);
+        REQUIRE(deleted_flags[1] == true);
+        REQUIRE(deleted_flags[2] == true);
+    }
+
+    SECTION("PERSISTENT => Emplaced JObjects live on the heap and survive ClearData") {
+        auto event = std::make_shared<JEvent>();
+        JFactoryT<JFactoryTestDummyObject> sut;
+        bool deleted_flag = false;
+        sut.SetFactoryFlag(JFactory::PERSISTENT);
+        sut.Emplace(42, &deleted_flag);
+        sut.ClearData();
+        auto results = sut.GetOrCreate(event);
+        REQUIRE(std::distance(results.first, results.second) == 1);
+        REQUIRE(deleted_flag == false);
+        REQUIRE(sut.GetArena().get_capacity() == 0);
+        sut.ClearFactoryFlag(JFactory::PERSISTENT);
+        sut.ClearData();
+        REQUIRE(deleted_flag == true);
+    }
+
     struct Issue135Factory : public JFactoryT<JFactoryTestDummyObject> {
         void Process(const std::shared_ptr<const JEvent>&) override {
             mData.emplace_back(new JFactoryTestDummyObject(3));
@@ -172,3 +238,65 @@ TEST_CASE("JFactoryTests") {
     }
 }
 
+
+
+TEST_CASE("JArena") {
+
+    JArena arena(64);
+    REQUIRE(arena.get_capacity() == 0);
+
+    // Every allocation is aligned as asked, including ones bigger than a block
+    struct alignas(32) Wide { char bytes[32]; };
+    for (int i=0; i<10; ++i) {
+        auto small = arena.allocate(3, 1);
+        auto wide = arena.allocate(sizeof(Wide), alignof(Wide));
+        REQUIRE(small != nullptr);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(wide) % alignof(Wide) == 0);
+    }
+    auto big = arena.allocate(1000);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(big) % alignof(std::max_align_t) == 0);
+    REQUIRE(arena.get_block_count() > 1);
+    REQUIRE(arena.get_bytes_in_use() == 10 * (3 + sizeof(Wide)) + 1000);
+
+    // The blocks get merged into one, which from then on holds everything
+    auto capacity = arena.get_capacity();
+    arena.reset();
+    REQUIRE(arena.get_bytes_in_use() == 0);
+    REQUIRE(arena.get_block_count() == 1);
+    REQUIRE(arena.get_capacity() >= capacity);
+    auto first = arena.allocate(16);
+    for (int i=0; i<10; ++i) arena.allocate(sizeof(Wide), alignof(Wide));
+    arena.allocate(1000);
+    REQUIRE(arena.get_block_count() == 1);
+    arena.reset();
+    REQUIRE(arena.allocate(16) == first);
+}
+
+TEST_CASE("JFactoryT: Emplace vs new benchmark", "[.][performance]") {
+
+    const size_t events = 2000;
+    const size_t objects_per_event = 1000;
+    auto event = std::make_shared<JEvent>();
+
+    JFactoryT<JFactoryTestDummyObject> with_new;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t e=0; e<events; ++e) {
+        for (size_t i=0; i<objects_per_event; ++i) with_new.Insert(new JFactoryTestDummyObject(i));
+        with_new.ClearData();
+    }
+    auto new_time = std::chrono::steady_clock::now() - start;
+
+    JFactoryT<JFactoryTestDummyObject> with_emplace;
+    start = std::chrono::steady_clock::now();
+    for (size_t e=0; e<events; ++e) {
+        for (size_t i=0; i<objects_per_event; ++i) with_emplace.Emplace(i);
+        with_emplace.ClearData();
+    }
+    auto emplace_time = std::chrono::steady_clock::now() - start;
+
+    auto per_object = [&](std::chrono::steady_clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / double(events * objects_per_event);
+    };
+    std::cout << "new/delete: " << per_object(new_time) << " ns per object" << std::endl;
+    std::cout << "Emplace:    " << per_object(emplace_time) << " ns per object" << std::endl;
+}
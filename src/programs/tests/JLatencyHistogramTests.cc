@@ -0,0 +1,161 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "catch.hpp"
+
+#include <JANA/JApplication.h>
+#include <JANA/JEventProcessor.h>
+#include <JANA/JEventSource.h>
+#include <JANA/JFactoryGenerator.h>
+#include <JANA/JFactoryT.h>
+#include <JANA/Engine/JArrowProcessingController.h>
+#include <JANA/Utils/JLatencyHistogram.h>
+
+#include <thread>
+
+namespace jlatencyhistogramtests {
+
+struct Track : public JObject {
+    int value = 0;
+};
+struct TrackFactory : public JFactoryT<Track> {
+    TrackFactory() { SetTag("slow"); }
+    void Process(const std::shared_ptr<const JEvent>&) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        Insert(new Track);
+    }
+};
+struct TrackSource : public JEventSource {
+    TrackSource() : JEventSource("TrackSource") {}
+    void GetEvent(std::shared_ptr<JEvent>) override {}
+};
+struct TrackProcessor : public JEventProcessor {
+    std::atomic_size_t count {0};
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        count += event->Get<Track>("slow").size();
+    }
+};
+
+} // namespace jlatencyhistogramtests
+
+
+TEST_CASE("JLatencyHistogram: Buckets") {
+
+    using H = JLatencyHistogram;
+
+    // Small values get a bucket each
+    for (uint64_t ns=0; ns<H::SUB_BUCKETS; ++ns) {
+        REQUIRE(H::get_bucket_index(ns) == ns);
+        REQUIRE(H::get_bucket_max_ns(ns) == ns);
+    }
+    // Every bucket picks up right after the previous one, and is at most 1/SUB_BUCKETS of its values wide
+    for (size_t i=H::SUB_BUCKETS; i<H::BUCKET_COUNT-1; ++i) {
+        uint64_t min_ns = H::get_bucket_max_ns(i-1) + 1;
+        uint64_t max_ns = H::get_bucket_max_ns(i);
+        REQUIRE(H::get_bucket_index(min_ns) == i);
+        REQUIRE(H::get_bucket_index(max_ns) == i);
+        REQUIRE((max_ns - min_ns + 1) * H::SUB_BUCKETS <= min_ns);
+    }
+    // Everything else shares the last bucket
+    REQUIRE(H::get_bucket_index(UINT64_MAX) == H::BUCKET_COUNT-1);
+    REQUIRE(H::get_bucket_index(H::get_bucket_max_ns(H::BUCKET_COUNT-2) + 1) == H::BUCKET_COUNT-1);
+}
+
+TEST_CASE("JLatencyHistogram: Percentiles") {
+
+    using std::chrono::microseconds;
+    JLatencyHistogram histogram;
+    REQUIRE(histogram.get_snapshot().get_count() == 0);
+    REQUIRE(histogram.get_snapshot().get_percentile(0.99) == JLatencyHistogram::duration_t::zero());
+
+    // 990 fast events and 10 slow ones
+    for (int i=0; i<990; ++i) histogram.record(microseconds(100));
+    for (int i=0; i<10; ++i) histogram.record(microseconds(5000));
+
+    auto snapshot = histogram.get_snapshot();
+    REQUIRE(snapshot.get_count() == 1000);
+    REQUIRE(snapshot.get_max() == microseconds(5000));
+
+    // Within one bucket of the true value, and never below it
+    auto p50 = snapshot.get_percentile(0.5);
+    REQUIRE(p50 >= microseconds(100));
+    REQUIRE(p50 <= microseconds(113));
+    REQUIRE(snapshot.get_percentile(0.99) <= microseconds(113));
+    REQUIRE(snapshot.get_percentile(0.999) == microseconds(5000));
+    REQUIRE(snapshot.get_percentile(1.0) == microseconds(5000));
+}
+
+TEST_CASE("JLatencyHistogram: Merging and recording from many threads") {
+
+    using std::chrono::microseconds;
+    JLatencyHistogram first, second;
+    std::vector<std::thread> threads;
+    for (int t=0; t<4; ++t) {
+        threads.emplace_back([&] {
+            for (int i=0; i<10000; ++i) first.record(microseconds(10));
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    second.record(microseconds(900));
+    REQUIRE(first.get_snapshot().get_count() == 40000);
+
+    first.merge(second);
+    auto snapshot = first.get_snapshot();
+    REQUIRE(snapshot.get_count() == 40001);
+    REQUIRE(snapshot.get_max() == microseconds(900));
+
+    auto combined = second.get_snapshot();
+    combined.merge(snapshot);
+    REQUIRE(combined.get_count() == 40002);
+    REQUIRE(combined.get_percentile(0.5) >= microseconds(10));
+    REQUIRE(combined.get_percentile(0.5) <= microseconds(11));
+}
+
+TEST_CASE("JLatencyHistogram: Arrows and factories report their percentiles") {
+
+    using namespace jlatencyhistogramtests;
+    JApplication app;
+    app.SetTicker(false);
+    auto processor = new TrackProcessor;
+    app.Add(new TrackSource);
+    app.Add(processor);
+    app.Add(new JFactoryGeneratorT<TrackFactory>);
+    app.SetParameterValue("nthreads", 2);
+    app.SetParameterValue("jana:nevents", 50);
+    app.Run(true);
+    REQUIRE(processor->count == 50);
+
+    auto perf = app.GetService<JArrowProcessingController>()->measure_internal_performance();
+    REQUIRE(!perf->arrow_latencies.empty());
+    size_t arrow_events = 0;
+    for (auto& latency : perf->arrow_latencies) {
+        arrow_events += latency.count;
+        REQUIRE(latency.p50_ms <= latency.p99_ms);
+        REQUIRE(latency.p99_ms <= latency.p999_ms);
+        REQUIRE(latency.p999_ms <= latency.max_ms);
+    }
+    REQUIRE(arrow_events >= 100);  // Every event went through the source and the processors
+
+    auto factory = std::find_if(perf->factory_latencies.begin(), perf->factory_latencies.end(),
+                                [](const LatencySummary& s) { return s.name == "jlatencyhistogramtests::Track:slow"; });
+    REQUIRE(factory != perf->factory_latencies.end());
+    REQUIRE(factory->count == 50);
+    REQUIRE(factory->p50_ms >= 2.0);
+    REQUIRE(factory->max_ms >= factory->p99_ms);
+}
+
+TEST_CASE("JLatencyHistogram: Factory latency recording can be turned off") {
+
+    using namespace jlatencyhistogramtests;
+    JApplication app;
+    app.SetTicker(false);
+    app.Add(new TrackSource);
+    app.Add(new TrackProcessor);
+    app.Add(new JFactoryGeneratorT<TrackFactory>);
+    app.SetParameterValue("jana:nevents", 5);
+    app.SetParameterValue("jana:record_factory_latency", false);
+    app.Run(true);
+
+    auto perf = app.GetService<JArrowProcessingController>()->measure_internal_performance();
+    REQUIRE(perf->factory_latencies.empty());
+}
@@ -5,6 +5,13 @@
 #include "catch.hpp"
 
 #include <JANA/JObject.h>
+#include <JANA/JAssociationTable.h>
+#include <JANA/JEvent.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <set>
 
 class SillyObject : public JObject {
 public:
@@ -17,3 +24,215 @@ TEST_CASE("JObject::className") {
     REQUIRE(sut.className() == "SillyObject");
 }
 
+
+namespace jobjecttests {
+
+struct Hit : public JObject {
+    JOBJECT_PUBLIC(Hit)
+};
+
+struct Cluster : public JObject {
+    JOBJECT_PUBLIC(Cluster)
+};
+
+struct Track : public JObject {
+    JOBJECT_PUBLIC(Track)
+};
+
+struct Deletable : public JObject {
+    JOBJECT_PUBLIC(Deletable)
+    static int deleted;
+    ~Deletable() override { deleted++; }
+};
+int Deletable::deleted = 0;
+
+} // namespace jobjecttests
+
+
+TEST_CASE("JObject associations") {
+
+    using namespace jobjecttests;
+    Cluster cluster;
+    std::vector<Hit> hits(10);
+
+    SECTION("Adding the same object twice keeps it once") {
+        cluster.AddAssociatedObject(&hits[0]);
+        cluster.AddAssociatedObject(&hits[0]);
+        REQUIRE(cluster.Get<Hit>().size() == 1);
+        REQUIRE(cluster.IsAssociated(&hits[0]));
+        REQUIRE(!cluster.IsAssociated(&hits[1]));
+    }
+
+    SECTION("Objects come back in address order, whether inline or not") {
+        for (int i=9; i>=0; --i) {
+            cluster.AddAssociatedObject(&hits[i]);
+            auto results = cluster.Get<Hit>();
+            REQUIRE(results.size() == size_t(10-i));
+            REQUIRE(std::is_sorted(results.begin(), results.end()));
+        }
+        std::vector<const Hit*> expected;
+        for (auto& hit : hits) expected.push_back(&hit);
+        REQUIRE(cluster.Get<Hit>() == expected);
+        std::vector<const Hit*> found;
+        cluster.GetT(found);
+        REQUIRE(found == expected);
+    }
+
+    SECTION("Removing and clearing") {
+        for (auto& hit : hits) cluster.AddAssociatedObject(&hit);
+        cluster.RemoveAssociatedObject(&hits[4]);
+        cluster.RemoveAssociatedObject(&hits[4]);
+        REQUIRE(cluster.Get<Hit>().size() == 9);
+        REQUIRE(!cluster.IsAssociated(&hits[4]));
+        REQUIRE(cluster.IsAssociated(&hits[5]));
+        cluster.ClearAssociatedObjects();
+        REQUIRE(cluster.Get<Hit>().empty());
+        cluster.AddAssociatedObject(&hits[2]);
+        REQUIRE(cluster.GetSingle<Hit>() == &hits[2]);
+    }
+
+    SECTION("Copies and moves keep the associations") {
+        for (auto& hit : hits) cluster.AddAssociatedObject(&hit);
+        Track track;
+        track.AddAssociatedObject(&hits[0]);
+        Cluster copy = cluster;
+        REQUIRE(copy.Get<Hit>() == cluster.Get<Hit>());
+        Cluster moved = std::move(copy);
+        REQUIRE(moved.Get<Hit>() == cluster.Get<Hit>());
+        moved = Cluster();
+        REQUIRE(moved.Get<Hit>().empty());
+        Track track_copy;
+        track_copy = track;
+        REQUIRE(track_copy.GetSingle<Hit>() == &hits[0]);
+    }
+
+    SECTION("Auto-deleted objects are deleted by ClearAssociatedObjects, even after being removed") {
+        Deletable::deleted = 0;
+        auto first = new Deletable;
+        auto second = new Deletable;
+        cluster.AddAssociatedObjectAutoDelete(first);
+        cluster.AddAssociatedObjectAutoDelete(first);
+        cluster.AddAssociatedObjectAutoDelete(second);
+        cluster.RemoveAssociatedObject(second);
+        REQUIRE(cluster.Get<Deletable>().size() == 1);
+        cluster.ClearAssociatedObjects();
+        REQUIRE(Deletable::deleted == 2);
+    }
+}
+
+TEST_CASE("JObject::Get with max_depth matches GetAssociatedAncestors") {
+
+    using namespace jobjecttests;
+    std::vector<Hit> hits(20);
+    std::vector<Cluster> clusters(5);
+    std::vector<Track> tracks(2);
+    for (size_t i=0; i<hits.size(); ++i) {
+        clusters[i % clusters.size()].AddAssociatedObject(&hits[i]);
+        hits[i].AddAssociatedObject(&clusters[i % clusters.size()]);  // Cycles must not matter
+    }
+    for (size_t i=0; i<clusters.size(); ++i) tracks[i % 2].AddAssociatedObject(&clusters[i]);
+    tracks[0].AddAssociatedObject(&tracks[1]);
+
+    for (int depth : {0, 1, 2, 3, 1000000}) {
+        std::vector<const Hit*> found;
+        tracks[0].Get(found, "", depth);
+
+        std::set<const JObject*> already_checked;
+        std::set<const Hit*> expected;
+        int max_depth = depth;
+        tracks[0].GetAssociatedAncestors(already_checked, max_depth, expected);
+        REQUIRE(found == std::vector<const Hit*>(expected.begin(), expected.end()));
+        REQUIRE(max_depth == depth);
+    }
+    std::vector<const Hit*> all;
+    tracks[0].Get(all);
+    REQUIRE(all.size() == 20);
+    std::vector<const Cluster*> direct;
+    tracks[0].Get(direct, "", 1);
+    REQUIRE(direct.size() == 3);
+}
+
+TEST_CASE("JAssociationTable") {
+
+    using namespace jobjecttests;
+    JAssociationTable table;
+    std::vector<Hit> hits(10);
+    Cluster cluster, other;
+    Track track;
+
+    for (int i=9; i>=0; --i) table.Add(&cluster, &hits[i]);
+    table.Add(&cluster, &hits[3]);
+    table.Add(&other, &hits[0]);
+    table.Add(&track, &cluster);
+
+    auto found = table.Get<Hit>(&cluster);
+    std::vector<const Hit*> expected;
+    for (auto& hit : hits) expected.push_back(&hit);
+    REQUIRE(found == expected);
+    REQUIRE(table.size() == 12);
+    REQUIRE(table.Get<Hit>(&track).empty());
+    REQUIRE(table.GetSingle<Cluster>(&track) == &cluster);
+    REQUIRE(table.GetSingle<Hit>(&other) == &hits[0]);
+    REQUIRE_THROWS(table.GetSingle<Hit>(&cluster));
+    REQUIRE(table.IsAssociated(&cluster, &hits[5]));
+    REQUIRE(!table.IsAssociated(&hits[5], &cluster));
+
+    table.Remove(&cluster, &hits[5]);
+    REQUIRE(!table.IsAssociated(&cluster, &hits[5]));
+    REQUIRE(table.Get<Hit>(&cluster).size() == 9);
+
+    table.Clear();
+    REQUIRE(table.size() == 0);
+    REQUIRE(table.Get<Hit>(&cluster).empty());
+
+    std::vector<Hit*> members {&hits[7], &hits[1], &hits[7]};
+    table.Add(&other, members);
+    REQUIRE(table.Get<Hit>(&other) == std::vector<const Hit*>({&hits[1], &hits[7]}));
+
+    JEvent event;
+    event.GetAssociations().Add(&track, &cluster);
+    REQUIRE(event.GetAssociations().GetSingle<Cluster>(&track) == &cluster);
+}
+
+TEST_CASE("JObject associations benchmark", "[.][performance]") {
+
+    using namespace jobjecttests;
+    const size_t events = 200;
+    const size_t hits_per_event = 20000;
+    const size_t hits_per_cluster = 8;
+    std::vector<Hit> hits(hits_per_event);
+    std::vector<Cluster> clusters(hits_per_event / hits_per_cluster);
+    size_t found = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t e=0; e<events; ++e) {
+        for (size_t i=0; i<hits_per_event; ++i) {
+            clusters[i / hits_per_cluster].AddAssociatedObject(&hits[i]);
+            hits[i].AddAssociatedObject(&clusters[i / hits_per_cluster]);
+        }
+        for (auto& cluster : clusters) found += cluster.Get<Hit>().size();
+        for (auto& hit : hits) hit.ClearAssociatedObjects();
+        for (auto& cluster : clusters) cluster.ClearAssociatedObjects();
+    }
+    auto object_time = std::chrono::steady_clock::now() - start;
+
+    JAssociationTable table;
+    start = std::chrono::steady_clock::now();
+    for (size_t e=0; e<events; ++e) {
+        for (size_t i=0; i<hits_per_event; ++i) {
+            table.Add(&clusters[i / hits_per_cluster], &hits[i]);
+            table.Add(&hits[i], &clusters[i / hits_per_cluster]);
+        }
+        for (auto& cluster : clusters) found += table.Get<Hit>(&cluster).size();
+        table.Clear();
+    }
+    auto table_time = std::chrono::steady_clock::now() - start;
+
+    REQUIRE(found == 2 * events * hits_per_event);
+    auto per_hit = [&](std::chrono::steady_clock::duration d) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count() / double(events * hits_per_event);
+    };
+    std::cout << "sizeof(JObject):    " << sizeof(JObject) << " bytes" << std::endl;
+    std::cout << "JObject:            " << per_hit(object_time) << " ns per hit" << std::endl;
+    std::cout << "JAssociationTable:  " << per_hit(table_time) << " ns per hit" << std::endl;
+}
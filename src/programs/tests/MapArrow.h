@@ -85,6 +85,13 @@ public:
     size_t get_threshold() final { return _input_queue->get_threshold(); }
 
     void set_threshold(size_t threshold) final { _input_queue->set_threshold(threshold); }
+
+    bool park(duration_t timeout, size_t location_id) final {
+        _input_queue->wait_for_push(location_id, timeout);
+        return true;
+    }
+
+    void unpark() final { _input_queue->wake_all(); }
 };
 
 
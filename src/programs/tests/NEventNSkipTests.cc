@@ -89,6 +89,10 @@ TEST_CASE("JEventSourceArrow with multiple JEventSources") {
     app.Add(source2);
     app.Add(source3);
 
+    // Reading the sources one after another or all at once must not change what each of them emits
+    auto concurrent_sources = GENERATE(false, true);
+    app.SetParameterValue("jana:concurrent_sources", concurrent_sources);
+
     SECTION("All three event sources initialize, run, and finish") {
         source1->event_bound = 9;
         source2->event_bound = 13;
@@ -0,0 +1,287 @@
+// Copyright 2023, Jefferson Science Associates, LLC.
+// Subject to the terms in the LICENSE file found in the top-level directory.
+
+#include "catch.hpp"
+
+#include <JANA/JApplication.h>
+#include <JANA/JEventProcessor.h>
+#include <JANA/JEventSource.h>
+#include <JANA/JFactoryGenerator.h>
+#include <JANA/JFactoryT.h>
+#include <JANA/JMultifactory.h>
+#include <JANA/Engine/JTopologyBuilder.h>
+
+#include <thread>
+
+namespace parallelfactoriestests {
+
+// A diamond: Hit <- ClusterA, ClusterB <- Track. Vertex stands alone.
+struct Hit : public JObject { int value = 0; };
+struct ClusterA : public JObject { int value = 0; };
+struct ClusterB : public JObject { int value = 0; };
+struct Track : public JObject { int value = 0; };
+struct Vertex : public JObject { int value = 0; };
+
+struct HitFactory : public JFactoryT<Hit> {
+    std::atomic_int process_count {0};
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        process_count++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        auto hit = new Hit;
+        hit->value = event->GetEventNumber();
+        Insert(hit);
+    }
+};
+struct ClusterAFactory : public JFactoryT<ClusterA> {
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        auto cluster = new ClusterA;
+        cluster->value = event->GetSingle<Hit>()->value + 1;
+        Insert(cluster);
+    }
+};
+struct ClusterBFactory : public JFactoryT<ClusterB> {
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        auto cluster = new ClusterB;
+        cluster->value = event->GetSingle<Hit>()->value + 2;
+        Insert(cluster);
+    }
+};
+struct TrackFactory : public JFactoryT<Track> {
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        auto track = new Track;
+        track->value = event->GetSingle<ClusterA>()->value + event->GetSingle<ClusterB>()->value;
+        Insert(track);
+    }
+};
+struct VertexFactory : public JFactoryT<Vertex> {
+    bool fail = false;
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        if (fail && event->GetEventNumber() == 30) throw JException("Vertex fit exploded");
+        auto vertex = new Vertex;
+        vertex->value = -1;
+        Insert(vertex);
+    }
+};
+
+struct FailingVertexFactory : public VertexFactory {
+    FailingVertexFactory() { fail = true; }
+};
+
+struct Source : public JEventSource {
+    Source() : JEventSource("Source") {}
+    void GetEvent(std::shared_ptr<JEvent>) override {}
+};
+
+struct Processor : public JEventProcessor {
+    std::atomic_size_t count {0};
+    std::atomic_size_t wrong {0};
+    Processor() {
+        DeclarePrefetch<Track>();
+        DeclarePrefetch<Vertex>();
+    }
+    void Process(const std::shared_ptr<const JEvent>& event) override {
+        int expected = 2 * event->GetEventNumber() + 3;
+        if (event->GetSingle<Track>()->value != expected) wrong++;
+        if (event->GetSingle<Vertex>()->value != -1) wrong++;
+        count++;
+    }
+};
+
+struct SlowFactory : public JFactoryT<Hit> {
+    std::atomic_int process_count {0};
+    void Process(const std::shared_ptr<const JEvent>&) override {
+        process_count++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        Insert(new Hit);
+    }
+};
+
+struct ManyHitsFactory : public JFactoryT<Hit> {
+    std::atomic_int inserted {0};
+    void Process(const std::shared_ptr<const JEvent>&) override {
+        for (int i=0; i<50; ++i) {
+            Insert(new Hit);
+            inserted++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+struct Multifactory : public JMultifactory {
+    int process_count = 0;  // Execute() serializes us
+    Multifactory() {
+        DeclareOutput<ClusterA>("a");
+        DeclareOutput<ClusterB>("b");
+    }
+    void Process(const std::shared_ptr<const JEvent>&) override {
+        process_count++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        SetData<ClusterA>("a", {new ClusterA});
+        SetData<ClusterB>("b", {new ClusterB});
+    }
+};
+
+JFactoryTaskGraph* find_task_graph(JApplication& app) {
+    for (auto arrow : app.GetService<JTopologyBuilder>()->get()->arrows) {
+        auto proc_arrow = dynamic_cast<JEventProcessorArrow*>(arrow);
+        if (proc_arrow != nullptr) return proc_arrow->get_factory_task_graph();
+    }
+    return nullptr;
+}
+
+} // namespace parallelfactoriestests
+
+
+TEST_CASE("ParallelFactories: Plan is learned from the call graph") {
+
+    using namespace parallelfactoriestests;
+    JApplication app;
+    app.SetTicker(false);
+    auto processor = new Processor;
+    app.Add(new Source);
+    app.Add(processor);
+    app.Add(new JFactoryGeneratorT<HitFactory>);
+    app.Add(new JFactoryGeneratorT<ClusterAFactory>);
+    app.Add(new JFactoryGeneratorT<ClusterBFactory>);
+    app.Add(new JFactoryGeneratorT<TrackFactory>);
+    app.Add(new JFactoryGeneratorT<VertexFactory>);
+    app.SetParameterValue("nthreads", 4);
+    app.SetParameterValue("jana:nevents", 60);
+    app.SetParameterValue("jana:parallel_factories", true);
+    app.SetParameterValue("jana:parallel_factories_learning_events", 5);
+    app.Run(true);
+
+    REQUIRE(processor->count == 60);
+    REQUIRE(processor->wrong == 0);
+
+    auto graph = find_task_graph(app);
+    REQUIRE(graph != nullptr);
+    REQUIRE(graph->get_roots().size() == 2);
+    REQUIRE(graph->get_parallel_event_count() > 0);
+
+    auto plan = graph->get_plan();
+    REQUIRE(plan.size() == 5);
+    std::map<std::string, size_t> indices;
+    for (size_t i=0; i<plan.size(); ++i) indices[plan[i].name.first] = i;
+
+    auto& hit = plan[indices.at("parallelfactoriestests::Hit")];
+    auto& cluster_a = plan[indices.at("parallelfactoriestests::ClusterA")];
+    auto& track = plan[indices.at("parallelfactoriestests::Track")];
+    auto& vertex = plan[indices.at("parallelfactoriestests::Vertex")];
+    REQUIRE(hit.dependency_count == 0);
+    REQUIRE(hit.dependents.size() == 2);
+    REQUIRE(cluster_a.dependency_count == 1);
+    REQUIRE(track.dependency_count == 2);
+    REQUIRE(track.dependents.empty());
+    REQUIRE(vertex.dependency_count == 0);
+    REQUIRE(vertex.dependents.empty());
+
+    // Dependencies come first
+    REQUIRE(indices.at("parallelfactoriestests::Hit") < indices.at("parallelfactoriestests::ClusterB"));
+    REQUIRE(indices.at("parallelfactoriestests::ClusterB") < indices.at("parallelfactoriestests::Track"));
+}
+
+TEST_CASE("ParallelFactories: Exceptions from factory tasks reach the application") {
+
+    using namespace parallelfactoriestests;
+    JApplication app;
+    app.SetTicker(false);
+    app.Add(new Source);
+    app.Add(new Processor);
+    app.Add(new JFactoryGeneratorT<HitFactory>);
+    app.Add(new JFactoryGeneratorT<ClusterAFactory>);
+    app.Add(new JFactoryGeneratorT<ClusterBFactory>);
+    app.Add(new JFactoryGeneratorT<TrackFactory>);
+    app.Add(new JFactoryGeneratorT<FailingVertexFactory>);
+    app.SetParameterValue("nthreads", 2);
+    app.SetParameterValue("jana:nevents", 100);
+    app.SetParameterValue("jana:parallel_factories", true);
+    app.SetParameterValue("jana:parallel_factories_learning_events", 2);
+    REQUIRE_THROWS(app.Run(true));
+    REQUIRE(find_task_graph(app)->get_parallel_event_count() > 0);
+}
+
+TEST_CASE("ParallelFactories: Concurrent Create runs Process once") {
+
+    using namespace parallelfactoriestests;
+    JApplication app;
+    auto factory = new SlowFactory;
+    auto factories = new JFactorySet;
+    factories->Add(factory);
+    auto event = std::make_shared<JEvent>(&app);
+    event->SetFactorySet(factories);
+
+    std::atomic_size_t total {0};
+    std::vector<std::thread> threads;
+    for (int i=0; i<4; ++i) {
+        threads.emplace_back([&] { total += event->Get<Hit>().size(); });
+    }
+    for (auto& thread : threads) thread.join();
+    REQUIRE(factory->process_count == 1);
+    REQUIRE(total == 4);
+}
+
+TEST_CASE("ParallelFactories: Readers wait for a Process() which has already inserted") {
+
+    using namespace parallelfactoriestests;
+    JApplication app;
+    auto factory = new ManyHitsFactory;
+    auto factories = new JFactorySet;
+    factories->Add(factory);
+    auto event = std::make_shared<JEvent>(&app);
+    event->SetFactorySet(factories);
+
+    size_t creator_count = 0;
+    std::thread creator([&] { creator_count = event->Get<Hit>().size(); });
+    while (factory->inserted == 0) std::this_thread::yield();
+    // The factory's status already says Inserted, but Process() is still going
+    size_t reader_count = event->Get<Hit>().size();
+    creator.join();
+    REQUIRE(factory->inserted == 50);
+    REQUIRE(creator_count == 50);
+    REQUIRE(reader_count == 50);
+    REQUIRE(factory->GetStatus() == JFactory::Status::Processed);
+}
+
+TEST_CASE("ParallelFactories: Multifactory helpers may be created concurrently") {
+
+    using namespace parallelfactoriestests;
+    JApplication app;
+    auto multifactory = new Multifactory;
+    auto factories = new JFactorySet;
+    factories->Add(multifactory);
+    auto event = std::make_shared<JEvent>(&app);
+    event->SetFactorySet(factories);
+
+    size_t a_count = 0, b_count = 0;
+    std::thread a([&] { a_count = event->Get<ClusterA>("a").size(); });
+    std::thread b([&] { b_count = event->Get<ClusterB>("b").size(); });
+    a.join();
+    b.join();
+    REQUIRE(multifactory->process_count == 1);
+    REQUIRE(a_count == 1);
+    REQUIRE(b_count == 1);
+}
+
+TEST_CASE("ParallelFactories: Task pool") {
+
+    JFactoryTaskPool pool;
+    size_t woken = 0;
+    pool.set_wake_callback([&] { woken++; });
+    REQUIRE(!pool.run_one());
+
+    std::atomic_int done {0};
+    std::vector<JFactoryTaskPool::Task> tasks;
+    for (int i=0; i<10; ++i) tasks.push_back([&] { if (++done == 10) pool.notify_all(); });
+    pool.submit(tasks);
+    REQUIRE(tasks.empty());
+    REQUIRE(woken == 1);
+    REQUIRE(pool.get_pending() == 10);
+
+    std::thread helper([&] { pool.run_until([&] { return done == 10; }); });
+    pool.run_until([&] { return done == 10; });
+    helper.join();
+    REQUIRE(done == 10);
+    REQUIRE(pool.get_pending() == 0);
+    REQUIRE(pool.get_tasks_run() == 10);
+}
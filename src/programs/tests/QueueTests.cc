@@ -6,6 +6,10 @@
 
 #include "catch.hpp"
 
+#include <algorithm>
+#include <iomanip>
+#include <thread>
+
 
 TEST_CASE("Queue: Basic functionality") {
     JMailbox<int> q;
@@ -33,3 +37,285 @@ TEST_CASE("Queue: Basic functionality") {
     REQUIRE(result == JMailbox<int>::Status::Ready);
 
 }
+
+TEST_CASE("Queue: RingBuffer backend matches Deque backend") {
+
+    auto backend = GENERATE(JMailboxBackend::Deque, JMailboxBackend::RingBuffer);
+    JMailbox<int> q(4, 1, false, backend);
+    REQUIRE(q.get_backend() == backend);
+    REQUIRE(q.size() == 0);
+
+    SECTION("Reservations are bounded by the threshold") {
+        REQUIRE(q.reserve(3) == 3);
+        REQUIRE(q.reserve(3) == 1);
+        REQUIRE(q.reserve(3) == 0);
+
+        std::vector<int> buffer {1,2,3};
+        REQUIRE(q.push(buffer, 3) == JMailbox<int>::Status::Ready);
+        REQUIRE(buffer.empty());
+        REQUIRE(q.size() == 3);
+
+        // One slot is still reserved, so nothing else is available
+        REQUIRE(q.reserve(3) == 0);
+        int item = 4;
+        q.push(item, 1);
+        REQUIRE(q.size() == 4);
+        REQUIRE(q.reserve(1) == 0);
+    }
+
+    SECTION("Pops report Ready, Empty") {
+        std::vector<int> buffer {1,2,3};
+        q.push(buffer);
+
+        std::vector<int> items;
+        REQUIRE(q.pop(items, 2) == JMailbox<int>::Status::Ready);
+        REQUIRE(items == std::vector<int>{1,2});
+
+        int item = 0;
+        bool success = false;
+        REQUIRE(q.pop(item, success) == JMailbox<int>::Status::Empty);
+        REQUIRE(success);
+        REQUIRE(item == 3);
+
+        REQUIRE(q.pop(item, success) == JMailbox<int>::Status::Empty);
+        REQUIRE(!success);
+    }
+
+    SECTION("Unreserved pushes beyond the threshold never fail") {
+        std::vector<int> buffer;
+        for (int i=0; i<20; ++i) buffer.push_back(i);
+        REQUIRE(q.push(buffer) == JMailbox<int>::Status::Full);
+        REQUIRE(q.size() == 20);
+        REQUIRE(q.reserve(1) == 0);
+
+        std::vector<int> items;
+        REQUIRE(q.pop(items, 100) == JMailbox<int>::Status::Empty);
+        REQUIRE(items.size() == 20);
+        std::sort(items.begin(), items.end());
+        for (int i=0; i<20; ++i) REQUIRE(items[i] == i);
+        REQUIRE(q.reserve(1) == 1);
+    }
+}
+
+TEST_CASE("Queue: RingBuffer backend delivers every item exactly once under contention") {
+
+    const size_t nthreads = 4;
+    const size_t items_per_thread = 10000;
+    JMailbox<size_t> q(64, 1, false, JMailboxBackend::RingBuffer);
+    std::atomic<size_t> popped_sum {0};
+    std::atomic<size_t> popped_count {0};
+
+    std::vector<std::thread> threads;
+    for (size_t t=0; t<nthreads; ++t) {
+        threads.emplace_back([&, t](){
+            std::vector<size_t> buffer;
+            size_t next = t * items_per_thread;
+            size_t end = next + items_per_thread;
+            while (next < end || popped_count < nthreads * items_per_thread) {
+                if (next < end) {
+                    auto reserved = q.reserve(8);
+                    for (size_t i=0; i<reserved && next<end; ++i) buffer.push_back(next++);
+                    q.push(buffer, reserved);
+                }
+                std::vector<size_t> items;
+                q.pop(items, 8);
+                for (auto x : items) popped_sum += x;
+                popped_count += items.size();
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    size_t n = nthreads * items_per_thread;
+    REQUIRE(popped_count == n);
+    REQUIRE(popped_sum == n*(n-1)/2);
+    REQUIRE(q.size() == 0);
+}
+
+TEST_CASE("Queue: Byte budget") {
+
+    for (auto backend : {JMailboxBackend::Deque, JMailboxBackend::RingBuffer}) {
+        JMailbox<int> q(1000, 1, false, backend);
+        q.set_byte_budget(10, [](const int& item) { return static_cast<size_t>(item); });
+
+        int item = 6;
+        q.push(item);
+        REQUIRE(q.get_bytes() == 6);
+        REQUIRE(q.reserve(1) == 1);
+        std::vector<int> buffer {2, 3};
+        q.push(buffer, 1);
+        REQUIRE(q.get_bytes() == 11);
+        REQUIRE(q.reserve(1) == 0);
+
+        std::vector<int> items;
+        q.pop(items, 1);
+        REQUIRE(q.get_bytes() == 5);
+        REQUIRE(q.reserve(1) == 1);
+        q.push(items, 1);
+        REQUIRE(q.get_bytes() == 11);
+
+        int popped;
+        bool success = true;
+        while (success) q.pop(popped, success);
+        REQUIRE(q.size() == 0);
+        REQUIRE(q.get_bytes() == 0);
+    }
+}
+
+TEST_CASE("Queue: Work stealing") {
+
+    auto backend = GENERATE(JMailboxBackend::Deque, JMailboxBackend::RingBuffer);
+
+    SECTION("Without stealing, an empty location stays empty") {
+        JMailbox<int> q(10, 3, false, backend);
+        std::vector<int> buffer {1,2,3};
+        q.push(buffer, 0, 2);
+
+        std::vector<int> items;
+        size_t stolen_count = 22;
+        REQUIRE(q.pop(items, 10, 0, stolen_count) == JMailbox<int>::Status::Empty);
+        REQUIRE(items.empty());
+        REQUIRE(stolen_count == 0);
+        REQUIRE(q.size(2) == 3);
+    }
+
+    SECTION("With stealing, an empty location takes from its victims in steal order") {
+        JMailbox<int> q(10, 3, true, backend);
+        REQUIRE(q.get_steal_order(0) == std::vector<size_t>{1,2});
+        REQUIRE(q.get_steal_order(2) == std::vector<size_t>{0,1});
+
+        std::vector<int> far {1,2,3};
+        std::vector<int> near {4};
+        q.push(far, 0, 1);
+        q.push(near, 0, 2);
+        q.set_steal_order(0, {2,1});
+
+        std::vector<int> items;
+        size_t stolen_count = 0;
+        REQUIRE(q.pop(items, 10, 0, stolen_count) == JMailbox<int>::Status::Empty);
+        REQUIRE(items == std::vector<int>{4});
+        REQUIRE(stolen_count == 1);
+
+        int item = 0;
+        bool success = false;
+        REQUIRE(q.pop(item, success, 0, stolen_count) == JMailbox<int>::Status::Ready);
+        REQUIRE(success);
+        REQUIRE(item == 1);
+        REQUIRE(stolen_count == 1);
+        REQUIRE(q.size() == 2);
+    }
+
+    SECTION("With stealing, a nonempty location doesn't steal") {
+        JMailbox<int> q(10, 2, true, backend);
+        std::vector<int> local {1};
+        std::vector<int> remote {2,3};
+        q.push(local, 0, 0);
+        q.push(remote, 0, 1);
+
+        std::vector<int> items;
+        size_t stolen_count = 22;
+        q.pop(items, 10, 0, stolen_count);
+        REQUIRE(items == std::vector<int>{1});
+        REQUIRE(stolen_count == 0);
+    }
+}
+
+TEST_CASE("Queue: Parking") {
+
+    auto backend = GENERATE(JMailboxBackend::Deque, JMailboxBackend::RingBuffer);
+    JMailbox<int> q(10, 2, false, backend);
+    using clock_t = std::chrono::steady_clock;
+
+    SECTION("wait_for_push returns immediately when items are available") {
+        int item = 1;
+        q.push(item, 0, 0);
+        auto start = clock_t::now();
+        REQUIRE(q.wait_for_push(0, std::chrono::seconds(10)) == true);
+        REQUIRE(clock_t::now() - start < std::chrono::seconds(5));
+    }
+
+    SECTION("wait_for_push times out when nothing is pushed") {
+        // Items at another location don't count unless work stealing is enabled
+        int item = 1;
+        q.push(item, 0, 1);
+        REQUIRE(q.wait_for_push(0, std::chrono::milliseconds(10)) == false);
+        REQUIRE(q.get_parked_count() == 0);
+    }
+
+    SECTION("push() wakes a parked thread") {
+        bool woken = false;
+        auto start = clock_t::now();
+        std::thread parked([&]{ woken = q.wait_for_push(0, std::chrono::seconds(10)); });
+        while (q.get_parked_count() == 0) std::this_thread::yield();
+        int item = 1;
+        q.push(item, 0, 0);
+        parked.join();
+        REQUIRE(woken == true);
+        REQUIRE(clock_t::now() - start < std::chrono::seconds(5));
+    }
+
+    SECTION("wake_all() wakes every parked thread") {
+        std::atomic_int woken_count {0};
+        std::vector<std::thread> threads;
+        for (int i=0; i<4; ++i) {
+            threads.emplace_back([&]{ if (q.wait_for_push(0, std::chrono::seconds(10))) woken_count++; });
+        }
+        while (q.get_parked_count() < 4) std::this_thread::yield();
+        q.wake_all();
+        for (auto& t : threads) t.join();
+        REQUIRE(woken_count == 4);
+    }
+}
+
+
+TEST_CASE("Queue: Contention benchmark", "[.][performance]") {
+
+    // Every thread behaves like a worker alternating between a source arrow (reserve+push)
+    // and a sink arrow (pop). We report completed pops per second as well as how many pops came back Congested.
+    // Thread counts beyond the number of cores are oversubscribed, which penalizes any lock-free structure
+    // because a thread can be preempted halfway through claiming a cell.
+    const auto duration = std::chrono::milliseconds(500);
+    std::cout << "backend      threads    pops/s          congested/s" << std::endl;
+
+    for (auto backend : {JMailboxBackend::Deque, JMailboxBackend::RingBuffer}) {
+        for (size_t nthreads=1; nthreads<=64; nthreads*=2) {
+
+            JMailbox<std::shared_ptr<int>> q(80, 1, false, backend);
+            std::atomic_bool stop {false};
+            std::atomic<size_t> total_pops {0};
+            std::atomic<size_t> total_congested {0};
+
+            std::vector<std::thread> threads;
+            for (size_t t=0; t<nthreads; ++t) {
+                threads.emplace_back([&](){
+                    std::vector<std::shared_ptr<int>> buffer;
+                    size_t pops = 0, congested = 0;
+                    while (!stop) {
+                        auto reserved = q.reserve(4);
+                        for (size_t i=0; i<reserved; ++i) buffer.push_back(std::make_shared<int>(22));
+                        q.push(buffer, reserved);
+
+                        std::shared_ptr<int> item;
+                        bool success;
+                        for (size_t i=0; i<4; ++i) {
+                            auto status = q.pop(item, success);
+                            if (success) pops++;
+                            if (status == JMailbox<std::shared_ptr<int>>::Status::Congested) congested++;
+                        }
+                    }
+                    total_pops += pops;
+                    total_congested += congested;
+                });
+            }
+            std::this_thread::sleep_for(duration);
+            stop = true;
+            for (auto& t : threads) t.join();
+
+            auto secs = std::chrono::duration<double>(duration).count();
+            std::cout << std::setw(12) << std::left << backend << " "
+                      << std::setw(10) << nthreads << " "
+                      << std::setw(15) << total_pops / secs << " "
+                      << total_congested / secs << std::endl;
+        }
+    }
+}
@@ -3,6 +3,9 @@
 #include <JANA/JApplication.h>
 #include <JANA/Utils/JCpuInfo.h>
 #include <JANA/Engine/JArrowProcessingController.h>
+#include <JANA/Engine/JTopologyBuilder.h>
+
+#include <chrono>
 
 #include "ScaleTests.h"
 
@@ -62,6 +65,61 @@ TEST_CASE("ScaleNWorkerUpdate") {
     REQUIRE(threads == 8);
 }
 
+TEST_CASE("ScaleIncremental") {
+    JApplication app;
+    app.SetTicker(false);
+    app.Add(new scaletest::DummySource("DummySource", &app));
+    app.Add(new scaletest::DummyProcessor);
+    app.SetParameterValue("nthreads", 4);
+    app.Run(false);
+    auto japc = app.GetService<JArrowProcessingController>();
+
+    auto check_workers = [&](size_t nthreads) {
+        auto perf = japc->measure_internal_performance();
+        REQUIRE(perf->thread_count == nthreads);
+        REQUIRE(perf->workers.size() == nthreads);
+        for (size_t i=0; i<nthreads; ++i) {
+            // Running workers are always ids [0, nthreads), so each keeps the cpu the mapping gave it
+            REQUIRE(perf->workers[i].worker_id == (int) i);
+        }
+        // Scaling must not have paused the topology
+        REQUIRE(!japc->is_stopped());
+        REQUIRE(!japc->is_finished());
+    };
+
+    check_workers(4);
+    app.Scale(2);
+    check_workers(2);
+    app.Scale(6);
+    check_workers(6);
+    app.Scale(3);
+    check_workers(3);
+    app.Scale(3);
+    check_workers(3);
+}
+
+TEST_CASE("ScaleRetiresParkedWorkersPromptly") {
+    JApplication app;
+    app.SetTicker(false);
+    app.Add(new scaletest::SlowSource);
+    app.Add(new scaletest::DummyProcessor);
+    app.SetParameterValue("nthreads", 4);
+    app.SetParameterValue("jana:backoff_strategy", "park");
+    app.Initialize();
+    for (auto arrow : app.GetService<JTopologyBuilder>()->get()->arrows) {
+        // Retiring must not have to wait for a parked worker's next checkin
+        arrow->set_checkin_time(std::chrono::seconds(10));
+    }
+    app.Run(false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    auto start = std::chrono::steady_clock::now();
+    app.Scale(1);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    REQUIRE(elapsed < std::chrono::seconds(2));
+    REQUIRE(app.GetService<JArrowProcessingController>()->measure_internal_performance()->thread_count == 1);
+}
+
 TEST_CASE("ScaleThroughputImprovement", "[.][performance]") {
 
     auto parms = new JParameterManager;
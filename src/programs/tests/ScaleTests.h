@@ -20,6 +20,16 @@ struct DummySource : public JEventSource {
     }
 };
 
+struct SlowSource : public JEventSource {
+
+    SlowSource() : JEventSource("SlowSource") {}
+
+    void GetEvent(std::shared_ptr<JEvent>) override {
+        // Leaves the processor arrow's workers nothing to do most of the time, so they park
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+};
+
 struct DummyProcessor : public JEventProcessor {
 
     void Process(const std::shared_ptr<const JEvent> &) override {
@@ -6,11 +6,25 @@
 #include "catch.hpp"
 
 #include <JANA/Engine/JScheduler.h>
+#include <JANA/Engine/JScalableScheduler.h>
 #include <TestTopologyComponents.h>
 #include <JANA/Engine/JArrowTopology.h>
 
+#include <iomanip>
+#include <thread>
+
+std::unique_ptr<JScheduler> make_scheduler(const std::string& scheduler_type, std::shared_ptr<JArrowTopology> topology) {
+    if (scheduler_type == "scalable") {
+        return std::unique_ptr<JScheduler>(new JScalableScheduler(topology));
+    }
+    return std::unique_ptr<JScheduler>(new JScheduler(topology));
+}
+
 TEST_CASE("SchedulerTests") {
 
+    // Both scheduler implementations must give the same answers
+    auto scheduler_type = GENERATE(as<std::string>{}, "locking", "scalable");
+
     RandIntSource source;
     MultByTwoProcessor p1;
     SubOneProcessor p2;
@@ -49,12 +63,12 @@ TEST_CASE("SchedulerTests") {
 
         auto logger = JLogger(JLogger::Level::OFF);
 
-        JScheduler scheduler(topology);
+        auto scheduler = make_scheduler(scheduler_type, topology);
 
         last_result = JArrowMetrics::Status::ComeBackLater;
         assignment = nullptr;
         do {
-            assignment = scheduler.next_assignment(0, assignment, last_result);
+            assignment = scheduler->next_assignment(0, assignment, last_result);
             if (assignment != nullptr) {
                 JArrowMetrics metrics;
                 assignment->execute(metrics, 0);
@@ -71,20 +85,20 @@ TEST_CASE("SchedulerTests") {
     SECTION("When run sequentially, topology finished => RRS returns nullptr") {
 
         auto logger = JLogger(JLogger::Level::OFF);
-        JScheduler scheduler(topology);
+        auto scheduler = make_scheduler(scheduler_type, topology);
         last_result = JArrowMetrics::Status::ComeBackLater;
         assignment = nullptr;
 
         for (int i=0; i<80; ++i) {
             // 20 events in source which need to pass through 4 arrows
 
-            assignment = scheduler.next_assignment(0, assignment, last_result);
+            assignment = scheduler->next_assignment(0, assignment, last_result);
             REQUIRE(assignment != nullptr);
             JArrowMetrics metrics;
             assignment->execute(metrics, 0);
             last_result = metrics.get_last_status();
         }
-        assignment = scheduler.next_assignment(0, assignment, last_result);
+        assignment = scheduler->next_assignment(0, assignment, last_result);
         REQUIRE(assignment == nullptr);
     }
 }
@@ -213,3 +227,213 @@ TEST_CASE("SchedulerRoundRobinBehaviorTests") {
 }
 
 
+TEST_CASE("SchedulerTests: Backlog policy") {
+
+    auto scheduler_type = GENERATE(as<std::string>{}, "locking", "scalable");
+
+    RandIntSource source;
+    MultByTwoProcessor p1;
+    SubOneProcessor p2;
+    SumSink<double> sink;
+
+    auto topology = std::make_shared<JArrowTopology>();
+
+    auto q1 = new JMailbox<int>();
+    auto q2 = new JMailbox<double>();
+    auto q3 = new JMailbox<double>();
+
+    auto emit_rand_ints = new SourceArrow<int>("emit_rand_ints", source, q1);
+    auto multiply_by_two = new MapArrow<int,double>("multiply_by_two", p1, q1, q2);
+    auto subtract_one = new MapArrow<double,double>("subtract_one", p2, q2, q3);
+    auto sum_everything = new SinkArrow<double>("sum_everything", sink, q3);
+
+    emit_rand_ints->attach(multiply_by_two);
+    multiply_by_two->attach(subtract_one);
+    subtract_one->attach(sum_everything);
+
+    topology->sources.push_back(emit_rand_ints);
+    topology->arrows.push_back(emit_rand_ints);
+    topology->arrows.push_back(multiply_by_two);
+    topology->arrows.push_back(subtract_one);
+    topology->arrows.push_back(sum_everything);
+    topology->sinks.push_back(sum_everything);
+
+    topology->run(1);
+    auto scheduler = make_scheduler(scheduler_type, topology);
+
+    // The source is cheap and has already filled its output queue to 90% of the threshold
+    std::vector<int> ints(90, 7);
+    q1->push(ints);
+
+    SECTION("RoundRobin keeps offering the source") {
+        auto assignment = scheduler->next_assignment(0, nullptr, JArrowMetrics::Status::ComeBackLater);
+        REQUIRE(assignment == emit_rand_ints);
+    }
+
+    SECTION("Backlog offers the stage with the fullest input queue instead") {
+        scheduler->set_policy(JScheduler::Policy::Backlog);
+        auto assignment = scheduler->next_assignment(0, nullptr, JArrowMetrics::Status::ComeBackLater);
+        REQUIRE(assignment == multiply_by_two);
+    }
+
+    SECTION("Backlog drains downstream stages before refilling them") {
+        std::vector<double> doubles(90, 14.0);
+        q2->push(doubles);
+        scheduler->set_policy(JScheduler::Policy::Backlog);
+        auto assignment = scheduler->next_assignment(0, nullptr, JArrowMetrics::Status::ComeBackLater);
+        REQUIRE(assignment == subtract_one);
+    }
+
+    SECTION("Backlog prefers the slower of two equally backlogged arrows") {
+        // multiply_by_two and sum_everything both have a 90% full input queue and an empty output queue
+        std::vector<double> doubles(90, 13.0);
+        q3->push(doubles);
+
+        JArrowMetrics fast, slow;
+        fast.clear();
+        slow.clear();
+        fast.update(JArrowMetrics::Status::KeepGoing, 1, 1, std::chrono::microseconds(1), std::chrono::microseconds(0));
+        slow.update(JArrowMetrics::Status::KeepGoing, 1, 1, std::chrono::milliseconds(1), std::chrono::microseconds(0));
+        multiply_by_two->hand_in_metrics(0, fast);
+        sum_everything->hand_in_metrics(0, slow);
+
+        scheduler->set_policy(JScheduler::Policy::Backlog);
+        auto assignment = scheduler->next_assignment(0, nullptr, JArrowMetrics::Status::ComeBackLater);
+        REQUIRE(assignment == sum_everything);
+    }
+}
+
+
+TEST_CASE("SchedulerTests: Concurrent workers drain the topology") {
+
+    auto scheduler_type = GENERATE(as<std::string>{}, "locking", "scalable");
+    auto policy = GENERATE(JScheduler::Policy::RoundRobin, JScheduler::Policy::Backlog);
+
+    RandIntSource source;
+    source.emit_limit = 1000;
+    MultByTwoProcessor p1;
+    SubOneProcessor p2;
+    SumSink<double> sink;
+
+    auto topology = std::make_shared<JArrowTopology>();
+
+    auto q1 = new JMailbox<int>();
+    auto q2 = new JMailbox<double>();
+    auto q3 = new JMailbox<double>();
+
+    auto emit_rand_ints = new SourceArrow<int>("emit_rand_ints", source, q1);
+    auto multiply_by_two = new MapArrow<int,double>("multiply_by_two", p1, q1, q2);
+    auto subtract_one = new MapArrow<double,double>("subtract_one", p2, q2, q3);
+    auto sum_everything = new SinkArrow<double>("sum_everything", sink, q3);
+
+    emit_rand_ints->attach(multiply_by_two);
+    multiply_by_two->attach(subtract_one);
+    subtract_one->attach(sum_everything);
+
+    topology->sources.push_back(emit_rand_ints);
+    topology->arrows.push_back(emit_rand_ints);
+    topology->arrows.push_back(multiply_by_two);
+    topology->arrows.push_back(subtract_one);
+    topology->arrows.push_back(sum_everything);
+    topology->sinks.push_back(sum_everything);
+
+    for (auto arrow : topology->arrows) {
+        // Otherwise the topology can't tell when it is finished, and pauses as soon as any worker goes idle
+        arrow->set_running_arrows(&topology->running_arrow_count);
+    }
+    emit_rand_ints->set_chunksize(1);
+    topology->run(8);
+
+    auto scheduler = make_scheduler(scheduler_type, topology);
+    scheduler->set_policy(policy);
+
+    std::vector<std::thread> threads;
+    for (uint32_t worker_id=0; worker_id<8; ++worker_id) {
+        threads.emplace_back([&, worker_id]() {
+            JArrow* assignment = nullptr;
+            auto last_result = JArrowMetrics::Status::ComeBackLater;
+            while (topology->m_current_status == JArrowTopology::Status::Running) {
+                assignment = scheduler->next_assignment(worker_id, assignment, last_result);
+                if (assignment != nullptr) {
+                    JArrowMetrics metrics;
+                    assignment->execute(metrics, 0);
+                    last_result = metrics.get_last_status();
+                }
+            }
+            scheduler->last_assignment(worker_id, assignment, last_result);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    // Every event makes it to the sink exactly once, and no arrow is left holding a thread
+    REQUIRE(sink.sum == 1000 * (7 * 2.0 - 1));
+    for (auto arrow : topology->arrows) {
+        REQUIRE(arrow->get_thread_count() == 0);
+        REQUIRE(arrow->get_status() != JArrow::Status::Running);
+    }
+}
+
+
+TEST_CASE("SchedulerTests: Checkin throughput benchmark", "[.][performance]") {
+
+    // Measures how many checkins per second the schedulers sustain when workers do no actual work,
+    // which isolates the scheduler's own synchronization overhead. Run with `janatests "[performance]"`.
+
+    RandIntSource source;
+    MultByTwoProcessor p1;
+    SubOneProcessor p2;
+    SumSink<double> sink;
+
+    auto topology = std::make_shared<JArrowTopology>();
+
+    auto q1 = new JMailbox<int>();
+    auto q2 = new JMailbox<double>();
+    auto q3 = new JMailbox<double>();
+
+    auto emit_rand_ints = new SourceArrow<int>("emit_rand_ints", source, q1);
+    auto multiply_by_two = new MapArrow<int,double>("multiply_by_two", p1, q1, q2);
+    auto subtract_one = new MapArrow<double,double>("subtract_one", p2, q2, q3);
+    auto sum_everything = new SinkArrow<double>("sum_everything", sink, q3);
+
+    emit_rand_ints->attach(multiply_by_two);
+    multiply_by_two->attach(subtract_one);
+    subtract_one->attach(sum_everything);
+
+    topology->sources.push_back(emit_rand_ints);
+    topology->arrows.push_back(emit_rand_ints);
+    topology->arrows.push_back(multiply_by_two);
+    topology->arrows.push_back(subtract_one);
+    topology->arrows.push_back(sum_everything);
+    topology->sinks.push_back(sum_everything);
+
+    // The source never gets executed, so it stays running and every arrow remains schedulable
+    topology->run(64);
+
+    std::cout << std::setw(10) << "Scheduler" << std::setw(10) << "Threads" << std::setw(20) << "Checkins/s" << std::endl;
+    for (std::string scheduler_type : {"locking", "scalable"}) {
+        for (uint32_t nthreads : {1, 2, 4, 8, 16, 32, 64}) {
+            auto scheduler = make_scheduler(scheduler_type, topology);
+            std::atomic_bool done {false};
+            std::atomic<size_t> total_checkins {0};
+            std::vector<std::thread> threads;
+            for (uint32_t worker_id=0; worker_id<nthreads; ++worker_id) {
+                threads.emplace_back([&, worker_id]() {
+                    JArrow* assignment = nullptr;
+                    size_t checkins = 0;
+                    while (!done) {
+                        assignment = scheduler->next_assignment(worker_id, assignment, JArrowMetrics::Status::ComeBackLater);
+                        checkins++;
+                    }
+                    scheduler->last_assignment(worker_id, assignment, JArrowMetrics::Status::ComeBackLater);
+                    total_checkins += checkins;
+                });
+            }
+            auto duration = std::chrono::milliseconds(500);
+            std::this_thread::sleep_for(duration);
+            done = true;
+            for (auto& t : threads) t.join();
+            double rate = total_checkins / std::chrono::duration<double>(duration).count();
+            std::cout << std::setw(10) << scheduler_type << std::setw(10) << nthreads << std::setw(20) << std::fixed << std::setprecision(0) << rate << std::endl;
+        }
+    }
+}